@@ -1,8 +1,12 @@
 {
+  'variables': {
+    # the Windows SDK to build with, connection parameter presets need 10.0.22000.0 or later
+    'winsdk_version%': "<!(node -p \"process.env.NOBLE_WINRT_SDK_VERSION || '10.0.15063.0'\")",
+  },
   'targets': [
     {
       'target_name': 'noble_winrt',
-      'sources': [ 'src/noble_winrt.cc', 'src/napi_winrt.cc', 'src/peripheral_winrt.cc', 'src/radio_watcher.cc', 'src/notify_map.cc', 'src/ble_manager.cc', 'src/winrt_cpp.cc', 'src/winrt_guid.cc', 'src/callbacks.cc' ],
+      'sources': [ 'src/noble_winrt.cc', 'src/napi_winrt.cc', 'src/peripheral_winrt.cc', 'src/connection_parameters_winrt.cc', 'src/attribute_table.cc', 'src/gatt_scheduler.cc', 'src/stream_writer.cc', 'src/write_segmentation.cc', 'src/deadline_timer.cc', 'src/retry_policy.cc', 'src/radio_watcher.cc', 'src/connect_queue.cc', 'src/reconnect_tracker.cc', 'src/link_health.cc', 'src/notify_subscribers.cc', 'src/notify_ring.cc', 'src/notify_stats.cc', 'src/payload_decoder.cc', 'src/notify_map.cc', 'src/ble_manager.cc', 'src/winrt_cpp.cc', 'src/winrt_guid.cc', 'src/winrt_buffer.cc', 'src/callbacks.cc' ],
       'include_dirs': ["<!@(node -p \"require('node-addon-api').include\")", "<!@(node -p \"require('napi-thread-safe-callback').include\")"],
       'dependencies': ["<!(node -p \"require('node-addon-api').gyp\")"],
       'cflags!': [ '-fno-exceptions' ],
@@ -13,7 +17,7 @@
           'AdditionalOptions': ['/await', '/std:c++latest'],
         },
       },
-      'msvs_target_platform_version':'10.0.15063.0',
+      'msvs_target_platform_version':'<(winsdk_version)',
       'msvs_target_platform_minversion':'10.0.15063.0',
       'conditions': [
         ['OS=="win"', { 'defines': [ '_HAS_EXCEPTIONS=1' ] }]
@@ -13,6 +13,7 @@ if (os.platform() === 'win32') {
 		const Noble = require('noble/lib/noble');
 		const winrtBindings = require('./lib/binding.js');
 		var nobleInstance = new Noble(winrtBindings);
+		winrtBindings.routeOperationErrors(nobleInstance);
 		module.exports = nobleInstance;
 	}
 } else {
@@ -5,4 +5,44 @@ const NobleWinrt =  require('bindings')('noble_winrt').NobleWinrt;
 
 util.inherits(NobleWinrt, events.EventEmitter);
 
+// Finds the noble object a GATT operation event belongs to from its arguments.
+const OPERATION_TARGETS = {
+  servicesDiscover: (noble, d) => noble._peripherals[d],
+  includedServicesDiscover: (noble, d, s) => (noble._services[d] || {})[s],
+  characteristicsDiscover: (noble, d, s) => (noble._services[d] || {})[s],
+  read: (noble, d, s, c) => ((noble._characteristics[d] || {})[s] || {})[c],
+  write: (noble, d, s, c) => ((noble._characteristics[d] || {})[s] || {})[c],
+  notify: (noble, d, s, c) => ((noble._characteristics[d] || {})[s] || {})[c],
+  descriptorsDiscover: (noble, d, s, c) => ((noble._characteristics[d] || {})[s] || {})[c],
+  valueRead: (noble, d, s, c, u) => (((noble._descriptors[d] || {})[s] || {})[c] || {})[u],
+  valueWrite: (noble, d, s, c, u) => (((noble._descriptors[d] || {})[s] || {})[c] || {})[u],
+  handleRead: (noble, d) => noble._peripherals[d],
+  handleWrite: (noble, d) => noble._peripherals[d],
+};
+
+// Noble passes no error on for these events and would report a failed operation as successful,
+// so a failure is emitted as operationError(event, args, error) instead of the regular event.
+NobleWinrt.prototype.emit = function(event) {
+  const args = Array.prototype.slice.call(arguments, 1);
+  const error = args[args.length - 1];
+  if (OPERATION_TARGETS[event] && error instanceof Error) {
+    return events.EventEmitter.prototype.emit.call(this, 'operationError', event,
+                                                   args.slice(0, -1), error);
+  }
+  return events.EventEmitter.prototype.emit.apply(this, arguments);
+};
+
+// Emits the errors of failed operations as 'error' on their service, characteristic, descriptor
+// or peripheral, or as 'warning' on noble if that object has no error listener.
+NobleWinrt.prototype.routeOperationErrors = function(noble) {
+  this.on('operationError', (event, args, error) => {
+    const target = OPERATION_TARGETS[event].apply(null, [noble].concat(args));
+    if (target && target.listenerCount('error') > 0) {
+      target.emit('error', error, event);
+    } else {
+      noble.emit('warning', event + ' failed on ' + args[0] + ': ' + error.message);
+    }
+  });
+};
+
 module.exports = new NobleWinrt();
@@ -0,0 +1,146 @@
+#include "attribute_table.h"
+
+bool AttributeKey::operator==(const AttributeKey& other) const
+{
+    return (service == other.service && characteristic == other.characteristic &&
+            descriptor == other.descriptor);
+}
+
+std::size_t AttributeKeyHash::operator()(const AttributeKey& k) const
+{
+    std::hash<winrt::guid> hash;
+    std::size_t seed = hash(k.service);
+    seed ^= hash(k.characteristic) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    seed ^= hash(k.descriptor) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+AttributeTable::AttributeTable(AttributeTable&& other)
+    : mAttributes(std::move(other.mAttributes)), mHandles(std::move(other.mHandles)),
+      mValueHandles(std::move(other.mValueHandles)), mKeys(std::move(other.mKeys))
+{
+}
+
+void AttributeTable::Add(const winrt::guid& serviceUuid, GattDeviceService service)
+{
+    Attribute attribute = { AttributeType::Service, service.AttributeHandle(), { serviceUuid } };
+    attribute.service = service;
+    Insert(attribute);
+}
+
+void AttributeTable::Add(const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid,
+                         GattCharacteristic characteristic)
+{
+    Attribute attribute = { AttributeType::Characteristic, characteristic.AttributeHandle(),
+                            { serviceUuid, characteristicUuid } };
+    attribute.characteristic = characteristic;
+    Insert(attribute);
+}
+
+void AttributeTable::Add(const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid,
+                         const winrt::guid& descriptorUuid, GattDescriptor descriptor)
+{
+    Attribute attribute = { AttributeType::Descriptor, descriptor.AttributeHandle(),
+                            { serviceUuid, characteristicUuid, descriptorUuid } };
+    attribute.descriptor = descriptor;
+    Insert(attribute);
+}
+
+void AttributeTable::Insert(Attribute attribute)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    int32_t slot;
+    if (attribute.handle < mHandles.size() && mHandles[attribute.handle] >= 0)
+    {
+        // rediscovered attribute, replace the object in place
+        slot = mHandles[attribute.handle];
+        auto& previous = mAttributes[slot];
+        auto stale = mKeys.find(previous.key);
+        if (stale != mKeys.end() && stale->second == slot)
+        {
+            // the handle may belong to a different attribute now
+            mKeys.erase(stale);
+        }
+        uint32_t valueHandle = previous.handle + 1;
+        if (previous.type == AttributeType::Characteristic &&
+            valueHandle < mValueHandles.size() && mValueHandles[valueHandle] == slot)
+        {
+            mValueHandles[valueHandle] = -1;
+        }
+        previous = attribute;
+    }
+    else
+    {
+        slot = static_cast<int32_t>(mAttributes.size());
+        mAttributes.push_back(attribute);
+        IndexHandle(mHandles, attribute.handle, slot);
+    }
+    if (attribute.type == AttributeType::Characteristic && attribute.handle < 0xffff)
+    {
+        // the characteristic value declaration always follows the characteristic declaration, it
+        // is kept apart so that it never replaces an attribute discovered at that handle
+        IndexHandle(mValueHandles, attribute.handle + 1, slot);
+    }
+    IndexKey(attribute.key, slot);
+}
+
+void AttributeTable::IndexHandle(std::vector<int32_t>& index, uint16_t handle, int32_t slot)
+{
+    if (handle >= index.size())
+    {
+        index.resize(handle + 1, -1);
+    }
+    index[handle] = slot;
+}
+
+void AttributeTable::IndexKey(const AttributeKey& key, int32_t slot)
+{
+    auto it = mKeys.find(key);
+    // with multiple instances of the same uuid the first one is used for uuid lookups. A key that
+    // is rediscovered at another handle takes over if it moved down. If it moved up, a discovery
+    // also rediscovers whatever took its old handle, which drops the old mapping above.
+    if (it == mKeys.end() || mAttributes[slot].handle <= mAttributes[it->second].handle)
+    {
+        mKeys.insert_or_assign(key, slot);
+    }
+}
+
+std::optional<Attribute> AttributeTable::Find(uint16_t handle) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (handle < mHandles.size() && mHandles[handle] >= 0)
+    {
+        return mAttributes[mHandles[handle]];
+    }
+    if (handle < mValueHandles.size() && mValueHandles[handle] >= 0)
+    {
+        return mAttributes[mValueHandles[handle]];
+    }
+    return std::nullopt;
+}
+
+std::optional<Attribute> AttributeTable::Find(const AttributeKey& key) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mKeys.find(key);
+    if (it != mKeys.end())
+    {
+        return mAttributes[it->second];
+    }
+    return std::nullopt;
+}
+
+std::vector<Attribute> AttributeTable::Attributes() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mAttributes;
+}
+
+void AttributeTable::Clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mAttributes.clear();
+    mHandles.clear();
+    mValueHandles.clear();
+    mKeys.clear();
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <winrt/Windows.Devices.Bluetooth.GenericAttributeProfile.h>
+
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "winrt_guid.h"
+
+using winrt::Windows::Devices::Bluetooth::GenericAttributeProfile::GattCharacteristic;
+using winrt::Windows::Devices::Bluetooth::GenericAttributeProfile::GattDescriptor;
+using winrt::Windows::Devices::Bluetooth::GenericAttributeProfile::GattDeviceService;
+
+struct AttributeKey
+{
+    winrt::guid service;
+    winrt::guid characteristic;
+    winrt::guid descriptor;
+
+    bool operator==(const AttributeKey& other) const;
+};
+
+struct AttributeKeyHash
+{
+    std::size_t operator()(const AttributeKey& k) const;
+};
+
+enum class AttributeType
+{
+    Service,
+    Characteristic,
+    Descriptor,
+};
+
+struct Attribute
+{
+    AttributeType type;
+    uint16_t handle;
+    AttributeKey key;
+    GattDeviceService service = nullptr;
+    GattCharacteristic characteristic = nullptr;
+    GattDescriptor descriptor = nullptr;
+};
+
+// Flat table of the known attributes of a peripheral, indexed by ATT handle and by uuids. Lookups
+// complete on WinRT threads while the table is read on the JS, scheduler and timer threads, so
+// all access is locked and attributes are returned by value.
+class AttributeTable
+{
+public:
+    AttributeTable() = default;
+    // a peripheral is only moved into the device map before any lookup is started
+    AttributeTable(AttributeTable&& other);
+
+    void Add(const winrt::guid& serviceUuid, GattDeviceService service);
+    void Add(const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid,
+             GattCharacteristic characteristic);
+    void Add(const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid,
+             const winrt::guid& descriptorUuid, GattDescriptor descriptor);
+
+    std::optional<Attribute> Find(uint16_t handle) const;
+    std::optional<Attribute> Find(const AttributeKey& key) const;
+
+    std::vector<Attribute> Attributes() const;
+    void Clear();
+
+private:
+    void Insert(Attribute attribute);
+    static void IndexHandle(std::vector<int32_t>& index, uint16_t handle, int32_t slot);
+    void IndexKey(const AttributeKey& key, int32_t slot);
+
+    mutable std::mutex mMutex;
+    std::vector<Attribute> mAttributes;
+    // handle -> slot in mAttributes, -1 for unknown handles
+    std::vector<int32_t> mHandles;
+    // value handle of a characteristic -> slot of the characteristic, only used for handles that
+    // aren't known themselves
+    std::vector<int32_t> mValueHandles;
+    std::unordered_map<AttributeKey, int32_t, AttributeKeyHash> mKeys;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "callable.h"
+
+// Collects the results of operations that complete in any order and on any thread. `onDone` is
+// called once with all results, in the order of their indices, after the last one has been set.
+template <typename T> class Batch
+{
+public:
+    using OnDone = Callable<void(std::vector<T>)>;
+
+    static std::shared_ptr<Batch> Create(size_t count, OnDone onDone)
+    {
+        return std::shared_ptr<Batch>(new Batch(count, std::move(onDone)));
+    }
+
+    void Set(size_t index, T value)
+    {
+        std::vector<T> results;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mResults[index] = std::move(value);
+            if (--mRemaining > 0)
+            {
+                return;
+            }
+            results = std::move(mResults);
+        }
+        mOnDone(std::move(results));
+    }
+
+private:
+    Batch(size_t count, OnDone onDone)
+        : mResults(count), mRemaining(count), mOnDone(std::move(onDone))
+    {
+    }
+
+    std::mutex mMutex;
+    std::vector<T> mResults;
+    size_t mRemaining;
+    OnDone mOnDone;
+};
@@ -6,71 +6,268 @@
 //
 
 #include "ble_manager.h"
+#include "connection_parameters_winrt.h"
+#include "stream_writer.h"
+#include "write_segmentation.h"
+#include "winrt_buffer.h"
 #include "winrt_cpp.h"
 
-#include <winrt/Windows.Storage.Streams.h>
+#include <atomic>
+
 using winrt::Windows::Devices::Bluetooth::BluetoothCacheMode;
 using winrt::Windows::Devices::Bluetooth::BluetoothConnectionStatus;
-using winrt::Windows::Storage::Streams::DataReader;
-using winrt::Windows::Storage::Streams::DataWriter;
 
 template <typename T> auto inFilter(std::vector<T> filter, T object)
 {
     return filter.empty() || std::find(filter.begin(), filter.end(), object) != filter.end();
 }
 
-template <typename O, typename M, class... Types> auto bind2(O* object, M method, Types&... args)
+CachePolicy callPolicy(CachePolicy policy, std::optional<CacheMode> cacheMode)
+{
+    if (cacheMode)
+    {
+        policy.mode = *cacheMode;
+    }
+    return policy;
+}
+
+BluetoothCacheMode readCacheMode(const CachePolicy& policy)
+{
+    return policy.mode == CacheMode::Cached ? BluetoothCacheMode::Cached
+                                            : BluetoothCacheMode::Uncached;
+}
+
+// the error of a GATT result, no error if the communication succeeded
+template <typename R> OperationError resultError(const R& result)
+{
+    if (!result)
+    {
+        return { OperationStatus::Failed, "result is null" };
+    }
+    auto status = result.Status();
+    if (status == GattCommunicationStatus::Success)
+    {
+        return {};
+    }
+    std::string message = "communication status " + std::to_string(static_cast<int>(status));
+    auto protocolError = result.ProtocolError();
+    if (protocolError)
+    {
+        message += ", protocol error " + std::to_string(protocolError.Value());
+    }
+    return { static_cast<OperationStatus>(status), message };
+}
+
+// the error of a completed async operation, no error if it succeeded
+template <typename T>
+OperationError asyncError(const IAsyncOperation<T>& asyncOp, AsyncStatus status)
+{
+    switch (status)
+    {
+    case AsyncStatus::Completed:
+        return resultError(asyncOp.GetResults());
+    case AsyncStatus::Canceled:
+        return { OperationStatus::Cancelled, "operation cancelled" };
+    default:
+        return { OperationStatus::Failed,
+                 "operation failed with error " + std::to_string(asyncOp.ErrorCode().value) };
+    }
+}
+
+// the error of a completed async action, an action has no result that could report one
+OperationError asyncError(const IAsyncAction& asyncOp, AsyncStatus status)
+{
+    switch (status)
+    {
+    case AsyncStatus::Completed:
+        return {};
+    case AsyncStatus::Canceled:
+        return { OperationStatus::Cancelled, "operation cancelled" };
+    default:
+        return { OperationStatus::Failed,
+                 "operation failed with error " + std::to_string(asyncOp.ErrorCode().value) };
+    }
+}
+
+// the value of a completed read operation, shared with the buffer of the result
+OperationError readResult(IAsyncOperation<GattReadResult>& asyncOp, AsyncStatus status,
+                          Payload& data)
+{
+    auto error = asyncError(asyncOp, status);
+    if (error)
+    {
+        return error;
+    }
+    auto& value = asyncOp.GetResults().Value();
+    if (!value)
+    {
+        return { OperationStatus::Failed, "value is null" };
+    }
+    data = bufferPayload(value);
+    return {};
+}
+
+std::vector<BatchItemResult> failAll(const std::vector<AttributeKey>& keys,
+                                     const OperationError& error)
+{
+    std::vector<BatchItemResult> results;
+    for (auto& key : keys)
+    {
+        results.push_back({ toStr(key.service), toStr(key.characteristic), {}, error });
+    }
+    return results;
+}
+
+// Runs the completion handler of an operation unless it has already been settled by its deadline
+// or a cancellation, frees the slot of the operation in the scheduler once the handler has run.
+template <typename H>
+auto settled(std::shared_ptr<TimedOperation> operation, GattScheduler::Done done, H handler)
+{
+    return [operation, done, handler](auto&& asyncOp, auto&& status) {
+        if (!operation->Settle())
+        {
+            return;
+        }
+        operation->Completed(asyncError(asyncOp, status));
+        try
+        {
+            handler(asyncOp, status);
+        }
+        catch (...)
+        {
+            done();
+            throw;
+        }
+        done();
+    };
+}
+
+// Starts the async operation unless the operation has already been settled and makes it
+// cancellable by the deadline. If it can't be started, e.g. because the device object has been
+// closed, the operation fails and gives up its slot.
+template <typename S, typename H>
+void track(std::shared_ptr<TimedOperation> operation, GattScheduler::Done done, S start,
+           H handler)
+{
+    if (operation->IsSettled())
+    {
+        return;
+    }
+    try
+    {
+        auto asyncOp = start();
+        operation->SetCancel([asyncOp]() { asyncOp.Cancel(); });
+        asyncOp.Completed(settled(operation, done, handler));
+    }
+    catch (const winrt::hresult_error& e)
+    {
+        operation->Fail({ OperationStatus::Failed, winrt::to_string(e.message()) });
+    }
+}
+
+// Like track but starts the async operation again after a backoff if it failed with a status
+// that the retry policy of its class considers transient. The operation keeps its slot in the
+// scheduler and its deadline across all attempts.
+template <typename S, typename H>
+void track(std::shared_ptr<TimedOperation> operation, GattScheduler::Done done, RetryTarget retry,
+           S start, H handler, int attempt = 1)
+{
+    if (operation->IsSettled())
+    {
+        return;
+    }
+    try
+    {
+        auto asyncOp = start();
+        operation->SetCancel([asyncOp]() { asyncOp.Cancel(); });
+        asyncOp.Completed([=](auto&& asyncOp, auto&& status) {
+            if (operation->IsSettled())
+            {
+                return;
+            }
+            auto error = asyncError(asyncOp, status);
+            auto delay = retry.policies.Next(retry.operationClass, attempt, error.status);
+            if (!delay)
+            {
+                settled(operation, done, handler)(asyncOp, status);
+                return;
+            }
+            retry.timer.After(*delay, [=]() {
+                track(operation, done, retry, start, handler, attempt + 1);
+            });
+        });
+    }
+    catch (const winrt::hresult_error& e)
+    {
+        operation->Fail({ OperationStatus::Failed, winrt::to_string(e.message()) });
+    }
+}
+
+// whether a notify request holds the turn to write the descriptor and has handed it on
+struct WriteTurnState
+{
+    std::atomic<bool> held{ false };
+    std::atomic<bool> ended{ false };
+};
+
+GattClientCharacteristicConfigurationDescriptorValue
+GetDescriptorValue(GattCharacteristicProperties properties)
 {
-    return std::bind(method, object, std::placeholders::_1, std::placeholders::_2, args...);
+    if ((properties & GattCharacteristicProperties::Indicate) ==
+        GattCharacteristicProperties::Indicate)
+    {
+        return GattClientCharacteristicConfigurationDescriptorValue::Indicate;
+    }
+    else
+    {
+        return GattClientCharacteristicConfigurationDescriptorValue::Notify;
+    }
 }
 
+// writes in flight while a value is written in segments without response
+const size_t SEGMENT_WINDOW = 4;
+
+// how often the links of monitored devices are checked
+const std::chrono::milliseconds HEALTH_CHECK_INTERVAL = std::chrono::milliseconds(500);
+
 #define LOGE(message, ...) printf(__FUNCTION__ ": " message "\n", __VA_ARGS__)
 
 #define CHECK_DEVICE()                                     \
-    if (mDeviceMap.find(uuid) == mDeviceMap.end())         \
+    if (!FindPeripheral(uuid))                             \
     {                                                      \
         LOGE("device with id %s not found", uuid.c_str()); \
         return false;                                      \
     }
 
-#define IFDEVICE(_device, _uuid)                     \
-    PeripheralWinrt& peripheral = mDeviceMap[_uuid]; \
-    if (!peripheral.device.has_value())              \
-    {                                                \
-        LOGE("device not connected");                \
-        return false;                                \
-    }                                                \
+// reports the error through `_onFailed` if the device is unknown or not connected
+#define IFCONNECTED(_device, _uuid, _onFailed)                                \
+    PeripheralWinrt* _peripheral = FindPeripheral(_uuid);                     \
+    if (!_peripheral)                                                         \
+    {                                                                         \
+        _onFailed({ OperationStatus::NotFound, "device not found" });         \
+        return false;                                                         \
+    }                                                                         \
+    PeripheralWinrt& peripheral = *_peripheral;                               \
+    if (!peripheral.device.has_value())                                       \
+    {                                                                         \
+        _onFailed({ OperationStatus::NotConnected, "device not connected" }); \
+        return false;                                                         \
+    }                                                                         \
     BluetoothLEDevice& _device = *peripheral.device;
 
-#define CHECK_RESULT(_result)                            \
-    if (!_result)                                        \
-    {                                                    \
-        LOGE("result is null");                          \
-        return;                                          \
-    }                                                    \
-    auto _commStatus = _result.Status();                 \
-    if (_commStatus != GattCommunicationStatus::Success) \
-    {                                                    \
-        LOGE("communication status: %d", _commStatus);   \
-        return;                                          \
-    }
-
-#define FOR(object, vector)       \
-    auto& _vector = vector;       \
-    if (!_vector)                 \
-    {                             \
-        LOGE(#vector " is null"); \
-        return;                   \
-    }                             \
-    else                          \
-        for (auto&& object : _vector)
+#define CHECK_HANDLE(_handle, _onFailed)                            \
+    if (_handle < 0 || _handle > 0xffff)                            \
+    {                                                               \
+        _onFailed({ OperationStatus::NotFound, "invalid handle" }); \
+        return false;                                               \
+    }
 
 BLEManager::BLEManager(const Napi::Value& receiver, const Napi::Function& callback)
+    : mDeadlines([]() { winrt::init_apartment(); })
 {
     mRadioState = AdapterState::Initial;
     mEmit.Wrap(receiver, callback);
-    auto onRadio = std::bind(&BLEManager::OnRadio, this, std::placeholders::_1);
-    mWatcher.Start(onRadio);
+    mWatcher.Start([this](Radio& radio) { OnRadio(radio); });
     mAdvertismentWatcher.ScanningMode(BluetoothLEScanningMode::Active);
     auto onReceived = bind2(this, &BLEManager::OnScanResult);
     mReceivedRevoker = mAdvertismentWatcher.Received(winrt::auto_revoke, onReceived);
@@ -137,17 +334,18 @@ void BLEManager::OnScanResult(BluetoothLEAdvertisementWatcher watcher,
     int16_t rssi = args.RawSignalStrengthInDBm();
     auto advertismentType = args.AdvertisementType();
 
-    if (mDeviceMap.find(uuid) == mDeviceMap.end())
+    PeripheralWinrt* known = FindPeripheral(uuid);
+    if (!known)
     {
         mAdvertismentMap.insert(uuid);
         auto peripheral =
             PeripheralWinrt(bluetoothAddress, advertismentType, rssi, args.Advertisement());
         mEmit.Scan(uuid, rssi, peripheral);
-        mDeviceMap.emplace(std::make_pair(uuid, std::move(peripheral)));
+        AddPeripheral(uuid, std::move(peripheral));
     }
     else
     {
-        PeripheralWinrt& peripheral = mDeviceMap[uuid];
+        PeripheralWinrt& peripheral = *known;
         peripheral.Update(rssi, args.Advertisement(), advertismentType);
         if (mAllowDuplicates || mAdvertismentMap.find(uuid) == mAdvertismentMap.end())
         {
@@ -168,29 +366,56 @@ void BLEManager::OnScanStopped(BluetoothLEAdvertisementWatcher watcher,
     mEmit.ScanState(false);
 }
 
-bool BLEManager::Connect(const std::string& uuid)
+bool BLEManager::Connect(const std::string& id, int priority)
 {
-    if (mDeviceMap.find(uuid) == mDeviceMap.end())
-    {
-        mEmit.Connected(uuid, "device not found");
-        return false;
-    }
-    PeripheralWinrt& peripheral = mDeviceMap[uuid];
-    if (!peripheral.device.has_value())
+    // devices that haven't been scanned are added by their address
+    auto bluetoothAddress = parseBluetoothAddress(id);
+    auto uuid = bluetoothAddress ? formatBluetoothUuid(*bluetoothAddress) : id;
+    PeripheralWinrt* known = FindPeripheral(uuid);
+    if (!known)
     {
-        auto completed = bind2(this, &BLEManager::OnConnected, uuid);
-        BluetoothLEDevice::FromBluetoothAddressAsync(peripheral.bluetoothAddress)
-            .Completed(completed);
+        if (!bluetoothAddress)
+        {
+            mEmit.Connected(uuid, "device not found");
+            return false;
+        }
+        known = &AddPeripheral(uuid, PeripheralWinrt(*bluetoothAddress));
     }
-    else
+    PeripheralWinrt& peripheral = *known;
+    if (peripheral.device.has_value())
     {
         mEmit.Connected(uuid);
+        return true;
     }
+    auto address = peripheral.bluetoothAddress;
+    // a device that is already queued or connecting reports when its attempt has finished
+    mConnects.Enqueue(uuid, priority, [=](auto done) {
+        auto operation =
+            mDeadlines.Start(uuid, GetTimeouts().connect, [=](const OperationError& error) {
+                mEmit.Connected(uuid, "could not connect to device: " + error.message);
+                done(false);
+            });
+        try
+        {
+            auto asyncOp = BluetoothLEDevice::FromBluetoothAddressAsync(address);
+            operation->SetCancel([asyncOp]() { asyncOp.Cancel(); });
+            asyncOp.Completed([=](auto&& asyncOp, auto&& status) {
+                if (operation->Settle())
+                {
+                    done(OnConnected(asyncOp, status, uuid));
+                }
+            });
+        }
+        catch (const winrt::hresult_error& e)
+        {
+            operation->Fail({ OperationStatus::Failed, winrt::to_string(e.message()) });
+        }
+    });
     return true;
 }
 
-void BLEManager::OnConnected(IAsyncOperation<BluetoothLEDevice> asyncOp, AsyncStatus& status,
-                             const std::string uuid)
+bool BLEManager::OnConnected(IAsyncOperation<BluetoothLEDevice> asyncOp, AsyncStatus status,
+                             const std::string& uuid)
 {
     if (status == AsyncStatus::Completed)
     {
@@ -201,10 +426,22 @@ void BLEManager::OnConnected(IAsyncOperation<BluetoothLEDevice> asyncOp, AsyncSt
             auto onChanged = bind2(this, &BLEManager::OnConnectionStatusChanged);
             auto token = device.ConnectionStatusChanged(onChanged);
             auto uuid = formatBluetoothUuid(device.BluetoothAddress());
-            PeripheralWinrt& peripheral = mDeviceMap[uuid];
+            PeripheralWinrt& peripheral = Peripheral(uuid);
             peripheral.device = device;
             peripheral.connectionToken = token;
+            peripheral.SetLookupPolicy(mCachePolicy.lookup);
             mEmit.Connected(uuid);
+            if (peripheral.connectionPreset)
+            {
+                ApplyConnectionMode(uuid, peripheral);
+            }
+            if (peripheral.health)
+            {
+                WatchHealth(uuid, *peripheral.health);
+            }
+            auto onSession = bind2(this, &BLEManager::OnSession, uuid);
+            GattSession::FromDeviceIdAsync(device.BluetoothDeviceId()).Completed(onSession);
+            return true;
         }
         else
         {
@@ -215,14 +452,59 @@ void BLEManager::OnConnected(IAsyncOperation<BluetoothLEDevice> asyncOp, AsyncSt
     {
         mEmit.Connected(uuid, "could not connect to device");
     }
+    return false;
+}
+
+void BLEManager::OnSession(IAsyncOperation<GattSession> asyncOp, AsyncStatus status,
+                           const std::string& uuid)
+{
+    if (status == AsyncStatus::Completed)
+    {
+        GattSession session = asyncOp.GetResults();
+        PeripheralWinrt& peripheral = Peripheral(uuid);
+        // the device could have been disconnected in the meantime
+        if (!session || !peripheral.device.has_value())
+        {
+            LOGE("no session for device %s", uuid.c_str());
+            return;
+        }
+        auto onChanged = bind2(this, &BLEManager::OnMtuChanged, uuid);
+        peripheral.mtuToken = session.MaxPduSizeChanged(onChanged);
+        peripheral.session = session;
+        peripheral.mtu = session.MaxPduSize();
+        mEmit.Mtu(uuid, peripheral.mtu);
+    }
+    else
+    {
+        LOGE("status: %d", status);
+    }
+}
+
+void BLEManager::OnMtuChanged(GattSession session,
+                              winrt::Windows::Foundation::IInspectable inspectable,
+                              const std::string& uuid)
+{
+    PeripheralWinrt& peripheral = Peripheral(uuid);
+    if (peripheral.device.has_value())
+    {
+        peripheral.mtu = session.MaxPduSize();
+        mEmit.Mtu(uuid, peripheral.mtu);
+    }
 }
 
 bool BLEManager::Disconnect(const std::string& uuid)
 {
     CHECK_DEVICE();
-    PeripheralWinrt& peripheral = mDeviceMap[uuid];
+    PeripheralWinrt& peripheral = Peripheral(uuid);
+    bool reconnecting = mReconnects.Cancel(uuid);
+    if (mConnects.Cancel(uuid) && !reconnecting)
+    {
+        mEmit.Connected(uuid, "could not connect to device: cancelled");
+    }
     peripheral.Disconnect();
     mNotifyMap.Remove(uuid);
+    mHealth.Unwatch(uuid);
+    mDeadlines.CancelAll(uuid, "device disconnected");
     mEmit.Disconnected(uuid);
     return true;
 }
@@ -232,570 +514,1704 @@ void BLEManager::OnConnectionStatusChanged(BluetoothLEDevice device,
 {
     if (device.ConnectionStatus() == BluetoothConnectionStatus::Disconnected)
     {
+        std::lock_guard<std::recursive_mutex> lock(mReconnectMutex);
         auto uuid = formatBluetoothUuid(device.BluetoothAddress());
-        if (mDeviceMap.find(uuid) == mDeviceMap.end())
+        if (!FindPeripheral(uuid))
         {
             LOGE("device with id %s not found", uuid.c_str());
             return;
         }
-        PeripheralWinrt& peripheral = mDeviceMap[uuid];
+        if (mReconnects.IsReconnecting(uuid))
+        {
+            // lost again while restoring, the running attempt fails or sees the link down once
+            // it has restored the notifications, and schedules the next one
+            return;
+        }
+        mDeadlines.CancelAll(uuid, "device disconnected");
+        auto delay = mReconnects.Dropped(uuid, std::chrono::steady_clock::now());
+        if (delay)
+        {
+            // the subscriptions and the GATT cache are kept until reconnecting gives up
+            mDeadlines.After(*delay, [=]() { Reconnect(uuid); });
+            return;
+        }
+        PeripheralWinrt& peripheral = Peripheral(uuid);
         peripheral.Disconnect();
         mNotifyMap.Remove(uuid);
+        mHealth.Unwatch(uuid);
         mEmit.Disconnected(uuid);
     }
 }
 
-bool BLEManager::UpdateRSSI(const std::string& uuid)
-{
-    CHECK_DEVICE();
-
-    PeripheralWinrt& peripheral = mDeviceMap[uuid];
-    // no way to get the rssi while we are connected, return the last value of advertisement
-    mEmit.RSSI(uuid, peripheral.rssi);
-    return true;
-}
-
-bool BLEManager::DiscoverServices(const std::string& uuid,
-                                  const std::vector<winrt::guid>& serviceUUIDs)
+void BLEManager::Reconnect(const std::string& uuid)
 {
-    CHECK_DEVICE();
-    IFDEVICE(device, uuid)
+    if (!mReconnects.Attempt(uuid))
     {
-        auto completed = bind2(this, &BLEManager::OnServicesDiscovered, uuid, serviceUUIDs);
-        device.GetGattServicesAsync(BluetoothCacheMode::Uncached).Completed(completed);
-        return true;
+        return;
+    }
+    auto onFailed = [=](const OperationError& error) { OnReconnectFailed(uuid, error); };
+    // reconnects count against the same limit as connections
+    bool queued = mConnects.Enqueue(uuid, 0, [=](auto done) {
+        PeripheralWinrt& peripheral = Peripheral(uuid);
+        if (!peripheral.device.has_value())
+        {
+            onFailed({ OperationStatus::NotConnected, "device not connected" });
+            done(false);
+            return;
+        }
+        auto operation =
+            mDeadlines.Start(uuid, GetTimeouts().connect, [=](const OperationError& error) {
+                onFailed(error);
+                done(false);
+            });
+        try
+        {
+            // the device object is kept, any GATT request brings the link back up
+            auto asyncOp = peripheral.device->GetGattServicesAsync(BluetoothCacheMode::Uncached);
+            operation->SetCancel([asyncOp]() { asyncOp.Cancel(); });
+            asyncOp.Completed([=](auto&& asyncOp, auto&& status) {
+                if (!operation->Settle())
+                {
+                    return;
+                }
+                auto error = asyncError(asyncOp, status);
+                done(!error);
+                if (error)
+                {
+                    onFailed(error);
+                    return;
+                }
+                Rearm(uuid);
+            });
+        }
+        catch (const winrt::hresult_error& e)
+        {
+            operation->Fail({ OperationStatus::Failed, winrt::to_string(e.message()) });
+        }
+    });
+    if (!queued)
+    {
+        onFailed({ OperationStatus::Failed, "device is already connecting" });
     }
 }
 
-void BLEManager::OnServicesDiscovered(IAsyncOperation<GattDeviceServicesResult> asyncOp,
-                                      AsyncStatus status, const std::string uuid,
-                                      const std::vector<winrt::guid> serviceUUIDs)
+void BLEManager::Rearm(const std::string& uuid)
 {
-    if (status == AsyncStatus::Completed)
-    {
-        GattDeviceServicesResult& result = asyncOp.GetResults();
-        CHECK_RESULT(result);
-        std::vector<std::string> serviceUuids;
-        FOR(service, result.Services())
+    // the handlers are still attached, only the descriptors have to be written again
+    auto keys = mNotifyMap.Enabled(uuid);
+    auto onRearmed = [=](std::vector<OperationError> errors) {
+        std::lock_guard<std::recursive_mutex> lock(mReconnectMutex);
+        for (auto& error : errors)
         {
-            auto id = service.Uuid();
-            if (inFilter(serviceUUIDs, id))
+            if (error)
             {
-                serviceUuids.push_back(toStr(id));
+                OnReconnectFailed(uuid, error);
+                return;
             }
         }
-        mEmit.ServicesDiscovered(uuid, serviceUuids);
+        // a drop that arrived while restoring was ignored, so the link is checked once more
+        // before the device counts as restored
+        PeripheralWinrt& peripheral = Peripheral(uuid);
+        if (!peripheral.device.has_value() ||
+            peripheral.device->ConnectionStatus() != BluetoothConnectionStatus::Connected)
+        {
+            OnReconnectFailed(uuid, { OperationStatus::NotConnected,
+                                      "connection lost while restoring" });
+            return;
+        }
+        auto latency = mReconnects.Restored(uuid, std::chrono::steady_clock::now());
+        if (latency)
+        {
+            mEmit.Restored(uuid, *latency, errors.size());
+        }
+    };
+    if (keys.empty())
+    {
+        onRearmed({});
+        return;
     }
-    else
+    auto batch = Batch<OperationError>::Create(keys.size(), onRearmed);
+    for (size_t i = 0; i < keys.size(); i++)
     {
-        LOGE("status: %d", status);
+        auto key = keys[i];
+        mScheduler.Enqueue(uuid, OperationPriority::Notify, [=](auto done) {
+            // takes the turn like a notify request, so that a concurrent unsubscribe can't be
+            // overtaken by the rearming write
+            auto turn = std::make_shared<WriteTurnState>();
+            auto endWrite = [=]() {
+                if (!turn->ended.exchange(true))
+                {
+                    mNotifyMap.EndWrite(uuid, key);
+                }
+            };
+            auto onFailed = [=](const OperationError& error) {
+                batch->Set(i, error);
+                if (turn->held)
+                {
+                    endWrite();
+                }
+            };
+            auto operation = StartOperation(uuid, GetTimeouts().notify, done, onFailed);
+            mNotifyMap.BeginWrite(uuid, key, [=]() {
+                turn->held = true;
+                if (operation->IsSettled())
+                {
+                    endWrite();
+                    return;
+                }
+                auto characteristic = mNotifyMap.Characteristic(uuid, key);
+                if (!characteristic)
+                {
+                    // the last subscriber left while waiting, nothing to restore
+                    if (operation->Settle())
+                    {
+                        batch->Set(i, {});
+                        done();
+                    }
+                    endWrite();
+                    return;
+                }
+                auto write = [=]() {
+                    auto value = GetDescriptorValue(characteristic.CharacteristicProperties());
+                    return characteristic
+                        .WriteClientCharacteristicConfigurationDescriptorWithResultAsync(value);
+                };
+                track(operation, done, write, [=](auto&& asyncOp, auto&& status) {
+                    batch->Set(i, asyncError(asyncOp, status));
+                    endWrite();
+                });
+            });
+        });
     }
 }
 
-bool BLEManager::DiscoverIncludedServices(const std::string& uuid, const winrt::guid& serviceUuid,
-                                          const std::vector<winrt::guid>& serviceUUIDs)
+void BLEManager::OnReconnectFailed(const std::string& uuid, const OperationError& error)
 {
-    CHECK_DEVICE();
-    IFDEVICE(device, uuid)
+    std::lock_guard<std::recursive_mutex> lock(mReconnectMutex);
+    std::chrono::milliseconds delay;
+    switch (mReconnects.Failed(uuid, delay))
     {
-        peripheral.GetService(serviceUuid, [=](std::optional<GattDeviceService> service) {
-            if (service)
-            {
-                std::string serviceId = toStr(serviceUuid);
-                service->GetIncludedServicesAsync(BluetoothCacheMode::Uncached)
-                    .Completed(bind2(this, &BLEManager::OnIncludedServicesDiscovered, uuid,
-                                     serviceId, serviceUUIDs));
-            }
-            else
-            {
-                LOGE("GetService error");
-            }
-        });
-        return true;
+    case ReconnectStep::Retry:
+        mDeadlines.After(delay, [=]() { Reconnect(uuid); });
+        break;
+    case ReconnectStep::GiveUp:
+    {
+        LOGE("could not reconnect device %s: %s", uuid.c_str(), error.message.c_str());
+        PeripheralWinrt& peripheral = Peripheral(uuid);
+        peripheral.Disconnect();
+        mNotifyMap.Remove(uuid);
+        mHealth.Unwatch(uuid);
+        mDeadlines.CancelAll(uuid, "device disconnected");
+        mEmit.Disconnected(uuid);
+        break;
+    }
+    case ReconnectStep::Stopped:
+        break;
     }
 }
 
-void BLEManager::OnIncludedServicesDiscovered(IAsyncOperation<GattDeviceServicesResult> asyncOp,
-                                              AsyncStatus status, const std::string uuid,
-                                              const std::string serviceId,
-                                              const std::vector<winrt::guid> serviceUUIDs)
+bool BLEManager::SetConnectionMode(const std::string& uuid, ConnectionPreset preset)
 {
-    if (status == AsyncStatus::Completed)
+    if (!FindPeripheral(uuid))
     {
-        auto& result = asyncOp.GetResults();
-        CHECK_RESULT(result);
-        std::vector<std::string> servicesUuids;
-        FOR(service, result.Services())
-        {
-            auto id = service.Uuid();
-            if (inFilter(serviceUUIDs, id))
-            {
-                servicesUuids.push_back(toStr(id));
-            }
-        }
-        mEmit.IncludedServicesDiscovered(uuid, serviceId, servicesUuids);
+        PresetResult result;
+        result.requested = preset;
+        result.status = PresetStatus::DeviceNotAvailable;
+        mEmit.ConnectionMode(uuid, result);
+        return false;
     }
-    else
+    PeripheralWinrt& peripheral = Peripheral(uuid);
+    peripheral.connectionPreset = preset;
+    if (!peripheral.device.has_value())
     {
-        LOGE("status: %d", status);
+        // requested once the device connects
+        PresetResult result;
+        result.requested = preset;
+        result.status = PresetStatus::DeviceNotAvailable;
+        mEmit.ConnectionMode(uuid, result);
+        return true;
     }
+    ApplyConnectionMode(uuid, peripheral);
+    return true;
 }
 
-bool BLEManager::DiscoverCharacteristics(const std::string& uuid, const winrt::guid& serviceUuid,
-                                         const std::vector<winrt::guid>& characteristicUUIDs)
+void BLEManager::ApplyConnectionMode(const std::string& uuid, PeripheralWinrt& peripheral)
+{
+    ConnectionParametersWinrt backend(*peripheral.device, peripheral.parametersRequest);
+    mEmit.ConnectionMode(uuid, applyPreset(backend, *peripheral.connectionPreset));
+}
+
+std::optional<ConnectionParameters> BLEManager::GetConnectionParameters(const std::string& uuid)
+{
+    PeripheralWinrt* peripheral = FindPeripheral(uuid);
+    if (!peripheral || !peripheral->device.has_value())
+    {
+        return std::nullopt;
+    }
+    ConnectionParametersWinrt backend(*peripheral->device, peripheral->parametersRequest);
+    return backend.Current();
+}
+
+bool BLEManager::SetHealthMonitor(const std::string& uuid, std::optional<HealthOptions> options,
+                                  std::optional<AttributeKey> probe)
 {
     CHECK_DEVICE();
-    IFDEVICE(device, uuid)
+    PeripheralWinrt& peripheral = Peripheral(uuid);
+    peripheral.health = options;
+    peripheral.healthProbe = probe;
+    if (!options)
     {
-        peripheral.GetService(serviceUuid, [=](std::optional<GattDeviceService> service) {
-            if (service)
-            {
-                std::string serviceId = toStr(serviceUuid);
-                service->GetCharacteristicsAsync(BluetoothCacheMode::Uncached)
-                    .Completed(bind2(this, &BLEManager::OnCharacteristicsDiscovered, uuid,
-                                     serviceId, characteristicUUIDs));
-            }
-            else
-            {
-                LOGE("GetService error");
-            }
-        });
-        return true;
+        mHealth.Unwatch(uuid);
+    }
+    else if (peripheral.device.has_value())
+    {
+        WatchHealth(uuid, *options);
+    }
+    return true;
+}
+
+std::optional<HealthSnapshot> BLEManager::GetLinkHealth(const std::string& uuid) const
+{
+    return mHealth.Snapshot(uuid, std::chrono::steady_clock::now());
+}
+
+void BLEManager::WatchHealth(const std::string& uuid, const HealthOptions& options)
+{
+    if (mHealth.Watch(uuid, options, std::chrono::steady_clock::now()))
+    {
+        mDeadlines.After(HEALTH_CHECK_INTERVAL, [this]() { CheckHealth(); });
     }
 }
 
-void BLEManager::OnCharacteristicsDiscovered(IAsyncOperation<GattCharacteristicsResult> asyncOp,
-                                             AsyncStatus status, const std::string uuid,
-                                             const std::string serviceId,
-                                             const std::vector<winrt::guid> characteristicUUIDs)
+void BLEManager::CheckHealth()
 {
-    if (status == AsyncStatus::Completed)
+    // notifications are only looked at here so that they don't cost anything extra on arrival
+    for (auto& uuid : mHealth.Devices())
     {
-        auto& result = asyncOp.GetResults();
-        CHECK_RESULT(result);
-        std::vector<std::pair<std::string, std::vector<std::string>>> characteristicsUuids;
-        FOR(characteristic, result.Characteristics())
+        for (auto& context : mNotifyMap.Contexts(uuid))
         {
-            auto id = characteristic.Uuid();
-            if (inFilter(characteristicUUIDs, id))
+            auto arrival = context->stats.LastArrival();
+            if (arrival)
             {
-                auto props = characteristic.CharacteristicProperties();
-                characteristicsUuids.push_back({ toStr(id), toPropertyArray(props) });
+                mHealth.Activity(uuid, *arrival);
             }
         }
-        mEmit.CharacteristicsDiscovered(uuid, serviceId, characteristicsUuids);
     }
-    else
+    auto now = std::chrono::steady_clock::now();
+    bool keepChecking;
+    for (auto& change : mHealth.Check(now, keepChecking))
     {
-        LOGE("status: %d", status);
+        mEmit.Health(change.device, change.state, change.silent);
     }
+    if (!keepChecking)
+    {
+        return;
+    }
+    for (auto& uuid : mHealth.DueProbes(now))
+    {
+        Probe(uuid);
+    }
+    mDeadlines.After(HEALTH_CHECK_INTERVAL, [this]() { CheckHealth(); });
 }
 
-bool BLEManager::Read(const std::string& uuid, const winrt::guid& serviceUuid,
-                      const winrt::guid& characteristicUuid)
+bool BLEManager::Probe(const std::string& uuid)
+{
+    auto ignore = [](const OperationError&) {};
+    IFCONNECTED(device, uuid, ignore)
+    {
+        if (!peripheral.healthProbe)
+        {
+            return false;
+        }
+        // the result only counts towards the health of the link, nothing is emitted
+        auto key = *peripheral.healthProbe;
+        mScheduler.Enqueue(uuid, OperationPriority::Read, [=, &peripheral](auto done) {
+            auto operation = StartOperation(uuid, GetTimeouts().read, done, ignore);
+            peripheral.GetCharacteristic(
+                key.service, key.characteristic,
+                [=](std::optional<GattCharacteristic> characteristic) {
+                    if (!characteristic)
+                    {
+                        operation->Fail({ OperationStatus::NotFound, "characteristic not found" });
+                        return;
+                    }
+                    auto read = [=]() {
+                        return characteristic->ReadValueAsync(BluetoothCacheMode::Uncached);
+                    };
+                    track(operation, done, read, [](auto&&, auto&&) {});
+                });
+        });
+        return true;
+    }
+}
+
+bool BLEManager::UpdateRSSI(const std::string& uuid)
 {
     CHECK_DEVICE();
-    IFDEVICE(device, uuid)
+
+    PeripheralWinrt& peripheral = Peripheral(uuid);
+    // no way to get the rssi while we are connected, return the last value of advertisement
+    mEmit.RSSI(uuid, peripheral.rssi);
+    return true;
+}
+
+std::shared_ptr<TimedOperation> BLEManager::StartOperation(const std::string& uuid,
+                                                           std::chrono::milliseconds timeout,
+                                                           GattScheduler::Done done,
+                                                           TimedOperation::OnFailed onFailed)
+{
+    auto started = std::chrono::steady_clock::now();
+    auto record = [=](const OperationError& error) {
+        auto now = std::chrono::steady_clock::now();
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(now - started);
+        mHealth.Completed(uuid, latency, !error, now);
+    };
+    // a failed operation reports its error and gives up its slot in the scheduler
+    auto operation = mDeadlines.Start(uuid, timeout, [=](const OperationError& error) {
+        record(error);
+        onFailed(error);
+        done();
+    });
+    operation->SetOnCompleted(record);
+    return operation;
+}
+
+template <typename H>
+auto BLEManager::Revalidating(const std::string& uuid, const AttributeKey& parent,
+                              BluetoothCacheMode mode, H handler)
+{
+    auto startedAt = std::chrono::steady_clock::now();
+    return [=](auto&& asyncOp, auto&& status) {
+        if (mode == BluetoothCacheMode::Uncached && !asyncError(asyncOp, status))
+        {
+            Peripheral(uuid).Discovered(parent, startedAt);
+        }
+        handler(asyncOp, status);
+    };
+}
+
+bool BLEManager::DiscoverServices(const std::string& uuid,
+                                  const std::vector<winrt::guid>& serviceUUIDs,
+                                  std::optional<CacheMode> cacheMode)
+{
+    auto onFailed = [=](const OperationError& error) {
+        mEmit.ServicesDiscovered(uuid, {}, error);
+    };
+    IFCONNECTED(device, uuid, onFailed)
+    {
+        auto policy = callPolicy(mCachePolicy.discovery, cacheMode);
+        mScheduler.Enqueue(uuid, OperationPriority::Read, [=, &peripheral](auto done) {
+            auto operation = StartOperation(uuid, GetTimeouts().discovery, done, onFailed);
+            auto mode = peripheral.DiscoveryCacheMode({}, policy);
+            auto completed = Revalidating(
+                uuid, {}, mode,
+                bind2(this, &BLEManager::OnServicesDiscovered, uuid, serviceUUIDs));
+            track(operation, done, Retry(OperationClass::Discovery),
+                  [=]() { return device.GetGattServicesAsync(mode); }, completed);
+        });
+        return true;
+    }
+}
+
+void BLEManager::OnServicesDiscovered(IAsyncOperation<GattDeviceServicesResult> asyncOp,
+                                      AsyncStatus status, const std::string& uuid,
+                                      const std::vector<winrt::guid>& serviceUUIDs)
+{
+    auto error = asyncError(asyncOp, status);
+    std::vector<std::string> serviceUuids;
+    if (!error)
     {
-        peripheral.GetCharacteristic(
-            serviceUuid, characteristicUuid, [=](std::optional<GattCharacteristic> characteristic) {
-                if (characteristic)
+        for (auto&& service : asyncOp.GetResults().Services())
+        {
+            auto id = service.Uuid();
+            if (inFilter(serviceUUIDs, id))
+            {
+                serviceUuids.push_back(toStr(id));
+            }
+        }
+    }
+    mEmit.ServicesDiscovered(uuid, serviceUuids, error);
+}
+
+bool BLEManager::DiscoverIncludedServices(const std::string& uuid, const winrt::guid& serviceUuid,
+                                          const std::vector<winrt::guid>& serviceUUIDs,
+                                          std::optional<CacheMode> cacheMode)
+{
+    std::string serviceId = toStr(serviceUuid);
+    auto onFailed = [=](const OperationError& error) {
+        mEmit.IncludedServicesDiscovered(uuid, serviceId, {}, error);
+    };
+    IFCONNECTED(device, uuid, onFailed)
+    {
+        auto policy = callPolicy(mCachePolicy.discovery, cacheMode);
+        mScheduler.Enqueue(uuid, OperationPriority::Read, [=, &peripheral](auto done) {
+            auto operation = StartOperation(uuid, GetTimeouts().discovery, done, onFailed);
+            auto mode = peripheral.DiscoveryCacheMode({ serviceUuid }, policy);
+            peripheral.GetService(serviceUuid, [=](std::optional<GattDeviceService> service) {
+                if (!service)
                 {
-                    std::string serviceId = toStr(serviceUuid);
-                    std::string characteristicId = toStr(characteristicUuid);
-                    characteristic->ReadValueAsync(BluetoothCacheMode::Uncached)
-                        .Completed(
-                            bind2(this, &BLEManager::OnRead, uuid, serviceId, characteristicId));
+                    operation->Fail({ OperationStatus::NotFound, "service not found" });
+                    return;
                 }
-                else
+                auto completed =
+                    Revalidating(uuid, { serviceUuid }, mode,
+                                 bind2(this, &BLEManager::OnIncludedServicesDiscovered, uuid,
+                                       serviceId, serviceUUIDs));
+                track(operation, done, Retry(OperationClass::Discovery),
+                      [=]() { return service->GetIncludedServicesAsync(mode); }, completed);
+            });
+        });
+        return true;
+    }
+}
+
+void BLEManager::OnIncludedServicesDiscovered(IAsyncOperation<GattDeviceServicesResult> asyncOp,
+                                              AsyncStatus status, const std::string& uuid,
+                                              const std::string& serviceId,
+                                              const std::vector<winrt::guid>& serviceUUIDs)
+{
+    auto error = asyncError(asyncOp, status);
+    std::vector<std::string> servicesUuids;
+    if (!error)
+    {
+        for (auto&& service : asyncOp.GetResults().Services())
+        {
+            auto id = service.Uuid();
+            if (inFilter(serviceUUIDs, id))
+            {
+                servicesUuids.push_back(toStr(id));
+            }
+        }
+    }
+    mEmit.IncludedServicesDiscovered(uuid, serviceId, servicesUuids, error);
+}
+
+bool BLEManager::DiscoverCharacteristics(const std::string& uuid, const winrt::guid& serviceUuid,
+                                         const std::vector<winrt::guid>& characteristicUUIDs,
+                                         std::optional<CacheMode> cacheMode)
+{
+    std::string serviceId = toStr(serviceUuid);
+    auto onFailed = [=](const OperationError& error) {
+        mEmit.CharacteristicsDiscovered(uuid, serviceId, {}, error);
+    };
+    IFCONNECTED(device, uuid, onFailed)
+    {
+        auto policy = callPolicy(mCachePolicy.discovery, cacheMode);
+        mScheduler.Enqueue(uuid, OperationPriority::Read, [=, &peripheral](auto done) {
+            auto operation = StartOperation(uuid, GetTimeouts().discovery, done, onFailed);
+            auto mode = peripheral.DiscoveryCacheMode({ serviceUuid }, policy);
+            peripheral.GetService(serviceUuid, [=](std::optional<GattDeviceService> service) {
+                if (!service)
                 {
-                    LOGE("GetCharacteristic error");
+                    operation->Fail({ OperationStatus::NotFound, "service not found" });
+                    return;
                 }
+                auto completed =
+                    Revalidating(uuid, { serviceUuid }, mode,
+                                 bind2(this, &BLEManager::OnCharacteristicsDiscovered, uuid,
+                                       serviceId, characteristicUUIDs));
+                track(operation, done, Retry(OperationClass::Discovery),
+                      [=]() { return service->GetCharacteristicsAsync(mode); }, completed);
             });
+        });
         return true;
     }
 }
 
-void BLEManager::OnRead(IAsyncOperation<GattReadResult> asyncOp, AsyncStatus status,
-                        const std::string uuid, const std::string serviceId,
-                        const std::string characteristicId)
+void BLEManager::OnCharacteristicsDiscovered(IAsyncOperation<GattCharacteristicsResult> asyncOp,
+                                             AsyncStatus status, const std::string& uuid,
+                                             const std::string& serviceId,
+                                             const std::vector<winrt::guid>& characteristicUUIDs)
 {
-    if (status == AsyncStatus::Completed)
+    auto error = asyncError(asyncOp, status);
+    std::vector<std::pair<std::string, std::vector<std::string>>> characteristicsUuids;
+    if (!error)
     {
-        GattReadResult& result = asyncOp.GetResults();
-        CHECK_RESULT(result);
-        auto& value = result.Value();
-        if (value)
+        for (auto&& characteristic : asyncOp.GetResults().Characteristics())
         {
-            auto& reader = DataReader::FromBuffer(value);
-            Data data(reader.UnconsumedBufferLength());
-            reader.ReadBytes(data);
-            mEmit.Read(uuid, serviceId, characteristicId, data, false);
+            auto id = characteristic.Uuid();
+            if (inFilter(characteristicUUIDs, id))
+            {
+                auto props = characteristic.CharacteristicProperties();
+                characteristicsUuids.push_back({ toStr(id), toPropertyArray(props) });
+            }
         }
-        else
+    }
+    mEmit.CharacteristicsDiscovered(uuid, serviceId, characteristicsUuids, error);
+}
+
+bool BLEManager::Read(const std::string& uuid, const winrt::guid& serviceUuid,
+                      const winrt::guid& characteristicUuid, std::optional<CacheMode> cacheMode)
+{
+    std::string serviceId = toStr(serviceUuid);
+    std::string characteristicId = toStr(characteristicUuid);
+    auto onFailed = [=](const OperationError& error) {
+        mEmit.Read(uuid, serviceId, characteristicId, {}, false, error);
+    };
+    IFCONNECTED(device, uuid, onFailed)
+    {
+        auto policy = callPolicy(mCachePolicy.read, cacheMode);
+        AttributeKey key = { serviceUuid, characteristicUuid };
+        bool cacheValue = policy.mode != CacheMode::Uncached && IsStatic(key);
+        if (cacheValue)
         {
-            LOGE("value is null");
+            auto value = peripheral.GetCachedValue(key, policy);
+            if (value)
+            {
+                mEmit.Read(uuid, serviceId, characteristicId, *value, false);
+                return true;
+            }
         }
+        mScheduler.Enqueue(uuid, OperationPriority::Read, [=, &peripheral](auto done) {
+            auto operation = StartOperation(uuid, GetTimeouts().read, done, onFailed);
+            peripheral.GetCharacteristic(
+                serviceUuid, characteristicUuid,
+                [=](std::optional<GattCharacteristic> characteristic) {
+                    if (!characteristic)
+                    {
+                        operation->Fail({ OperationStatus::NotFound, "characteristic not found" });
+                        return;
+                    }
+                    auto completed = bind2(this, &BLEManager::OnRead, uuid, serviceId,
+                                           characteristicId, key, cacheValue);
+                    auto mode = readCacheMode(policy);
+                    track(operation, done, Retry(OperationClass::Read),
+                          [=]() { return characteristic->ReadValueAsync(mode); }, completed);
+                });
+        });
+        return true;
     }
-    else
+}
+
+void BLEManager::OnRead(IAsyncOperation<GattReadResult> asyncOp, AsyncStatus status,
+                        const std::string& uuid, const std::string& serviceId,
+                        const std::string& characteristicId, const AttributeKey& key,
+                        const bool cacheValue)
+{
+    Payload data;
+    auto error = readResult(asyncOp, status, data);
+    if (!error && cacheValue)
     {
-        LOGE("status: %d", status);
+        Peripheral(uuid).CacheValue(key, data);
     }
+    mEmit.Read(uuid, serviceId, characteristicId, data, false, error);
 }
 
-bool BLEManager::Write(const std::string& uuid, const winrt::guid& serviceUuid,
-                       const winrt::guid& characteristicUuid, const Data& data,
-                       bool withoutResponse)
+bool BLEManager::ReadMany(const std::string& uuid, const std::vector<AttributeKey>& characteristics,
+                          std::optional<CacheMode> cacheMode)
 {
-    CHECK_DEVICE();
-    IFDEVICE(device, uuid)
+    auto onFailed = [=](const OperationError& error) {
+        mEmit.ReadMany(uuid, failAll(characteristics, error));
+    };
+    IFCONNECTED(device, uuid, onFailed)
     {
-        peripheral.GetCharacteristic(
-            serviceUuid, characteristicUuid, [=](std::optional<GattCharacteristic> characteristic) {
-                if (characteristic)
-                {
-                    std::string serviceId = toStr(serviceUuid);
-                    std::string characteristicId = toStr(characteristicUuid);
-                    auto writer = DataWriter();
-                    writer.WriteBytes(data);
-                    auto& value = writer.DetachBuffer();
-                    GattWriteOption option = withoutResponse ? GattWriteOption::WriteWithoutResponse
-                                                             : GattWriteOption::WriteWithResponse;
-                    characteristic->WriteValueWithResultAsync(value, option)
-                        .Completed(
-                            bind2(this, &BLEManager::OnWrite, uuid, serviceId, characteristicId));
-                }
-                else
+        if (characteristics.empty())
+        {
+            mEmit.ReadMany(uuid, {});
+            return true;
+        }
+        auto policy = callPolicy(mCachePolicy.read, cacheMode);
+        auto batch = Batch<BatchItemResult>::Create(
+            characteristics.size(),
+            [=](std::vector<BatchItemResult> results) { mEmit.ReadMany(uuid, results); });
+        // every read is queued on its own, the scheduler decides how many run concurrently
+        for (size_t i = 0; i < characteristics.size(); i++)
+        {
+            AttributeKey key = characteristics[i];
+            BatchItemResult item = { toStr(key.service), toStr(key.characteristic) };
+            bool cacheValue = policy.mode != CacheMode::Uncached && IsStatic(key);
+            if (cacheValue)
+            {
+                auto value = peripheral.GetCachedValue(key, policy);
+                if (value)
                 {
-                    LOGE("GetCharacteristic error");
+                    item.data = *value;
+                    batch->Set(i, item);
+                    continue;
                 }
+            }
+            auto onItemFailed = [=](const OperationError& error) {
+                auto failed = item;
+                failed.error = error;
+                batch->Set(i, failed);
+            };
+            mScheduler.Enqueue(uuid, OperationPriority::Read, [=, &peripheral](auto done) {
+                auto operation = StartOperation(uuid, GetTimeouts().read, done, onItemFailed);
+                peripheral.GetCharacteristic(
+                    key.service, key.characteristic,
+                    [=](std::optional<GattCharacteristic> characteristic) {
+                        if (!characteristic)
+                        {
+                            operation->Fail(
+                                { OperationStatus::NotFound, "characteristic not found" });
+                            return;
+                        }
+                        auto completed = bind2(this, &BLEManager::OnReadItem, uuid, batch, i,
+                                               item, key, cacheValue);
+                        auto mode = readCacheMode(policy);
+                        track(operation, done, Retry(OperationClass::Read),
+                              [=]() { return characteristic->ReadValueAsync(mode); }, completed);
+                    });
             });
+        }
         return true;
     }
 }
 
-void BLEManager::OnWrite(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status,
-                         const std::string uuid, const std::string serviceId,
-                         const std::string characteristicId)
+void BLEManager::OnReadItem(IAsyncOperation<GattReadResult> asyncOp, AsyncStatus status,
+                            const std::string& uuid,
+                            const std::shared_ptr<Batch<BatchItemResult>>& batch,
+                            const size_t index, BatchItemResult item, const AttributeKey& key,
+                            const bool cacheValue)
 {
-    if (status == AsyncStatus::Completed)
+    item.error = readResult(asyncOp, status, item.data);
+    if (!item.error && cacheValue)
     {
-        mEmit.Write(uuid, serviceId, characteristicId);
+        Peripheral(uuid).CacheValue(key, item.data);
     }
-    else
+    batch->Set(index, item);
+}
+
+bool BLEManager::Write(const std::string& uuid, const winrt::guid& serviceUuid,
+                       const winrt::guid& characteristicUuid, const Payload& data,
+                       bool withoutResponse)
+{
+    std::string serviceId = toStr(serviceUuid);
+    std::string characteristicId = toStr(characteristicUuid);
+    auto onFailed = [=](const OperationError& error) {
+        mEmit.Write(uuid, serviceId, characteristicId, error);
+    };
+    IFCONNECTED(device, uuid, onFailed)
     {
-        LOGE("status: %d", status);
+        mScheduler.Enqueue(uuid, OperationPriority::Write, [=, &peripheral](auto done) {
+            auto operation = StartOperation(uuid, GetTimeouts().write, done, onFailed);
+            auto mtu = peripheral.mtu;
+            peripheral.GetCharacteristic(
+                serviceUuid, characteristicUuid,
+                [=](std::optional<GattCharacteristic> characteristic) {
+                    if (!characteristic)
+                    {
+                        operation->Fail({ OperationStatus::NotFound, "characteristic not found" });
+                        return;
+                    }
+                    auto properties = characteristic->CharacteristicProperties();
+                    bool canPrepare = (properties & GattCharacteristicProperties::Write) ==
+                        GattCharacteristicProperties::Write;
+                    auto plan = planWrite(data.size, mtu, withoutResponse, canPrepare);
+                    if (plan.mode == WriteMode::Segmented)
+                    {
+                        WriteSegmented(*characteristic, uuid, serviceId, characteristicId, data,
+                                       plan.segmentSize, withoutResponse, operation, done);
+                        return;
+                    }
+                    auto value = payloadBuffer(data);
+                    auto completed =
+                        bind2(this, &BLEManager::OnWrite, uuid, serviceId, characteristicId);
+                    bool reliable = (properties & GattCharacteristicProperties::ReliableWrites) ==
+                        GattCharacteristicProperties::ReliableWrites;
+                    if (plan.mode == WriteMode::Queued && reliable)
+                    {
+                        // prepare writes are echoed and verified before they are executed
+                        auto commit = [=]() {
+                            GattReliableWriteTransaction transaction;
+                            transaction.WriteValue(*characteristic, value);
+                            return transaction.CommitWithResultAsync();
+                        };
+                        track(operation, done, Retry(OperationClass::Write), commit, completed);
+                        return;
+                    }
+                    // the stack splits queued writes into prepare write requests of
+                    // plan.segmentSize bytes itself
+                    GattWriteOption option = withoutResponse
+                        ? GattWriteOption::WriteWithoutResponse
+                        : GattWriteOption::WriteWithResponse;
+                    auto write = [=]() {
+                        return characteristic->WriteValueWithResultAsync(value, option);
+                    };
+                    track(operation, done, Retry(OperationClass::Write), write, completed);
+                });
+        });
+        return true;
     }
 }
 
-GattClientCharacteristicConfigurationDescriptorValue
-GetDescriptorValue(GattCharacteristicProperties properties)
+bool BLEManager::WriteMany(const std::string& uuid, const std::vector<WriteItem>& items,
+                           bool reliable)
 {
-    if ((properties & GattCharacteristicProperties::Indicate) ==
-        GattCharacteristicProperties::Indicate)
+    std::vector<AttributeKey> keys;
+    for (auto& item : items)
     {
-        return GattClientCharacteristicConfigurationDescriptorValue::Indicate;
+        keys.push_back(item.key);
     }
-    else
+    auto onFailed = [=](const OperationError& error) {
+        mEmit.WriteMany(uuid, failAll(keys, error));
+    };
+    IFCONNECTED(device, uuid, onFailed)
     {
-        return GattClientCharacteristicConfigurationDescriptorValue::Notify;
+        if (items.empty())
+        {
+            mEmit.WriteMany(uuid, {});
+            return true;
+        }
+        if (reliable)
+        {
+            mScheduler.Enqueue(uuid, OperationPriority::Write, [=, &peripheral](auto done) {
+                auto operation = StartOperation(uuid, GetTimeouts().write, done, onFailed);
+                WriteReliable(peripheral, uuid, items, operation, done);
+            });
+            return true;
+        }
+        auto batch = Batch<BatchItemResult>::Create(
+            items.size(),
+            [=](std::vector<BatchItemResult> results) { mEmit.WriteMany(uuid, results); });
+        // the writes are started in order and pipelined up to the depth of the device queue
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            auto item = items[i];
+            BatchItemResult result = { toStr(item.key.service), toStr(item.key.characteristic) };
+            auto onItemFailed = [=](const OperationError& error) {
+                auto failed = result;
+                failed.error = error;
+                batch->Set(i, failed);
+            };
+            mScheduler.Enqueue(uuid, OperationPriority::Write, [=, &peripheral](auto done) {
+                auto operation = StartOperation(uuid, GetTimeouts().write, done, onItemFailed);
+                peripheral.GetCharacteristic(
+                    item.key.service, item.key.characteristic,
+                    [=](std::optional<GattCharacteristic> characteristic) {
+                        if (!characteristic)
+                        {
+                            operation->Fail(
+                                { OperationStatus::NotFound, "characteristic not found" });
+                            return;
+                        }
+                        auto value = payloadBuffer(item.data);
+                        GattWriteOption option = item.withoutResponse
+                            ? GattWriteOption::WriteWithoutResponse
+                            : GattWriteOption::WriteWithResponse;
+                        auto completed = bind2(this, &BLEManager::OnWriteItem, batch, i, result);
+                        track(operation, done, Retry(OperationClass::Write),
+                              [=]() {
+                                  return characteristic->WriteValueWithResultAsync(value, option);
+                              },
+                              completed);
+                    });
+            });
+        }
+        return true;
     }
 }
 
-bool BLEManager::Notify(const std::string& uuid, const winrt::guid& serviceUuid,
-                        const winrt::guid& characteristicUuid, bool on)
+void BLEManager::OnWriteItem(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status,
+                             const std::shared_ptr<Batch<BatchItemResult>>& batch,
+                             const size_t index, BatchItemResult item)
 {
-    CHECK_DEVICE();
-    IFDEVICE(device, uuid)
-    {
-        auto onCharacteristic = [=](std::optional<GattCharacteristic> characteristic) {
-            if (characteristic)
+    item.error = asyncError(asyncOp, status);
+    batch->Set(index, item);
+}
+
+void BLEManager::WriteReliable(PeripheralWinrt& peripheral, const std::string& uuid,
+                               const std::vector<WriteItem>& items,
+                               std::shared_ptr<TimedOperation> operation,
+                               GattScheduler::Done done)
+{
+    using Characteristics = std::vector<std::optional<GattCharacteristic>>;
+    auto onCharacteristics = [=](Characteristics characteristics) {
+        // the transaction is only committed if all characteristics were found
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            if (!characteristics[i])
             {
-                std::string serviceId = toStr(serviceUuid);
-                std::string characteristicId = toStr(characteristicUuid);
-                bool subscribed = mNotifyMap.IsSubscribed(uuid, *characteristic);
+                operation->Fail({ OperationStatus::NotFound,
+                                  "characteristic " + toStr(items[i].key.characteristic) +
+                                      " not found, transaction not committed" });
+                return;
+            }
+        }
+        auto commit = [=]() {
+            GattReliableWriteTransaction transaction;
+            for (size_t i = 0; i < items.size(); i++)
+            {
+                transaction.WriteValue(*characteristics[i], payloadBuffer(items[i].data));
+            }
+            return transaction.CommitWithResultAsync();
+        };
+        track(operation, done, Retry(OperationClass::Write), commit,
+              bind2(this, &BLEManager::OnWriteReliable, uuid, items));
+    };
+    auto lookups =
+        Batch<std::optional<GattCharacteristic>>::Create(items.size(), onCharacteristics);
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        peripheral.GetCharacteristic(items[i].key.service, items[i].key.characteristic,
+                                     [=](std::optional<GattCharacteristic> characteristic) {
+                                         lookups->Set(i, characteristic);
+                                     });
+    }
+}
+
+void BLEManager::OnWriteReliable(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status,
+                                 const std::string& uuid, const std::vector<WriteItem>& items)
+{
+    // the transaction succeeds or fails as a whole
+    std::vector<AttributeKey> keys;
+    for (auto& item : items)
+    {
+        keys.push_back(item.key);
+    }
+    mEmit.WriteMany(uuid, failAll(keys, asyncError(asyncOp, status)));
+}
+
+void BLEManager::WriteSegmented(GattCharacteristic characteristic, const std::string& uuid,
+                                const std::string& serviceId, const std::string& characteristicId,
+                                const Payload& data, size_t segmentSize, bool withoutResponse,
+                                std::shared_ptr<TimedOperation> operation,
+                                GattScheduler::Done done)
+{
+    GattWriteOption option = withoutResponse ? GattWriteOption::WriteWithoutResponse
+                                             : GattWriteOption::WriteWithResponse;
+    auto write = [characteristic, option, data](const uint8_t* chunk, size_t size,
+                                                StreamWriter::ChunkDone chunkDone) {
+        auto value = payloadBuffer(data, chunk - data.data, size);
+        try
+        {
+            characteristic.WriteValueWithResultAsync(value, option)
+                .Completed(
+                    [chunkDone](IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status) {
+                        chunkDone(!asyncError(asyncOp, status));
+                    });
+        }
+        catch (const winrt::hresult_error& e)
+        {
+            LOGE("segment write failed: %s", winrt::to_string(e.message()).c_str());
+            chunkDone(false);
+        }
+    };
+    auto onDone = [=](bool success, const StreamProgress& progress) {
+        if (!operation->Settle())
+        {
+            return;
+        }
+        OperationError error;
+        if (!success)
+        {
+            error = { OperationStatus::Failed, "write failed after " +
+                                                   std::to_string(progress.sent) + " of " +
+                                                   std::to_string(progress.total) + " bytes" };
+        }
+        operation->Completed(error);
+        mEmit.Write(uuid, serviceId, characteristicId, error);
+        done();
+    };
+    // segments written with response have to arrive one after another
+    size_t window = withoutResponse ? SEGMENT_WINDOW : 1;
+    auto onProgress = [](const StreamProgress&) {};
+    auto writer = StreamWriter::Create(data, segmentSize, window, write, onProgress, onDone);
+    operation->SetCancel([writer]() { writer->Cancel(); });
+    writer->Start();
+}
+
+void BLEManager::OnWrite(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status,
+                         const std::string& uuid, const std::string& serviceId,
+                         const std::string& characteristicId)
+{
+    mEmit.Write(uuid, serviceId, characteristicId, asyncError(asyncOp, status));
+}
 
+bool BLEManager::Notify(const std::string& uuid, const winrt::guid& serviceUuid,
+                        const winrt::guid& characteristicUuid, bool on,
+                        const std::string& subscriber, const SubscriberOptions& options)
+{
+    std::string serviceId = toStr(serviceUuid);
+    std::string characteristicId = toStr(characteristicUuid);
+    SubscriptionKey key = { serviceUuid, characteristicUuid };
+    // used if this is the first subscriber
+    std::shared_ptr<SubscriptionContext> context;
+    if (on)
+    {
+        context = std::make_shared<SubscriptionContext>();
+        context->uuid = formatUuid(uuid);
+        context->serviceUuid = formatUuid(serviceId);
+        context->characteristicUuid = formatUuid(characteristicId);
+    }
+    auto onFailed = [=](const OperationError& error) {
+        if (context)
+        {
+            mNotifyMap.Abort(uuid, key, context);
+        }
+        mEmit.Notify(uuid, serviceId, characteristicId, on, error);
+    };
+    IFCONNECTED(device, uuid, onFailed)
+    {
+        mScheduler.Enqueue(uuid, OperationPriority::Notify, [=, &peripheral](auto done) {
+            // the turn to write the descriptor is handed on once, when the request is settled
+            auto turn = std::make_shared<WriteTurnState>();
+            auto endWrite = [=]() {
+                if (!turn->ended.exchange(true))
+                {
+                    mNotifyMap.EndWrite(uuid, key);
+                }
+            };
+            auto onTurnFailed = [=](const OperationError& error) {
+                onFailed(error);
+                if (turn->held)
+                {
+                    endWrite();
+                }
+            };
+            auto operation = StartOperation(uuid, GetTimeouts().notify, done, onTurnFailed);
+            auto onCharacteristic = [=](std::optional<GattCharacteristic> characteristic) {
+                if (!characteristic)
+                {
+                    operation->Fail({ OperationStatus::NotFound, "characteristic not found" });
+                    return;
+                }
+                auto settle = [=]() {
+                    if (operation->Settle())
+                    {
+                        mEmit.Notify(uuid, serviceId, characteristicId, on);
+                        done();
+                    }
+                    endWrite();
+                };
+                auto descriptorValue = GattClientCharacteristicConfigurationDescriptorValue::None;
                 if (on)
                 {
-                    if (subscribed)
+                    auto result = mNotifyMap.Subscribe(uuid, key, subscriber, options, context);
+                    if (result != SubscribeResult::Enable)
                     {
                         // already listening
-                        mEmit.Notify(uuid, serviceId, characteristicId, true);
+                        settle();
                         return;
                     }
-                    auto descriptorValue =
+                    descriptorValue =
                         GetDescriptorValue(characteristic->CharacteristicProperties());
-
-                    auto completed = bind2(this, &BLEManager::OnNotify, *characteristic, uuid,
-                                           serviceId, characteristicId, on);
-                    characteristic
-                        ->WriteClientCharacteristicConfigurationDescriptorWithResultAsync(
-                            descriptorValue)
-                        .Completed(completed);
                 }
-                else
+                else if (mNotifyMap.Unsubscribe(uuid, key, subscriber) !=
+                         UnsubscribeResult::Disable)
                 {
-                    if (!subscribed)
-                    {
-                        // already not listening
-                        mEmit.Notify(uuid, serviceId, characteristicId, false);
-                        return;
-                    }
+                    // not listening or other subscribers remain
+                    settle();
+                    return;
+                }
 
-                    mNotifyMap.Unsubscribe(uuid, *characteristic);
-                    auto descriptorValue =
-                        GattClientCharacteristicConfigurationDescriptorValue::None;
-                    auto completed = bind2(this, &BLEManager::OnNotify, *characteristic, uuid,
-                                           serviceId, characteristicId, on);
-                    characteristic
+                auto completed = [=](IAsyncOperation<GattWriteResult> asyncOp,
+                                     AsyncStatus status) {
+                    OnNotify(asyncOp, status, *characteristic, uuid, key, context, serviceId,
+                             characteristicId, on);
+                    endWrite();
+                };
+                auto write = [=]() {
+                    return characteristic
                         ->WriteClientCharacteristicConfigurationDescriptorWithResultAsync(
-                            descriptorValue)
-                        .Completed(completed);
+                            descriptorValue);
+                };
+                track(operation, done, Retry(OperationClass::Notify), write, completed);
+            };
+            auto onTurn = [=, &peripheral]() {
+                turn->held = true;
+                if (operation->IsSettled())
+                {
+                    // failed while waiting for the turn
+                    endWrite();
+                    return;
                 }
-            }
-            else
-            {
-                LOGE("GetCharacteristic error");
-            }
-        };
-        peripheral.GetCharacteristic(serviceUuid, characteristicUuid, onCharacteristic);
+                peripheral.GetCharacteristic(serviceUuid, characteristicUuid, onCharacteristic);
+            };
+            mNotifyMap.BeginWrite(uuid, key, onTurn);
+        });
         return true;
     }
 }
 
 void BLEManager::OnNotify(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status,
-                          const GattCharacteristic characteristic, const std::string uuid,
-                          const std::string serviceId, const std::string characteristicId,
+                          const GattCharacteristic characteristic, const std::string& uuid,
+                          const SubscriptionKey& key,
+                          const std::shared_ptr<SubscriptionContext>& context,
+                          const std::string& serviceId, const std::string& characteristicId,
                           const bool state)
 {
-    if (status == AsyncStatus::Completed)
+    auto error = asyncError(asyncOp, status);
+    if (error && state == true)
     {
-        if (state == true)
-        {
-            auto onChanged = bind2(this, &BLEManager::OnValueChanged, uuid);
-            auto token = characteristic.ValueChanged(onChanged);
-            mNotifyMap.Add(uuid, characteristic, token);
-        }
-        mEmit.Notify(uuid, serviceId, characteristicId, state);
+        mNotifyMap.Abort(uuid, key, context);
     }
-    else
+    else if (state == true)
     {
-        LOGE("status: %d", status);
+        auto onChanged = bind2(this, &BLEManager::OnValueChanged, context);
+        auto token = characteristic.ValueChanged(onChanged);
+        mNotifyMap.Attach(uuid, key, context, characteristic, token);
     }
+    mEmit.Notify(uuid, serviceId, characteristicId, state, error);
 }
 
 void BLEManager::OnValueChanged(GattCharacteristic characteristic,
-                                const GattValueChangedEventArgs& args, std::string deviceUuid)
+                                const GattValueChangedEventArgs& args,
+                                const std::shared_ptr<SubscriptionContext>& context)
 {
-    auto& reader = DataReader::FromBuffer(args.CharacteristicValue());
-    Data data(reader.UnconsumedBufferLength());
-    reader.ReadBytes(data);
-    auto characteristicUuid = toStr(characteristic.Uuid());
-    auto serviceUuid = toStr(characteristic.Service().Uuid());
-    mEmit.Read(deviceUuid, serviceUuid, characteristicUuid, data, true);
+    auto now = std::chrono::steady_clock::now();
+    auto data = bufferPayload(args.CharacteristicValue());
+    context->stats.Arrived(now, data.size);
+    auto delivery = context->Delivery();
+    if (delivery.ring)
+    {
+        auto timestamp =
+            std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch());
+        delivery.ring->Push(timestamp.count(), data.data, data.size);
+        return;
+    }
+    auto subscribers = context->subscribers.Deliver(now);
+    if (!subscribers)
+    {
+        context->stats.Throttled();
+        return;
+    }
+    if (delivery.decoder)
+    {
+        DecodedValues values;
+        if (delivery.decoder->Decode(data.data, data.size, values))
+        {
+            mEmit.Decoded(context, std::move(values), subscribers, now);
+            return;
+        }
+        context->stats.DecodeError();
+    }
+    mEmit.Notification(context, data, subscribers, now);
+}
+
+void BLEManager::SetDecoder(const std::string& uuid, const winrt::guid& serviceUuid,
+                            const winrt::guid& characteristicUuid,
+                            std::shared_ptr<const PayloadDecoder> decoder)
+{
+    mNotifyMap.SetDecoder(uuid, { serviceUuid, characteristicUuid }, std::move(decoder));
+}
+
+std::vector<std::shared_ptr<SubscriptionContext>> BLEManager::GetNotifyStats()
+{
+    return mNotifyMap.Contexts();
+}
+
+std::shared_ptr<NotifyRing> BLEManager::SetNotifyRing(const std::string& uuid,
+                                                      const winrt::guid& serviceUuid,
+                                                      const winrt::guid& characteristicUuid,
+                                                      std::shared_ptr<NotifyRing> ring)
+{
+    return mNotifyMap.SetRing(uuid, { serviceUuid, characteristicUuid }, std::move(ring));
 }
 
 bool BLEManager::DiscoverDescriptors(const std::string& uuid, const winrt::guid& serviceUuid,
-                                     const winrt::guid& characteristicUuid)
+                                     const winrt::guid& characteristicUuid,
+                                     std::optional<CacheMode> cacheMode)
 {
-    CHECK_DEVICE();
-    IFDEVICE(device, uuid)
+    std::string serviceId = toStr(serviceUuid);
+    std::string characteristicId = toStr(characteristicUuid);
+    auto onFailed = [=](const OperationError& error) {
+        mEmit.DescriptorsDiscovered(uuid, serviceId, characteristicId, {}, error);
+    };
+    IFCONNECTED(device, uuid, onFailed)
     {
-        peripheral.GetCharacteristic(
-            serviceUuid, characteristicUuid, [=](std::optional<GattCharacteristic> characteristic) {
-                if (characteristic)
-                {
-                    std::string serviceId = toStr(serviceUuid);
-                    std::string characteristicId = toStr(characteristicUuid);
-                    auto completed = bind2(this, &BLEManager::OnDescriptorsDiscovered, uuid,
-                                           serviceId, characteristicId);
-                    characteristic->GetDescriptorsAsync(BluetoothCacheMode::Uncached)
-                        .Completed(completed);
-                }
-                else
-                {
-                    LOGE("GetCharacteristic error");
-                }
-            });
+        auto policy = callPolicy(mCachePolicy.discovery, cacheMode);
+        mScheduler.Enqueue(uuid, OperationPriority::Read, [=, &peripheral](auto done) {
+            auto operation = StartOperation(uuid, GetTimeouts().discovery, done, onFailed);
+            AttributeKey key = { serviceUuid, characteristicUuid };
+            auto mode = peripheral.DiscoveryCacheMode(key, policy);
+            peripheral.GetCharacteristic(
+                serviceUuid, characteristicUuid,
+                [=](std::optional<GattCharacteristic> characteristic) {
+                    if (!characteristic)
+                    {
+                        operation->Fail({ OperationStatus::NotFound, "characteristic not found" });
+                        return;
+                    }
+                    auto completed =
+                        Revalidating(uuid, key, mode,
+                                     bind2(this, &BLEManager::OnDescriptorsDiscovered, uuid,
+                                           serviceId, characteristicId));
+                    track(operation, done, Retry(OperationClass::Discovery),
+                          [=]() { return characteristic->GetDescriptorsAsync(mode); }, completed);
+                });
+        });
         return true;
     }
 }
 
 void BLEManager::OnDescriptorsDiscovered(IAsyncOperation<GattDescriptorsResult> asyncOp,
-                                         AsyncStatus status, const std::string uuid,
-                                         const std::string serviceId,
-                                         const std::string characteristicId)
+                                         AsyncStatus status, const std::string& uuid,
+                                         const std::string& serviceId,
+                                         const std::string& characteristicId)
 {
-    if (status == AsyncStatus::Completed)
+    auto error = asyncError(asyncOp, status);
+    std::vector<std::string> descriptorUuids;
+    if (!error)
     {
-        auto& result = asyncOp.GetResults();
-        CHECK_RESULT(result);
-        std::vector<std::string> descriptorUuids;
-        FOR(descriptor, result.Descriptors())
+        for (auto&& descriptor : asyncOp.GetResults().Descriptors())
         {
             descriptorUuids.push_back(toStr(descriptor.Uuid()));
         }
-        mEmit.DescriptorsDiscovered(uuid, serviceId, characteristicId, descriptorUuids);
-    }
-    else
-    {
-        LOGE("status: %d", status);
     }
+    mEmit.DescriptorsDiscovered(uuid, serviceId, characteristicId, descriptorUuids, error);
 }
 
 bool BLEManager::ReadValue(const std::string& uuid, const winrt::guid& serviceUuid,
-                           const winrt::guid& characteristicUuid, const winrt::guid& descriptorUuid)
+                           const winrt::guid& characteristicUuid, const winrt::guid& descriptorUuid,
+                           std::optional<CacheMode> cacheMode)
 {
-    CHECK_DEVICE();
-    IFDEVICE(device, uuid)
+    std::string serviceId = toStr(serviceUuid);
+    std::string characteristicId = toStr(characteristicUuid);
+    std::string descriptorId = toStr(descriptorUuid);
+    auto onFailed = [=](const OperationError& error) {
+        mEmit.ReadValue(uuid, serviceId, characteristicId, descriptorId, {}, error);
+    };
+    IFCONNECTED(device, uuid, onFailed)
     {
-        peripheral.GetDescriptor(
-            serviceUuid, characteristicUuid, descriptorUuid,
-            [=](std::optional<GattDescriptor> descriptor) {
-                if (descriptor)
-                {
-                    std::string serviceId = toStr(serviceUuid);
-                    std::string characteristicId = toStr(characteristicUuid);
-                    std::string descriptorId = toStr(descriptorUuid);
+        auto mode = readCacheMode(callPolicy(mCachePolicy.read, cacheMode));
+        mScheduler.Enqueue(uuid, OperationPriority::Read, [=, &peripheral](auto done) {
+            auto operation = StartOperation(uuid, GetTimeouts().read, done, onFailed);
+            peripheral.GetDescriptor(
+                serviceUuid, characteristicUuid, descriptorUuid,
+                [=](std::optional<GattDescriptor> descriptor) {
+                    if (!descriptor)
+                    {
+                        operation->Fail({ OperationStatus::NotFound, "descriptor not found" });
+                        return;
+                    }
                     auto completed = bind2(this, &BLEManager::OnReadValue, uuid, serviceId,
                                            characteristicId, descriptorId);
-                    descriptor->ReadValueAsync(BluetoothCacheMode::Uncached).Completed(completed);
-                }
-                else
-                {
-                    LOGE("descriptor not found");
-                }
-            });
+                    track(operation, done, Retry(OperationClass::Read),
+                          [=]() { return descriptor->ReadValueAsync(mode); }, completed);
+                });
+        });
         return true;
     }
 }
 
 void BLEManager::OnReadValue(IAsyncOperation<GattReadResult> asyncOp, AsyncStatus status,
-                             const std::string uuid, const std::string serviceId,
-                             const std::string characteristicId, const std::string descriptorId)
+                             const std::string& uuid, const std::string& serviceId,
+                             const std::string& characteristicId, const std::string& descriptorId)
 {
-    if (status == AsyncStatus::Completed)
-    {
-        GattReadResult& result = asyncOp.GetResults();
-        CHECK_RESULT(result);
-        auto& value = result.Value();
-        if (value)
-        {
-            auto& reader = DataReader::FromBuffer(value);
-            Data data(reader.UnconsumedBufferLength());
-            reader.ReadBytes(data);
-            mEmit.ReadValue(uuid, serviceId, characteristicId, descriptorId, data);
-        }
-        else
-        {
-            LOGE("value is null");
-        }
-    }
-    else
-    {
-        LOGE("status: %d", status);
-    }
+    Payload data;
+    auto error = readResult(asyncOp, status, data);
+    mEmit.ReadValue(uuid, serviceId, characteristicId, descriptorId, data, error);
 }
 
 bool BLEManager::WriteValue(const std::string& uuid, const winrt::guid& serviceUuid,
                             const winrt::guid& characteristicUuid,
-                            const winrt::guid& descriptorUuid, const Data& data)
+                            const winrt::guid& descriptorUuid, const Payload& data)
 {
-    CHECK_DEVICE();
-    IFDEVICE(device, uuid)
+    std::string serviceId = toStr(serviceUuid);
+    std::string characteristicId = toStr(characteristicUuid);
+    std::string descriptorId = toStr(descriptorUuid);
+    auto onFailed = [=](const OperationError& error) {
+        mEmit.WriteValue(uuid, serviceId, characteristicId, descriptorId, error);
+    };
+    IFCONNECTED(device, uuid, onFailed)
     {
-        auto onDescriptor = [=](std::optional<GattDescriptor> descriptor) {
-            if (descriptor)
-            {
-                std::string serviceId = toStr(serviceUuid);
-                std::string characteristicId = toStr(characteristicUuid);
-                std::string descriptorId = toStr(descriptorUuid);
-                auto writer = DataWriter();
-                writer.WriteBytes(data);
-                auto& value = writer.DetachBuffer();
-                auto& asyncOp = descriptor->WriteValueWithResultAsync(value);
-                asyncOp.Completed(bind2(this, &BLEManager::OnWriteValue, uuid, serviceId,
-                                        characteristicId, descriptorId));
-            }
-            else
-            {
-                LOGE("descriptor not found");
-            }
-        };
-        peripheral.GetDescriptor(serviceUuid, characteristicUuid, descriptorUuid, onDescriptor);
+        mScheduler.Enqueue(uuid, OperationPriority::Write, [=, &peripheral](auto done) {
+            auto operation = StartOperation(uuid, GetTimeouts().write, done, onFailed);
+            auto onDescriptor = [=](std::optional<GattDescriptor> descriptor) {
+                if (!descriptor)
+                {
+                    operation->Fail({ OperationStatus::NotFound, "descriptor not found" });
+                    return;
+                }
+                auto value = payloadBuffer(data);
+                // descriptors are written with response, values longer than MTU - 3 are
+                // written by the stack as a queued write
+                auto completed = bind2(this, &BLEManager::OnWriteValue, uuid, serviceId,
+                                       characteristicId, descriptorId);
+                track(operation, done, Retry(OperationClass::Write),
+                      [=]() { return descriptor->WriteValueWithResultAsync(value); }, completed);
+            };
+            peripheral.GetDescriptor(serviceUuid, characteristicUuid, descriptorUuid,
+                                     onDescriptor);
+        });
         return true;
     }
 }
 
 void BLEManager::OnWriteValue(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status,
-                              const std::string uuid, const std::string serviceId,
-                              const std::string characteristicId, const std::string descriptorId)
+                              const std::string& uuid, const std::string& serviceId,
+                              const std::string& characteristicId, const std::string& descriptorId)
 {
-    if (status == AsyncStatus::Completed)
+    mEmit.WriteValue(uuid, serviceId, characteristicId, descriptorId,
+                     asyncError(asyncOp, status));
+}
+
+bool BLEManager::ReadHandle(const std::string& uuid, int handle)
+{
+    auto onFailed = [=](const OperationError& error) {
+        mEmit.ReadHandle(uuid, handle, {}, error);
+    };
+    CHECK_HANDLE(handle, onFailed);
+    IFCONNECTED(device, uuid, onFailed)
     {
-        mEmit.WriteValue(uuid, serviceId, characteristicId, descriptorId);
+        auto mode = readCacheMode(mCachePolicy.read);
+        mScheduler.Enqueue(uuid, OperationPriority::Read, [=, &peripheral](auto done) {
+            auto operation = StartOperation(uuid, GetTimeouts().read, done, onFailed);
+            peripheral.GetAttribute(handle, [=](std::optional<Attribute> attribute) {
+                if (!attribute)
+                {
+                    operation->Fail({ OperationStatus::NotFound, "no attribute with handle " +
+                                                                     std::to_string(handle) });
+                    return;
+                }
+                auto completed = bind2(this, &BLEManager::OnReadHandle, uuid, handle);
+                switch (attribute->type)
+                {
+                case AttributeType::Characteristic:
+                    track(operation, done, Retry(OperationClass::Read),
+                          [=]() { return attribute->characteristic.ReadValueAsync(mode); },
+                          completed);
+                    break;
+                case AttributeType::Descriptor:
+                    track(operation, done, Retry(OperationClass::Read),
+                          [=]() { return attribute->descriptor.ReadValueAsync(mode); },
+                          completed);
+                    break;
+                default:
+                    operation->Fail({ OperationStatus::NotFound,
+                                      "handle " + std::to_string(handle) +
+                                          " is a service declaration" });
+                    break;
+                }
+            });
+        });
+        return true;
     }
-    else
+}
+
+void BLEManager::OnReadHandle(IAsyncOperation<GattReadResult> asyncOp, AsyncStatus status,
+                              const std::string& uuid, const int handle)
+{
+    Payload data;
+    auto error = readResult(asyncOp, status, data);
+    mEmit.ReadHandle(uuid, handle, data, error);
+}
+
+bool BLEManager::WriteHandle(const std::string& uuid, int handle, const Payload& data)
+{
+    auto onFailed = [=](const OperationError& error) { mEmit.WriteHandle(uuid, handle, error); };
+    CHECK_HANDLE(handle, onFailed);
+    IFCONNECTED(device, uuid, onFailed)
     {
-        LOGE("status: %d", status);
+        mScheduler.Enqueue(uuid, OperationPriority::Write, [=, &peripheral](auto done) {
+            auto operation = StartOperation(uuid, GetTimeouts().write, done, onFailed);
+            peripheral.GetAttribute(handle, [=](std::optional<Attribute> attribute) {
+                if (!attribute)
+                {
+                    operation->Fail({ OperationStatus::NotFound, "no attribute with handle " +
+                                                                     std::to_string(handle) });
+                    return;
+                }
+                auto value = payloadBuffer(data);
+                auto completed = bind2(this, &BLEManager::OnWriteHandle, uuid, handle);
+                switch (attribute->type)
+                {
+                case AttributeType::Characteristic:
+                {
+                    auto properties = attribute->characteristic.CharacteristicProperties();
+                    bool withResponse = (properties & GattCharacteristicProperties::Write) ==
+                        GattCharacteristicProperties::Write;
+                    GattWriteOption option = withResponse ? GattWriteOption::WriteWithResponse
+                                                          : GattWriteOption::WriteWithoutResponse;
+                    auto write = [=]() {
+                        return attribute->characteristic.WriteValueWithResultAsync(value, option);
+                    };
+                    track(operation, done, Retry(OperationClass::Write), write, completed);
+                    break;
+                }
+                case AttributeType::Descriptor:
+                    track(operation, done, Retry(OperationClass::Write),
+                          [=]() { return attribute->descriptor.WriteValueWithResultAsync(value); },
+                          completed);
+                    break;
+                default:
+                    operation->Fail({ OperationStatus::NotFound,
+                                      "handle " + std::to_string(handle) +
+                                          " is a service declaration" });
+                    break;
+                }
+            });
+        });
+        return true;
     }
 }
 
-bool BLEManager::ReadHandle(const std::string& uuid, int handle)
+void BLEManager::OnWriteHandle(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status,
+                               const std::string& uuid, const int handle)
 {
-    CHECK_DEVICE();
-    IFDEVICE(device, uuid)
+    mEmit.WriteHandle(uuid, handle, asyncError(asyncOp, status));
+}
+
+bool BLEManager::DiscoverAll(const std::string& uuid, const std::vector<winrt::guid>& serviceUUIDs,
+                             std::optional<CacheMode> cacheMode)
+{
+    auto onFailed = [=](const OperationError& error) { mEmit.AllDiscovered(uuid, {}, error); };
+    IFCONNECTED(device, uuid, onFailed)
     {
-        LOGE("not available");
+        auto policy = callPolicy(mCachePolicy.discovery, cacheMode);
+        mScheduler.Enqueue(uuid, OperationPriority::Read, [=](auto done) {
+            auto operation = StartOperation(uuid, GetTimeouts().discovery, done, onFailed);
+            auto result = std::make_shared<DiscoveryResult>();
+            auto completed = bind2(this, &BLEManager::OnAllDiscovered, uuid, result);
+            track(operation, done,
+                  [=]() { return DiscoverAllAsync(device, uuid, serviceUUIDs, policy, result); },
+                  completed);
+        });
         return true;
     }
 }
 
-void BLEManager::OnReadHandle(IAsyncOperation<GattReadResult> asyncOp, AsyncStatus status,
-                              const std::string uuid, const int handle)
+IAsyncAction BLEManager::DiscoverAllAsync(BluetoothLEDevice device, std::string uuid,
+                                          std::vector<winrt::guid> serviceUUIDs,
+                                          CachePolicy policy,
+                                          std::shared_ptr<DiscoveryResult> discovery)
 {
-    if (status == AsyncStatus::Completed)
+    // every level of the tree is revalidated on its own, only the nodes whose uncached discovery
+    // succeeded count as revalidated
+    auto startedAt = std::chrono::steady_clock::now();
+    std::vector<AttributeKey> revalidated;
+    auto cacheMode = [&](const AttributeKey& parent) {
+        return Peripheral(uuid).DiscoveryCacheMode(parent, policy);
+    };
+    auto servicesMode = cacheMode({});
+    auto servicesResult = co_await device.GetGattServicesAsync(servicesMode);
+    discovery->error = resultError(servicesResult);
+    if (discovery->error)
+    {
+        co_return;
+    }
+    if (servicesMode == BluetoothCacheMode::Uncached)
     {
-        GattReadResult& result = asyncOp.GetResults();
-        CHECK_RESULT(result);
-        auto& value = result.Value();
-        if (value)
+        revalidated.push_back({});
+    }
+    // start the characteristic discovery of all services before awaiting the first one
+    std::vector<GattDeviceService> services;
+    std::vector<BluetoothCacheMode> characteristicModes;
+    std::vector<IAsyncOperation<GattCharacteristicsResult>> characteristicOps;
+    for (auto&& service : servicesResult.Services())
+    {
+        if (inFilter(serviceUUIDs, service.Uuid()))
         {
-            auto& reader = DataReader::FromBuffer(value);
-            Data data(reader.UnconsumedBufferLength());
-            reader.ReadBytes(data);
-            mEmit.ReadHandle(uuid, handle, data);
+            services.push_back(service);
+            characteristicModes.push_back(cacheMode({ service.Uuid() }));
+            characteristicOps.push_back(
+                service.GetCharacteristicsAsync(characteristicModes.back()));
         }
-        else
+    }
+
+    struct DescriptorTarget
+    {
+        size_t serviceIndex;
+        size_t characteristicIndex;
+        GattCharacteristic characteristic;
+        BluetoothCacheMode mode;
+    };
+    std::vector<DiscoveredService> tree(services.size());
+    std::vector<DescriptorTarget> targets;
+    std::vector<IAsyncOperation<GattDescriptorsResult>> descriptorOps;
+    for (size_t i = 0; i < services.size(); i++)
+    {
+        tree[i].uuid = toStr(services[i].Uuid());
+        auto result = co_await characteristicOps[i];
+        tree[i].error = resultError(result);
+        if (tree[i].error)
+        {
+            LOGE("characteristics of service %s: %s", tree[i].uuid.c_str(),
+                 tree[i].error.message.c_str());
+            // the tree is incomplete, the first failure is reported for the whole discovery
+            if (!discovery->error)
+            {
+                discovery->error = { tree[i].error.status, "characteristics of service " +
+                                                               tree[i].uuid + ": " +
+                                                               tree[i].error.message };
+            }
+            continue;
+        }
+        if (characteristicModes[i] == BluetoothCacheMode::Uncached)
+        {
+            revalidated.push_back({ services[i].Uuid() });
+        }
+        auto& characteristics = tree[i].characteristics;
+        for (auto&& characteristic : result.Characteristics())
         {
-            LOGE("value is null");
+            auto props = characteristic.CharacteristicProperties();
+            characteristics.push_back(
+                { toStr(characteristic.Uuid()), toPropertyArray(props), {}, {} });
+            AttributeKey key = { services[i].Uuid(), characteristic.Uuid() };
+            targets.push_back({ i, characteristics.size() - 1, characteristic, cacheMode(key) });
+            // descriptor discovery overlaps with the characteristic discovery of other services
+            descriptorOps.push_back(characteristic.GetDescriptorsAsync(targets.back().mode));
         }
     }
-    else
+
+    std::vector<std::vector<GattDescriptor>> descriptors(descriptorOps.size());
+    for (size_t i = 0; i < descriptorOps.size(); i++)
     {
-        LOGE("status: %d", status);
+        auto result = co_await descriptorOps[i];
+        auto& target = targets[i];
+        auto& characteristic =
+            tree[target.serviceIndex].characteristics[target.characteristicIndex];
+        characteristic.error = resultError(result);
+        if (characteristic.error)
+        {
+            LOGE("descriptors of characteristic %s: %s", characteristic.uuid.c_str(),
+                 characteristic.error.message.c_str());
+            if (!discovery->error)
+            {
+                discovery->error = { characteristic.error.status,
+                                     "descriptors of characteristic " + characteristic.uuid +
+                                         ": " + characteristic.error.message };
+            }
+            continue;
+        }
+        if (target.mode == BluetoothCacheMode::Uncached)
+        {
+            revalidated.push_back({ services[target.serviceIndex].Uuid(),
+                                    target.characteristic.Uuid() });
+        }
+        for (auto&& descriptor : result.Descriptors())
+        {
+            characteristic.descriptorUuids.push_back(toStr(descriptor.Uuid()));
+            descriptors[i].push_back(descriptor);
+        }
+    }
+
+    PeripheralWinrt& peripheral = Peripheral(uuid);
+    if (!peripheral.device.has_value())
+    {
+        discovery->error = { OperationStatus::NotConnected,
+                             "device disconnected during discovery" };
+        co_return;
+    }
+    for (auto& service : services)
+    {
+        peripheral.CacheService(service);
+    }
+    for (size_t i = 0; i < targets.size(); i++)
+    {
+        auto serviceUuid = services[targets[i].serviceIndex].Uuid();
+        auto& characteristic = targets[i].characteristic;
+        peripheral.CacheCharacteristic(serviceUuid, characteristic);
+        for (auto& descriptor : descriptors[i])
+        {
+            peripheral.CacheDescriptor(serviceUuid, characteristic.Uuid(), descriptor);
+        }
     }
+    for (auto& parent : revalidated)
+    {
+        peripheral.Discovered(parent, startedAt);
+    }
+    discovery->services = tree;
 }
 
-bool BLEManager::WriteHandle(const std::string& uuid, int handle, Data data)
+void BLEManager::OnAllDiscovered(IAsyncAction asyncOp, AsyncStatus status, const std::string& uuid,
+                                 const std::shared_ptr<DiscoveryResult>& discovery)
 {
-    CHECK_DEVICE();
-    IFDEVICE(device, uuid)
+    auto error = asyncError(asyncOp, status);
+    if (error)
     {
-        LOGE("not available");
-        return true;
+        mEmit.AllDiscovered(uuid, {}, error);
+        return;
     }
+    mEmit.AllDiscovered(uuid, discovery->services, discovery->error);
 }
 
-void BLEManager::OnWriteHandle(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status,
-                               const std::string uuid, const int handle)
+void BLEManager::SetCachePolicy(const GattCachePolicy& policy)
 {
-    if (status == AsyncStatus::Completed)
+    mCachePolicy = policy;
+    std::lock_guard<std::mutex> lock(mDeviceMapMutex);
+    for (auto& entry : mDeviceMap)
+    {
+        entry.second.SetLookupPolicy(policy.lookup);
+    }
+}
+
+const GattCachePolicy& BLEManager::GetCachePolicy() const
+{
+    return mCachePolicy;
+}
+
+void BLEManager::SetStaticCharacteristic(const winrt::guid& serviceUuid,
+                                         const winrt::guid& characteristicUuid, bool isStatic)
+{
+    AttributeKey key = { serviceUuid, characteristicUuid };
+    if (isStatic)
     {
-        mEmit.WriteHandle(uuid, handle);
+        mStaticCharacteristics.insert(key);
     }
     else
     {
-        LOGE("status %d", status);
+        mStaticCharacteristics.erase(key);
     }
 }
+
+bool BLEManager::IsStatic(const AttributeKey& key) const
+{
+    // the strings of the device information service don't change while connected
+    return key.service == GattServiceUuids::DeviceInformation() ||
+        mStaticCharacteristics.find(key) != mStaticCharacteristics.end();
+}
+
+PeripheralWinrt* BLEManager::FindPeripheral(const std::string& uuid)
+{
+    std::lock_guard<std::mutex> lock(mDeviceMapMutex);
+    auto it = mDeviceMap.find(uuid);
+    return it != mDeviceMap.end() ? &it->second : nullptr;
+}
+
+PeripheralWinrt& BLEManager::Peripheral(const std::string& uuid)
+{
+    std::lock_guard<std::mutex> lock(mDeviceMapMutex);
+    return mDeviceMap[uuid];
+}
+
+PeripheralWinrt& BLEManager::AddPeripheral(const std::string& uuid, PeripheralWinrt&& peripheral)
+{
+    std::lock_guard<std::mutex> lock(mDeviceMapMutex);
+    return mDeviceMap.emplace(uuid, std::move(peripheral)).first->second;
+}
+
+bool BLEManager::WriteStream(const std::string& uuid, const winrt::guid& serviceUuid,
+                             const winrt::guid& characteristicUuid, const Payload& data,
+                             size_t chunkSize, size_t window)
+{
+    std::string serviceId = toStr(serviceUuid);
+    std::string characteristicId = toStr(characteristicUuid);
+    auto onFailed = [=](const OperationError& error) {
+        mEmit.StreamDone(uuid, serviceId, characteristicId, 0, data.size, 0, error);
+    };
+    IFCONNECTED(device, uuid, onFailed)
+    {
+        // the stream holds one slot of the device queue until it has been written
+        mScheduler.Enqueue(uuid, OperationPriority::Write, [=, &peripheral](auto done) {
+            // a stream has no deadline but is cancelled when the device disconnects
+            auto operation = StartOperation(uuid, std::chrono::milliseconds(0), done, onFailed);
+            // by default every chunk fills a write command
+            size_t size = chunkSize > 0 ? chunkSize : maxWritePayload(peripheral.mtu);
+            auto onCharacteristic = [=](std::optional<GattCharacteristic> characteristic) {
+                if (!characteristic)
+                {
+                    operation->Fail({ OperationStatus::NotFound, "characteristic not found" });
+                    return;
+                }
+                auto properties = characteristic->CharacteristicProperties();
+                bool withoutResponse =
+                    (properties & GattCharacteristicProperties::WriteWithoutResponse) ==
+                    GattCharacteristicProperties::WriteWithoutResponse;
+                GattWriteOption option = withoutResponse ? GattWriteOption::WriteWithoutResponse
+                                                         : GattWriteOption::WriteWithResponse;
+                GattCharacteristic c = *characteristic;
+                auto write = [c, option, data](const uint8_t* chunk, size_t size,
+                                               StreamWriter::ChunkDone chunkDone) {
+                    auto value = payloadBuffer(data, chunk - data.data, size);
+                    try
+                    {
+                        c.WriteValueWithResultAsync(value, option)
+                            .Completed([chunkDone](IAsyncOperation<GattWriteResult> asyncOp,
+                                                   AsyncStatus status) {
+                                chunkDone(!asyncError(asyncOp, status));
+                            });
+                    }
+                    catch (const winrt::hresult_error& e)
+                    {
+                        LOGE("stream write failed: %s", winrt::to_string(e.message()).c_str());
+                        chunkDone(false);
+                    }
+                };
+                auto onProgress = [=](const StreamProgress& progress) {
+                    mEmit.StreamProgress(uuid, serviceId, characteristicId, progress.sent,
+                                         progress.total, progress.bytesPerSecond);
+                };
+                auto onDone = [=](bool success, const StreamProgress& progress) {
+                    if (!operation->Settle())
+                    {
+                        return;
+                    }
+                    OperationError error;
+                    if (!success)
+                    {
+                        error = { OperationStatus::Failed, "write failed" };
+                    }
+                    operation->Completed(error);
+                    mEmit.StreamDone(uuid, serviceId, characteristicId, progress.sent,
+                                     progress.total, progress.bytesPerSecond, error);
+                    done();
+                };
+                auto writer = StreamWriter::Create(data, size, window, write, onProgress, onDone);
+                operation->SetCancel([writer]() { writer->Cancel(); });
+                writer->Start();
+            };
+            peripheral.GetCharacteristic(serviceUuid, characteristicUuid, onCharacteristic);
+        });
+        return true;
+    }
+}
+
+void BLEManager::SetSchedulerLimits(size_t depth, size_t maxInFlight)
+{
+    mScheduler.SetLimits(depth, maxInFlight);
+}
+
+std::unordered_map<std::string, SchedulerStats> BLEManager::GetSchedulerStats() const
+{
+    return mScheduler.Stats();
+}
+
+void BLEManager::SetConnectLimit(size_t maxConcurrent)
+{
+    mConnects.SetLimit(maxConcurrent);
+}
+
+ConnectStats BLEManager::GetConnectStats() const
+{
+    return mConnects.Stats();
+}
+
+void BLEManager::SetReconnectPolicy(const ReconnectPolicy& policy)
+{
+    mReconnects.SetPolicy(policy);
+}
+
+ReconnectPolicy BLEManager::GetReconnectPolicy() const
+{
+    return mReconnects.GetPolicy();
+}
+
+ReconnectStats BLEManager::GetReconnectStats() const
+{
+    return mReconnects.Stats();
+}
+
+void BLEManager::SetTimeouts(const OperationTimeouts& timeouts)
+{
+    std::lock_guard<std::mutex> lock(mTimeoutsMutex);
+    mTimeouts = timeouts;
+}
+
+OperationTimeouts BLEManager::GetTimeouts() const
+{
+    // read by the operations on the scheduler, WinRT and timer threads
+    std::lock_guard<std::mutex> lock(mTimeoutsMutex);
+    return mTimeouts;
+}
+
+RetryTarget BLEManager::Retry(OperationClass operationClass)
+{
+    return { mRetryPolicies, mDeadlines, operationClass };
+}
+
+void BLEManager::SetRetryPolicy(OperationClass operationClass, const RetryPolicy& policy)
+{
+    mRetryPolicies.Set(operationClass, policy);
+}
+
+RetryPolicy BLEManager::GetRetryPolicy(OperationClass operationClass) const
+{
+    return mRetryPolicies.Get(operationClass);
+}
+
+std::array<RetryStats, OPERATION_CLASSES> BLEManager::GetRetryStats() const
+{
+    return mRetryPolicies.Stats();
+}
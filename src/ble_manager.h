@@ -10,14 +10,46 @@
 #include <winrt/Windows.Devices.Bluetooth.Advertisement.h>
 #include <winrt/Windows.Devices.Bluetooth.GenericAttributeProfile.h>
 
+#include "batch.h"
 #include "callbacks.h"
+#include "connect_queue.h"
+#include "deadline_timer.h"
+#include "gatt_scheduler.h"
+#include "link_health.h"
 #include "peripheral_winrt.h"
 #include "radio_watcher.h"
+#include "reconnect_tracker.h"
+#include "retry_policy.h"
 #include "notify_map.h"
 
+#include <mutex>
+#include <unordered_set>
+
 using namespace winrt::Windows::Devices::Bluetooth::GenericAttributeProfile;
 using namespace winrt::Windows::Devices::Bluetooth::Advertisement;
 using winrt::Windows::Foundation::AsyncStatus;
+using winrt::Windows::Foundation::IAsyncAction;
+
+struct DiscoveryResult
+{
+    std::vector<DiscoveredService> services;
+    OperationError error;
+};
+
+// where and with which policy a failed operation is retried
+struct RetryTarget
+{
+    RetryPolicies& policies;
+    DeadlineTimer& timer;
+    OperationClass operationClass;
+};
+
+struct WriteItem
+{
+    AttributeKey key;
+    Payload data;
+    bool withoutResponse;
+};
 
 class BLEManager
 {
@@ -26,43 +58,104 @@ public:
     BLEManager(const Napi::Value& receiver, const Napi::Function& callback);
     void Scan(const std::vector<winrt::guid>& serviceUUIDs, bool allowDuplicates);
     void StopScan();
-    bool Connect(const std::string& uuid);
+    // `id` is the uuid of a scanned device or the address of any device
+    bool Connect(const std::string& id, int priority = 0);
     bool Disconnect(const std::string& uuid);
     bool UpdateRSSI(const std::string& uuid);
-    bool DiscoverServices(const std::string& uuid, const std::vector<winrt::guid>& serviceUUIDs);
-    bool DiscoverIncludedServices(const std::string& uuid, const winrt::guid& serviceUuid, const std::vector<winrt::guid>& serviceUUIDs);
-    bool DiscoverCharacteristics(const std::string& uuid, const winrt::guid& service, const std::vector<winrt::guid>& characteristicUUIDs);
-    bool Read(const std::string& uuid, const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid);
-    bool Write(const std::string& uuid, const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid, const Data& data, bool withoutResponse);
-    bool Notify(const std::string& uuid, const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid, bool on);
-    bool DiscoverDescriptors(const std::string& uuid, const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid);
-    bool ReadValue(const std::string& uuid, const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid, const winrt::guid& descriptorUuid);
-    bool WriteValue(const std::string& uuid, const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid, const winrt::guid& descriptorUuid, const Data& data);
+    // requests the preset now if the device is connected and whenever it connects
+    bool SetConnectionMode(const std::string& uuid, ConnectionPreset preset);
+    std::optional<ConnectionParameters> GetConnectionParameters(const std::string& uuid);
+    // watches the link while the device is connected, nullopt stops watching
+    bool SetHealthMonitor(const std::string& uuid, std::optional<HealthOptions> options, std::optional<AttributeKey> probe);
+    std::optional<HealthSnapshot> GetLinkHealth(const std::string& uuid) const;
+    bool DiscoverServices(const std::string& uuid, const std::vector<winrt::guid>& serviceUUIDs, std::optional<CacheMode> cacheMode = std::nullopt);
+    bool DiscoverIncludedServices(const std::string& uuid, const winrt::guid& serviceUuid, const std::vector<winrt::guid>& serviceUUIDs, std::optional<CacheMode> cacheMode = std::nullopt);
+    bool DiscoverCharacteristics(const std::string& uuid, const winrt::guid& service, const std::vector<winrt::guid>& characteristicUUIDs, std::optional<CacheMode> cacheMode = std::nullopt);
+    bool Read(const std::string& uuid, const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid, std::optional<CacheMode> cacheMode = std::nullopt);
+    bool Write(const std::string& uuid, const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid, const Payload& data, bool withoutResponse);
+    bool Notify(const std::string& uuid, const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid, bool on, const std::string& subscriber = "", const SubscriberOptions& options = {});
+    void SetDecoder(const std::string& uuid, const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid, std::shared_ptr<const PayloadDecoder> decoder);
+    // the contexts of all subscriptions, they hold the statistics
+    std::vector<std::shared_ptr<SubscriptionContext>> GetNotifyStats();
+    // returns the ring that has been replaced
+    std::shared_ptr<NotifyRing> SetNotifyRing(const std::string& uuid, const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid, std::shared_ptr<NotifyRing> ring);
+    bool DiscoverDescriptors(const std::string& uuid, const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid, std::optional<CacheMode> cacheMode = std::nullopt);
+    bool ReadValue(const std::string& uuid, const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid, const winrt::guid& descriptorUuid, std::optional<CacheMode> cacheMode = std::nullopt);
+    bool WriteValue(const std::string& uuid, const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid, const winrt::guid& descriptorUuid, const Payload& data);
     bool ReadHandle(const std::string& uuid, int handle);
-    bool WriteHandle(const std::string& uuid, int handle, Data data);
+    bool WriteHandle(const std::string& uuid, int handle, const Payload& data);
+    bool WriteMany(const std::string& uuid, const std::vector<WriteItem>& items, bool reliable);
+    bool ReadMany(const std::string& uuid, const std::vector<AttributeKey>& characteristics, std::optional<CacheMode> cacheMode = std::nullopt);
+    bool DiscoverAll(const std::string& uuid, const std::vector<winrt::guid>& serviceUUIDs, std::optional<CacheMode> cacheMode = std::nullopt);
+    void SetCachePolicy(const GattCachePolicy& policy);
+    const GattCachePolicy& GetCachePolicy() const;
+    void SetStaticCharacteristic(const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid, bool isStatic);
+    bool WriteStream(const std::string& uuid, const winrt::guid& serviceUuid, const winrt::guid& characteristicUuid, const Payload& data, size_t chunkSize, size_t window);
+    void SetSchedulerLimits(size_t depth, size_t maxInFlight);
+    std::unordered_map<std::string, SchedulerStats> GetSchedulerStats() const;
+    void SetConnectLimit(size_t maxConcurrent);
+    ConnectStats GetConnectStats() const;
+    void SetReconnectPolicy(const ReconnectPolicy& policy);
+    ReconnectPolicy GetReconnectPolicy() const;
+    ReconnectStats GetReconnectStats() const;
+    void SetTimeouts(const OperationTimeouts& timeouts);
+    OperationTimeouts GetTimeouts() const;
+    void SetRetryPolicy(OperationClass operationClass, const RetryPolicy& policy);
+    RetryPolicy GetRetryPolicy(OperationClass operationClass) const;
+    std::array<RetryStats, OPERATION_CLASSES> GetRetryStats() const;
     // clang-format on
 
 private:
     // clang-format off
     void OnRadio(Radio& radio);
+    RetryTarget Retry(OperationClass operationClass);
+    std::shared_ptr<TimedOperation> StartOperation(const std::string& uuid, std::chrono::milliseconds timeout, GattScheduler::Done done, TimedOperation::OnFailed onFailed);
+    // wraps the completion handler of a discovery, an uncached one that succeeds revalidates the children of `parent`
+    template <typename H> auto Revalidating(const std::string& uuid, const AttributeKey& parent, BluetoothCacheMode mode, H handler);
     void OnScanResult(BluetoothLEAdvertisementWatcher watcher, const BluetoothLEAdvertisementReceivedEventArgs& args);
     void OnScanStopped(BluetoothLEAdvertisementWatcher watcher, const BluetoothLEAdvertisementWatcherStoppedEventArgs& args);
-    void OnConnected(IAsyncOperation<BluetoothLEDevice> asyncOp, AsyncStatus& status, std::string uuid);
+    // returns true if the device is connected
+    bool OnConnected(IAsyncOperation<BluetoothLEDevice> asyncOp, AsyncStatus status, const std::string& uuid);
     void OnConnectionStatusChanged(BluetoothLEDevice device, winrt::Windows::Foundation::IInspectable inspectable);
-    void OnServicesDiscovered(IAsyncOperation<GattDeviceServicesResult> asyncOp, AsyncStatus status, std::string uuid, std::vector<winrt::guid> serviceUUIDs);
-    void OnIncludedServicesDiscovered(IAsyncOperation<GattDeviceServicesResult> asyncOp, AsyncStatus status, std::string uuid, std::string serviceId, std::vector<winrt::guid> serviceUUIDs);
-    void OnCharacteristicsDiscovered(IAsyncOperation<GattCharacteristicsResult> asyncOp, AsyncStatus status, std::string uuid, std::string serviceId, std::vector<winrt::guid> characteristicUUIDs);
-    void OnRead(IAsyncOperation<GattReadResult> asyncOp, AsyncStatus status, std::string uuid, std::string serviceId, std::string characteristicId);
-    void OnWrite(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status, std::string uuid, std::string serviceId, std::string characteristicId);
-    void OnNotify(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status,  GattCharacteristic characteristic, std::string uuid, std::string serviceId, std::string characteristicId, bool state);
-    void OnValueChanged(GattCharacteristic chracteristic, const GattValueChangedEventArgs& args, std::string uuid);
-    void OnDescriptorsDiscovered(IAsyncOperation<GattDescriptorsResult> asyncOp, AsyncStatus status, std::string uuid, std::string serviceId, std::string characteristicId);
-    void OnReadValue(IAsyncOperation<GattReadResult> asyncOp, AsyncStatus status, std::string uuid, std::string serviceId, std::string characteristicId, std::string descriptorId);
-    void OnWriteValue(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status, std::string uuid, std::string serviceId, std::string characteristicId, std::string descriptorId);
-    void OnReadHandle(IAsyncOperation<GattReadResult> asyncOp, AsyncStatus status, std::string uuid, int handle);
-    void OnWriteHandle(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status, std::string uuid, int handle);
+    void Reconnect(const std::string& uuid);
+    // enables the notifications of the reconnected device again
+    void Rearm(const std::string& uuid);
+    void OnReconnectFailed(const std::string& uuid, const OperationError& error);
+    void ApplyConnectionMode(const std::string& uuid, PeripheralWinrt& peripheral);
+    void WatchHealth(const std::string& uuid, const HealthOptions& options);
+    void CheckHealth();
+    // reads the probe characteristic of the device, the result only counts towards its health
+    bool Probe(const std::string& uuid);
+    void OnSession(IAsyncOperation<GattSession> asyncOp, AsyncStatus status, const std::string& uuid);
+    void OnMtuChanged(GattSession session, winrt::Windows::Foundation::IInspectable inspectable, const std::string& uuid);
+    void OnServicesDiscovered(IAsyncOperation<GattDeviceServicesResult> asyncOp, AsyncStatus status, const std::string& uuid, const std::vector<winrt::guid>& serviceUUIDs);
+    void OnIncludedServicesDiscovered(IAsyncOperation<GattDeviceServicesResult> asyncOp, AsyncStatus status, const std::string& uuid, const std::string& serviceId, const std::vector<winrt::guid>& serviceUUIDs);
+    void OnCharacteristicsDiscovered(IAsyncOperation<GattCharacteristicsResult> asyncOp, AsyncStatus status, const std::string& uuid, const std::string& serviceId, const std::vector<winrt::guid>& characteristicUUIDs);
+    void OnRead(IAsyncOperation<GattReadResult> asyncOp, AsyncStatus status, const std::string& uuid, const std::string& serviceId, const std::string& characteristicId, const AttributeKey& key, bool cacheValue);
+    void OnWriteItem(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status, const std::shared_ptr<Batch<BatchItemResult>>& batch, size_t index, BatchItemResult item);
+    void WriteReliable(PeripheralWinrt& peripheral, const std::string& uuid, const std::vector<WriteItem>& items, std::shared_ptr<TimedOperation> operation, GattScheduler::Done done);
+    void OnWriteReliable(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status, const std::string& uuid, const std::vector<WriteItem>& items);
+    void WriteSegmented(GattCharacteristic characteristic, const std::string& uuid, const std::string& serviceId, const std::string& characteristicId, const Payload& data, size_t segmentSize, bool withoutResponse, std::shared_ptr<TimedOperation> operation, GattScheduler::Done done);
+    void OnReadItem(IAsyncOperation<GattReadResult> asyncOp, AsyncStatus status, const std::string& uuid, const std::shared_ptr<Batch<BatchItemResult>>& batch, size_t index, BatchItemResult item, const AttributeKey& key, bool cacheValue);
+    void OnWrite(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status, const std::string& uuid, const std::string& serviceId, const std::string& characteristicId);
+    void OnNotify(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status,  GattCharacteristic characteristic, const std::string& uuid, const SubscriptionKey& key, const std::shared_ptr<SubscriptionContext>& context, const std::string& serviceId, const std::string& characteristicId, bool state);
+    void OnValueChanged(GattCharacteristic chracteristic, const GattValueChangedEventArgs& args, const std::shared_ptr<SubscriptionContext>& context);
+    void OnDescriptorsDiscovered(IAsyncOperation<GattDescriptorsResult> asyncOp, AsyncStatus status, const std::string& uuid, const std::string& serviceId, const std::string& characteristicId);
+    void OnReadValue(IAsyncOperation<GattReadResult> asyncOp, AsyncStatus status, const std::string& uuid, const std::string& serviceId, const std::string& characteristicId, const std::string& descriptorId);
+    void OnWriteValue(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status, const std::string& uuid, const std::string& serviceId, const std::string& characteristicId, const std::string& descriptorId);
+    void OnReadHandle(IAsyncOperation<GattReadResult> asyncOp, AsyncStatus status, const std::string& uuid, int handle);
+    void OnWriteHandle(IAsyncOperation<GattWriteResult> asyncOp, AsyncStatus status, const std::string& uuid, int handle);
+    IAsyncAction DiscoverAllAsync(BluetoothLEDevice device, std::string uuid, std::vector<winrt::guid> serviceUUIDs, CachePolicy policy, std::shared_ptr<DiscoveryResult> discovery);
+    void OnAllDiscovered(IAsyncAction asyncOp, AsyncStatus status, const std::string& uuid, const std::shared_ptr<DiscoveryResult>& discovery);
+    bool IsStatic(const AttributeKey& key) const;
     // clang-format on
 
+    // The device map is used from the JS, WinRT, scheduler and timer threads. Entries are never
+    // removed, so a peripheral stays valid after the lock has been released.
+    PeripheralWinrt* FindPeripheral(const std::string& uuid);
+    PeripheralWinrt& Peripheral(const std::string& uuid);
+    PeripheralWinrt& AddPeripheral(const std::string& uuid, PeripheralWinrt&& peripheral);
+
     Emit mEmit;
     RadioWatcher mWatcher;
     AdapterState mRadioState;
@@ -71,7 +164,23 @@ private:
     winrt::event_revoker<IBluetoothLEAdvertisementWatcher> mStoppedRevoker;
     bool mAllowDuplicates;
 
+    std::mutex mDeviceMapMutex;
     std::unordered_map<std::string, PeripheralWinrt> mDeviceMap;
     std::set<std::string> mAdvertismentMap;
     NotifyMap mNotifyMap;
+    GattCachePolicy mCachePolicy;
+    std::unordered_set<AttributeKey, AttributeKeyHash> mStaticCharacteristics;
+    GattScheduler mScheduler;
+    ConnectQueue mConnects;
+    ReconnectTracker mReconnects;
+    // serializes the connection status handler with the steps of reconnecting, which run on the
+    // WinRT and timer threads. Recursive because failing a step can cancel the deadlines of the
+    // device, which fail the reconnect attempt in turn.
+    std::recursive_mutex mReconnectMutex;
+    LinkHealth mHealth;
+    mutable std::mutex mTimeoutsMutex;
+    OperationTimeouts mTimeouts;
+    RetryPolicies mRetryPolicies;
+    // destroyed first so that no deadline fires into the members above
+    DeadlineTimer mDeadlines;
 };
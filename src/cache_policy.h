@@ -0,0 +1,42 @@
+#pragma once
+
+#include <chrono>
+
+enum class CacheMode
+{
+    // always go to the device
+    Uncached,
+    // use cached results for as long as the device is connected
+    Cached,
+    // use cached results if they are younger than the ttl, revalidate otherwise
+    Ttl,
+};
+
+struct CachePolicy
+{
+    CacheMode mode = CacheMode::Uncached;
+    std::chrono::milliseconds ttl = std::chrono::milliseconds(0);
+
+    bool IsFresh(std::chrono::steady_clock::time_point fetched,
+                 std::chrono::steady_clock::time_point now) const
+    {
+        switch (mode)
+        {
+        case CacheMode::Cached:
+            return true;
+        case CacheMode::Ttl:
+            return fetched != std::chrono::steady_clock::time_point() && now - fetched < ttl;
+        default:
+            return false;
+        }
+    }
+};
+
+// The policy for each class of GATT operations, the defaults match the behaviour of noble:
+// discovery and reads always go to the device while attribute lookups use the Windows cache.
+struct GattCachePolicy
+{
+    CachePolicy discovery = { CacheMode::Uncached };
+    CachePolicy lookup = { CacheMode::Cached };
+    CachePolicy read = { CacheMode::Uncached };
+};
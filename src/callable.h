@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// A move-only std::function that keeps callables of up to `Capacity` bytes inline. Bigger ones
+// are still accepted and moved to the heap, so the capacity only decides what is free.
+template <typename Signature, size_t Capacity = 64> class Callable;
+
+template <typename R, typename... Args, size_t Capacity> class Callable<R(Args...), Capacity>
+{
+public:
+    Callable() noexcept = default;
+
+    Callable(std::nullptr_t) noexcept
+    {
+    }
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Callable>>>
+    Callable(F&& function)
+    {
+        using Stored = std::decay_t<F>;
+        if constexpr (IsInline<Stored>())
+        {
+            new (mStorage) Stored(std::forward<F>(function));
+            mOps = &InlineOps<Stored>::ops;
+        }
+        else
+        {
+            *reinterpret_cast<Stored**>(mStorage) = new Stored(std::forward<F>(function));
+            mOps = &HeapOps<Stored>::ops;
+        }
+    }
+
+    Callable(Callable&& other) noexcept
+    {
+        MoveFrom(other);
+    }
+
+    Callable& operator=(Callable&& other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    Callable& operator=(std::nullptr_t) noexcept
+    {
+        Reset();
+        return *this;
+    }
+
+    Callable(const Callable&) = delete;
+    Callable& operator=(const Callable&) = delete;
+
+    ~Callable()
+    {
+        Reset();
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return mOps != nullptr;
+    }
+
+    R operator()(Args... args) const
+    {
+        return mOps->invoke(const_cast<std::byte*>(mStorage), std::forward<Args>(args)...);
+    }
+
+private:
+    struct Ops
+    {
+        R (*invoke)(std::byte* storage, Args&&... args);
+        // move constructs into `to` and destroys `from`
+        void (*move)(std::byte* from, std::byte* to) noexcept;
+        void (*destroy)(std::byte* storage) noexcept;
+    };
+
+    template <typename F> static constexpr bool IsInline()
+    {
+        return sizeof(F) <= Capacity && alignof(F) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<F>;
+    }
+
+    template <typename F> struct InlineOps
+    {
+        static F* Get(std::byte* storage)
+        {
+            return std::launder(reinterpret_cast<F*>(storage));
+        }
+
+        static R Invoke(std::byte* storage, Args&&... args)
+        {
+            return (*Get(storage))(std::forward<Args>(args)...);
+        }
+
+        static void Move(std::byte* from, std::byte* to) noexcept
+        {
+            new (to) F(std::move(*Get(from)));
+            Get(from)->~F();
+        }
+
+        static void Destroy(std::byte* storage) noexcept
+        {
+            Get(storage)->~F();
+        }
+
+        static constexpr Ops ops = { &Invoke, &Move, &Destroy };
+    };
+
+    template <typename F> struct HeapOps
+    {
+        static F*& Get(std::byte* storage)
+        {
+            return *reinterpret_cast<F**>(storage);
+        }
+
+        static R Invoke(std::byte* storage, Args&&... args)
+        {
+            return (*Get(storage))(std::forward<Args>(args)...);
+        }
+
+        static void Move(std::byte* from, std::byte* to) noexcept
+        {
+            *reinterpret_cast<F**>(to) = Get(from);
+        }
+
+        static void Destroy(std::byte* storage) noexcept
+        {
+            delete Get(storage);
+        }
+
+        static constexpr Ops ops = { &Invoke, &Move, &Destroy };
+    };
+
+    void MoveFrom(Callable& other) noexcept
+    {
+        if (other.mOps)
+        {
+            other.mOps->move(other.mStorage, mStorage);
+            mOps = std::exchange(other.mOps, nullptr);
+        }
+    }
+
+    void Reset() noexcept
+    {
+        if (mOps)
+        {
+            std::exchange(mOps, nullptr)->destroy(mStorage);
+        }
+    }
+
+    alignas(std::max_align_t) std::byte mStorage[Capacity];
+    const Ops* mOps = nullptr;
+};
+
+// Binds a member function as a handler with two arguments, the bound arguments are passed by
+// reference so that handlers can take them as const references.
+template <typename O, typename M, class... Types> auto bind2(O* object, M method, Types&... args)
+{
+    return [object, method, args...](auto&& first, auto&& second) {
+        return (object->*method)(std::forward<decltype(first)>(first),
+                                 std::forward<decltype(second)>(second), args...);
+    };
+}
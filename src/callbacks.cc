@@ -13,12 +13,17 @@
 #define _n(val) Napi::Number::New(env, val)
 #define _u(str) toUuid(env, str)
 
-Napi::String toUuid(Napi::Env& env, const std::string& uuid)
+std::string formatUuid(const std::string& uuid)
 {
     std::string str(uuid);
     str.erase(std::remove(str.begin(), str.end(), '-'), str.end());
     std::transform(str.begin(), str.end(), str.begin(), ::tolower);
-    return _s(str);
+    return str;
+}
+
+Napi::String toUuid(Napi::Env& env, const std::string& uuid)
+{
+    return _s(formatUuid(uuid));
 }
 
 Napi::String toAddressType(Napi::Env& env, const AddressType& type)
@@ -34,6 +39,18 @@ Napi::String toAddressType(Napi::Env& env, const AddressType& type)
     return _s("unknown");
 }
 
+// null on success, otherwise an Error with the status code
+Napi::Value toError(Napi::Env& env, const OperationError& error)
+{
+    if (!error)
+    {
+        return env.Null();
+    }
+    auto object = Napi::Error::New(env, error.message).Value();
+    object.Set(_s("status"), _n(static_cast<int>(error.status)));
+    return object;
+}
+
 Napi::Buffer<uint8_t> toBuffer(Napi::Env& env, const Data& data)
 {
     if (data.empty())
@@ -43,6 +60,16 @@ Napi::Buffer<uint8_t> toBuffer(Napi::Env& env, const Data& data)
     return Napi::Buffer<uint8_t>::Copy(env, &data[0], data.size());
 }
 
+// the one copy of a payload on its way to JS
+Napi::Buffer<uint8_t> toBuffer(Napi::Env& env, const Payload& data)
+{
+    if (data.empty())
+    {
+        return Napi::Buffer<uint8_t>::New(env, 0);
+    }
+    return Napi::Buffer<uint8_t>::Copy(env, data.data, data.size);
+}
+
 Napi::Array toUuidArray(Napi::Env& env, const std::vector<std::string>& data)
 {
     if (data.empty())
@@ -142,6 +169,16 @@ void Emit::Disconnected(const std::string& uuid)
     });
 }
 
+void Emit::Restored(const std::string& uuid, std::chrono::microseconds latency,
+                    size_t subscriptions)
+{
+    mCallback->call([uuid, latency, subscriptions](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('restored', deviceUuid, latencyMs, subscriptions);
+        args = { _s("restored"), _u(uuid), _n(latency.count() / 1000.0),
+                 _n(static_cast<double>(subscriptions)) };
+    });
+}
+
 void Emit::RSSI(const std::string& uuid, int rssi)
 {
     mCallback->call([uuid, rssi](Napi::Env env, std::vector<napi_value>& args) {
@@ -150,31 +187,36 @@ void Emit::RSSI(const std::string& uuid, int rssi)
     });
 }
 
-void Emit::ServicesDiscovered(const std::string& uuid, const std::vector<std::string>& serviceUuids)
+void Emit::ServicesDiscovered(const std::string& uuid, const std::vector<std::string>& serviceUuids,
+                              const OperationError& error)
 {
-    mCallback->call([uuid, serviceUuids](Napi::Env env, std::vector<napi_value>& args) {
-        // emit('servicesDiscover', deviceUuid, serviceUuids)
-        args = { _s("servicesDiscover"), _u(uuid), toUuidArray(env, serviceUuids) };
+    mCallback->call([uuid, serviceUuids, error](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('servicesDiscover', deviceUuid, serviceUuids, error)
+        args = { _s("servicesDiscover"), _u(uuid), toUuidArray(env, serviceUuids),
+                 toError(env, error) };
     });
 }
 
 void Emit::IncludedServicesDiscovered(const std::string& uuid, const std::string& serviceUuid,
-                                      const std::vector<std::string>& serviceUuids)
+                                      const std::vector<std::string>& serviceUuids,
+                                      const OperationError& error)
 {
     mCallback->call(
-        [uuid, serviceUuid, serviceUuids](Napi::Env env, std::vector<napi_value>& args) {
-            // emit('includedServicesDiscover', deviceUuid, serviceUuid, includedServiceUuids)
+        [uuid, serviceUuid, serviceUuids, error](Napi::Env env, std::vector<napi_value>& args) {
+            // emit('includedServicesDiscover', deviceUuid, serviceUuid, includedServiceUuids,
+            // error)
             args = { _s("includedServicesDiscover"), _u(uuid), _u(serviceUuid),
-                     toUuidArray(env, serviceUuids) };
+                     toUuidArray(env, serviceUuids), toError(env, error) };
         });
 }
 
 void Emit::CharacteristicsDiscovered(
     const std::string& uuid, const std::string& serviceUuid,
-    const std::vector<std::pair<std::string, std::vector<std::string>>>& characteristics)
+    const std::vector<std::pair<std::string, std::vector<std::string>>>& characteristics,
+    const OperationError& error)
 {
     mCallback->call(
-        [uuid, serviceUuid, characteristics](Napi::Env env, std::vector<napi_value>& args) {
+        [uuid, serviceUuid, characteristics, error](Napi::Env env, std::vector<napi_value>& args) {
             auto arr = characteristics.empty() ? Napi::Array::New(env)
                                                : Napi::Array::New(env, characteristics.size());
             for (size_t i = 0; i < characteristics.size(); i++)
@@ -185,90 +227,308 @@ void Emit::CharacteristicsDiscovered(
                 arr.Set(i, characteristic);
             }
             // emit('characteristicsDiscover', deviceUuid, serviceUuid, { uuid, properties:
-            // ['broadcast', 'read', ...]})
-            args = { _s("characteristicsDiscover"), _u(uuid), _u(serviceUuid), arr };
+            // ['broadcast', 'read', ...]}, error)
+            args = { _s("characteristicsDiscover"), _u(uuid), _u(serviceUuid), arr,
+                     toError(env, error) };
         });
 }
 
 void Emit::Read(const std::string& uuid, const std::string& serviceUuid,
-                const std::string& characteristicUuid, const Data& data, bool isNotification)
+                const std::string& characteristicUuid, const Payload& data, bool isNotification,
+                const OperationError& error)
 {
-    mCallback->call([uuid, serviceUuid, characteristicUuid, data,
-                     isNotification](Napi::Env env, std::vector<napi_value>& args) {
-        // emit('read', deviceUuid, serviceUuid, characteristicsUuid, data, isNotification);
-        args = { _s("read"),          _u(uuid),          _u(serviceUuid), _u(characteristicUuid),
-                 toBuffer(env, data), _b(isNotification) };
+    mCallback->call([uuid, serviceUuid, characteristicUuid, data, isNotification,
+                     error](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('read', deviceUuid, serviceUuid, characteristicsUuid, data, isNotification,
+        // error);
+        args = { _s("read"),          _u(uuid),           _u(serviceUuid), _u(characteristicUuid),
+                 toBuffer(env, data), _b(isNotification), toError(env, error) };
+    });
+}
+
+void Emit::Notification(const std::shared_ptr<SubscriptionContext>& context, const Payload& data,
+                        const SubscriberIds& subscribers, NotifyStats::Clock::time_point arrival)
+{
+    mCallback->call([context, data, subscribers, arrival](Napi::Env env,
+                                                          std::vector<napi_value>& args) {
+        context->stats.Dispatched(arrival, NotifyStats::Clock::now());
+        // emit('read', deviceUuid, serviceUuid, characteristicsUuid, data, isNotification,
+        // error, subscribers);
+        args = { _s("read"),
+                 _s(context->uuid),
+                 _s(context->serviceUuid),
+                 _s(context->characteristicUuid),
+                 toBuffer(env, data),
+                 _b(true),
+                 env.Null(),
+                 toArray(env, *subscribers) };
+    });
+}
+
+void Emit::Decoded(const std::shared_ptr<SubscriptionContext>& context, DecodedValues values,
+                   const SubscriberIds& subscribers, NotifyStats::Clock::time_point arrival)
+{
+    mCallback->call([context, values = std::move(values), subscribers,
+                     arrival](Napi::Env env, std::vector<napi_value>& args) {
+        context->stats.Dispatched(arrival, NotifyStats::Clock::now());
+        Napi::Value array;
+        if (values.output == DecoderOutput::Int32)
+        {
+            auto ints = Napi::Int32Array::New(env, values.ints.size());
+            std::copy(values.ints.begin(), values.ints.end(), ints.Data());
+            array = ints;
+        }
+        else
+        {
+            auto floats = Napi::Float32Array::New(env, values.floats.size());
+            std::copy(values.floats.begin(), values.floats.end(), floats.Data());
+            array = floats;
+        }
+        // emit('decoded', deviceUuid, serviceUuid, characteristicUuid, values, rows, subscribers)
+        args = { _s("decoded"),
+                 _s(context->uuid),
+                 _s(context->serviceUuid),
+                 _s(context->characteristicUuid),
+                 array,
+                 _n(static_cast<double>(values.rows)),
+                 toArray(env, *subscribers) };
     });
 }
 
 void Emit::Write(const std::string& uuid, const std::string& serviceUuid,
-                 const std::string& characteristicUuid)
+                 const std::string& characteristicUuid, const OperationError& error)
 {
-    mCallback->call(
-        [uuid, serviceUuid, characteristicUuid](Napi::Env env, std::vector<napi_value>& args) {
-            // emit('write', deviceUuid, servicesUuid, characteristicsUuid)
-            args = { _s("write"), _u(uuid), _u(serviceUuid), _u(characteristicUuid) };
-        });
+    mCallback->call([uuid, serviceUuid, characteristicUuid, error](Napi::Env env,
+                                                                   std::vector<napi_value>& args) {
+        // emit('write', deviceUuid, servicesUuid, characteristicsUuid, error)
+        args = { _s("write"), _u(uuid), _u(serviceUuid), _u(characteristicUuid),
+                 toError(env, error) };
+    });
 }
 
 void Emit::Notify(const std::string& uuid, const std::string& serviceUuid,
-                  const std::string& characteristicUuid, bool state)
+                  const std::string& characteristicUuid, bool state,
+                  const OperationError& error)
 {
-    mCallback->call([uuid, serviceUuid, characteristicUuid, state](Napi::Env env,
-                                                                   std::vector<napi_value>& args) {
-        // emit('notify', deviceUuid, servicesUuid, characteristicsUuid, state)
-        args = { _s("notify"), _u(uuid), _u(serviceUuid), _u(characteristicUuid), _b(state) };
+    mCallback->call([uuid, serviceUuid, characteristicUuid, state,
+                     error](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('notify', deviceUuid, servicesUuid, characteristicsUuid, state, error)
+        args = { _s("notify"), _u(uuid), _u(serviceUuid), _u(characteristicUuid), _b(state),
+                 toError(env, error) };
     });
 }
 
 void Emit::DescriptorsDiscovered(const std::string& uuid, const std::string& serviceUuid,
                                  const std::string& characteristicUuid,
-                                 const std::vector<std::string>& descriptorUuids)
+                                 const std::vector<std::string>& descriptorUuids,
+                                 const OperationError& error)
 {
-    mCallback->call([uuid, serviceUuid, characteristicUuid,
-                     descriptorUuids](Napi::Env env, std::vector<napi_value>& args) {
+    mCallback->call([uuid, serviceUuid, characteristicUuid, descriptorUuids,
+                     error](Napi::Env env, std::vector<napi_value>& args) {
         // emit('descriptorsDiscover', deviceUuid, servicesUuid, characteristicsUuid, descriptors:
-        // [uuids])
+        // [uuids], error)
         args = { _s("descriptorsDiscover"), _u(uuid), _u(serviceUuid), _u(characteristicUuid),
-                 toUuidArray(env, descriptorUuids) };
+                 toUuidArray(env, descriptorUuids), toError(env, error) };
     });
 }
 
 void Emit::ReadValue(const std::string& uuid, const std::string& serviceUuid,
                      const std::string& characteristicUuid, const std::string& descriptorUuid,
-                     const Data& data)
+                     const Payload& data, const OperationError& error)
 {
-    mCallback->call([uuid, serviceUuid, characteristicUuid, descriptorUuid,
-                     data](Napi::Env env, std::vector<napi_value>& args) {
-        // emit('valueRead', deviceUuid, serviceUuid, characteristicUuid, descriptorUuid, data)
+    mCallback->call([uuid, serviceUuid, characteristicUuid, descriptorUuid, data,
+                     error](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('valueRead', deviceUuid, serviceUuid, characteristicUuid, descriptorUuid, data,
+        // error)
         args = { _s("valueRead"),        _u(uuid),           _u(serviceUuid),
-                 _u(characteristicUuid), _u(descriptorUuid), toBuffer(env, data) };
+                 _u(characteristicUuid), _u(descriptorUuid), toBuffer(env, data),
+                 toError(env, error) };
     });
 }
 
 void Emit::WriteValue(const std::string& uuid, const std::string& serviceUuid,
-                      const std::string& characteristicUuid, const std::string& descriptorUuid)
+                      const std::string& characteristicUuid, const std::string& descriptorUuid,
+                      const OperationError& error)
+{
+    mCallback->call([uuid, serviceUuid, characteristicUuid, descriptorUuid,
+                     error](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('valueWrite', deviceUuid, serviceUuid, characteristicUuid, descriptorUuid,
+        // error);
+        args = { _s("valueWrite"),     _u(uuid),           _u(serviceUuid),
+                 _u(characteristicUuid), _u(descriptorUuid), toError(env, error) };
+    });
+}
+
+void Emit::ReadHandle(const std::string& uuid, int descriptorHandle, const Payload& data,
+                      const OperationError& error)
+{
+    mCallback->call(
+        [uuid, descriptorHandle, data, error](Napi::Env env, std::vector<napi_value>& args) {
+            // emit('handleRead', deviceUuid, descriptorHandle, data, error);
+            args = { _s("handleRead"), _u(uuid), _n(descriptorHandle), toBuffer(env, data),
+                     toError(env, error) };
+        });
+}
+
+void Emit::WriteHandle(const std::string& uuid, int descriptorHandle,
+                       const OperationError& error)
+{
+    mCallback->call([uuid, descriptorHandle, error](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('handleWrite', deviceUuid, descriptorHandle, error);
+        args = { _s("handleWrite"), _u(uuid), _n(descriptorHandle), toError(env, error) };
+    });
+}
+
+void Emit::Mtu(const std::string& uuid, int mtu)
+{
+    mCallback->call([uuid, mtu](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('onMtu', deviceUuid, mtu);
+        args = { _s("onMtu"), _u(uuid), _n(mtu) };
+    });
+}
+
+Napi::Value toConnectionParameters(Napi::Env& env,
+                                   const std::optional<ConnectionParameters>& parameters)
 {
-    mCallback->call([uuid, serviceUuid, characteristicUuid,
-                     descriptorUuid](Napi::Env env, std::vector<napi_value>& args) {
-        // emit('valueWrite', deviceUuid, serviceUuid, characteristicUuid, descriptorUuid);
-        args = { _s("valueWrite"), _u(uuid), _u(serviceUuid), _u(characteristicUuid),
-                 _u(descriptorUuid) };
+    if (!parameters)
+    {
+        return env.Null();
+    }
+    auto object = Napi::Object::New(env);
+    object.Set(_s("intervalMs"), _n(parameters->IntervalMs()));
+    object.Set(_s("latency"), _n(parameters->latency));
+    object.Set(_s("timeoutMs"), _n(parameters->TimeoutMs()));
+    return object;
+}
+
+void Emit::ConnectionMode(const std::string& uuid, const PresetResult& result)
+{
+    mCallback->call([uuid, result](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('connectionMode', deviceUuid, requested, applied, parameters, status);
+        auto applied = result.applied
+            ? _s(CONNECTION_PRESET_NAMES[static_cast<int>(*result.applied)])
+            : env.Null();
+        args = { _s("connectionMode"),
+                 _u(uuid),
+                 _s(CONNECTION_PRESET_NAMES[static_cast<int>(result.requested)]),
+                 applied,
+                 toConnectionParameters(env, result.parameters),
+                 _n(static_cast<int>(result.status)) };
+    });
+}
+
+void Emit::Health(const std::string& uuid, LinkState state, std::chrono::milliseconds silent)
+{
+    const char* names[] = { "healthy", "degraded", "stale" };
+    auto name = names[static_cast<int>(state)];
+    mCallback->call([uuid, name, silent](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('degraded' | 'stale' | 'healthy', deviceUuid, silentMs);
+        args = { _s(name), _u(uuid), _n(static_cast<double>(silent.count())) };
+    });
+}
+
+Napi::Array toBatchResults(Napi::Env& env, const std::vector<BatchItemResult>& results,
+                           bool withData)
+{
+    auto array = Napi::Array::New(env, results.size());
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        auto& result = results[i];
+        auto item = Napi::Object::New(env);
+        item.Set(_s("serviceUuid"), _u(result.serviceUuid));
+        item.Set(_s("characteristicUuid"), _u(result.characteristicUuid));
+        if (withData)
+        {
+            item.Set(_s("data"), result.error ? env.Null() : toBuffer(env, result.data));
+        }
+        item.Set(_s("error"), toError(env, result.error));
+        array.Set(i, item);
+    }
+    return array;
+}
+
+void Emit::ReadMany(const std::string& uuid, const std::vector<BatchItemResult>& results)
+{
+    mCallback->call([uuid, results](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('readMany', deviceUuid, [{ serviceUuid, characteristicUuid, data, error }])
+        args = { _s("readMany"), _u(uuid), toBatchResults(env, results, true) };
+    });
+}
+
+void Emit::WriteMany(const std::string& uuid, const std::vector<BatchItemResult>& results)
+{
+    mCallback->call([uuid, results](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('writeMany', deviceUuid, [{ serviceUuid, characteristicUuid, error }])
+        args = { _s("writeMany"), _u(uuid), toBatchResults(env, results, false) };
+    });
+}
+
+void Emit::AllDiscovered(const std::string& uuid, const std::vector<DiscoveredService>& services,
+                         const OperationError& error)
+{
+    mCallback->call([uuid, services, error](Napi::Env env, std::vector<napi_value>& args) {
+        auto arr =
+            services.empty() ? Napi::Array::New(env) : Napi::Array::New(env, services.size());
+        for (size_t i = 0; i < services.size(); i++)
+        {
+            auto& characteristics = services[i].characteristics;
+            auto chars = characteristics.empty() ? Napi::Array::New(env)
+                                                 : Napi::Array::New(env, characteristics.size());
+            for (size_t j = 0; j < characteristics.size(); j++)
+            {
+                Napi::Object characteristic = Napi::Object::New(env);
+                characteristic.Set(_s("uuid"), _u(characteristics[j].uuid));
+                characteristic.Set(_s("properties"), toArray(env, characteristics[j].properties));
+                characteristic.Set(_s("descriptors"),
+                                   toUuidArray(env, characteristics[j].descriptorUuids));
+                characteristic.Set(_s("error"), toError(env, characteristics[j].error));
+                chars.Set(j, characteristic);
+            }
+            Napi::Object service = Napi::Object::New(env);
+            service.Set(_s("uuid"), _u(services[i].uuid));
+            service.Set(_s("characteristics"), chars);
+            service.Set(_s("error"), toError(env, services[i].error));
+            arr.Set(i, service);
+        }
+        // emit('allDiscover', deviceUuid, [{ uuid, characteristics: [{ uuid, properties,
+        // descriptors: [uuids], error }], error }], error)
+        args = { _s("allDiscover"), _u(uuid), arr, toError(env, error) };
     });
 }
 
-void Emit::ReadHandle(const std::string& uuid, int descriptorHandle, const Data& data)
+void Emit::StreamProgress(const std::string& uuid, const std::string& serviceUuid,
+                          const std::string& characteristicUuid, size_t sent, size_t total,
+                          double bytesPerSecond)
 {
-    mCallback->call([uuid, descriptorHandle, data](Napi::Env env, std::vector<napi_value>& args) {
-        // emit('handleRead', deviceUuid, descriptorHandle, data);
-        args = { _s("handleRead"), _u(uuid), _n(descriptorHandle), toBuffer(env, data) };
+    mCallback->call([uuid, serviceUuid, characteristicUuid, sent, total,
+                     bytesPerSecond](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('writeStreamProgress', deviceUuid, serviceUuid, characteristicUuid, sent, total,
+        // bytesPerSecond)
+        args = { _s("writeStreamProgress"),
+                 _u(uuid),
+                 _u(serviceUuid),
+                 _u(characteristicUuid),
+                 _n(static_cast<double>(sent)),
+                 _n(static_cast<double>(total)),
+                 _n(bytesPerSecond) };
     });
 }
 
-void Emit::WriteHandle(const std::string& uuid, int descriptorHandle)
+void Emit::StreamDone(const std::string& uuid, const std::string& serviceUuid,
+                      const std::string& characteristicUuid, size_t sent, size_t total,
+                      double bytesPerSecond, const OperationError& error)
 {
-    mCallback->call([uuid, descriptorHandle](Napi::Env env, std::vector<napi_value>& args) {
-        // emit('handleWrite', deviceUuid, descriptorHandle);
-        args = { _s("handleWrite"), _u(uuid), _n(descriptorHandle) };
+    mCallback->call([uuid, serviceUuid, characteristicUuid, sent, total, bytesPerSecond,
+                     error](Napi::Env env, std::vector<napi_value>& args) {
+        // emit('writeStreamDone', deviceUuid, serviceUuid, characteristicUuid, sent, total,
+        // bytesPerSecond, error)
+        args = { _s("writeStreamDone"),
+                 _u(uuid),
+                 _u(serviceUuid),
+                 _u(characteristicUuid),
+                 _n(static_cast<double>(sent)),
+                 _n(static_cast<double>(total)),
+                 _n(bytesPerSecond),
+                 toError(env, error) };
     });
 }
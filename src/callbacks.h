@@ -1,10 +1,15 @@
 #pragma once
 
 #include <napi.h>
+#include "connection_mode.h"
+#include "link_health.h"
 #include "peripheral.h"
 
 class ThreadSafeCallback;
 
+// lowercase without dashes, how uuids and addresses are emitted
+std::string formatUuid(const std::string& uuid);
+
 class Emit
 {
 public:
@@ -15,18 +20,29 @@ public:
     void Scan(const std::string& uuid, int rssi, const Peripheral& peripheral);
     void Connected(const std::string& uuid, const std::string& error = "");
     void Disconnected(const std::string& uuid);
+    void Restored(const std::string& uuid, std::chrono::microseconds latency, size_t subscriptions);
     void RSSI(const std::string& uuid, int rssi);
-    void ServicesDiscovered(const std::string& uuid, const std::vector<std::string>& serviceUuids);
-    void IncludedServicesDiscovered(const std::string& uuid, const std::string& serviceUuid, const std::vector<std::string>& serviceUuids);
-    void CharacteristicsDiscovered(const std::string& uuid, const std::string& serviceUuid, const std::vector<std::pair<std::string, std::vector<std::string>>>& characteristics);
-    void Read(const std::string& uuid, const std::string& serviceUuid, const std::string& characteristicUuid, const Data& data, bool isNotification);
-    void Write(const std::string& uuid, const std::string& serviceUuid, const std::string& characteristicUuid);
-    void Notify(const std::string& uuid, const std::string& serviceUuid, const std::string& characteristicUuid, bool state);
-    void DescriptorsDiscovered(const std::string& uuid, const std::string& serviceUuid, const std::string& characteristicUuid, const std::vector<std::string>& descriptorUuids);
-    void ReadValue(const std::string& uuid, const std::string& serviceUuid, const std::string& characteristicUuid, const std::string& descriptorUuid, const Data& data);
-    void WriteValue(const std::string& uuid, const std::string& serviceUuid, const std::string& characteristicUuid, const std::string& descriptorUuid);
-    void ReadHandle(const std::string& uuid, int descriptorHandle, const Data& data);
-    void WriteHandle(const std::string& uuid, int descriptorHandle);
+    void ServicesDiscovered(const std::string& uuid, const std::vector<std::string>& serviceUuids, const OperationError& error = {});
+    void IncludedServicesDiscovered(const std::string& uuid, const std::string& serviceUuid, const std::vector<std::string>& serviceUuids, const OperationError& error = {});
+    void CharacteristicsDiscovered(const std::string& uuid, const std::string& serviceUuid, const std::vector<std::pair<std::string, std::vector<std::string>>>& characteristics, const OperationError& error = {});
+    void Read(const std::string& uuid, const std::string& serviceUuid, const std::string& characteristicUuid, const Payload& data, bool isNotification, const OperationError& error = {});
+    void Write(const std::string& uuid, const std::string& serviceUuid, const std::string& characteristicUuid, const OperationError& error = {});
+    void Notification(const std::shared_ptr<SubscriptionContext>& context, const Payload& data, const SubscriberIds& subscribers, NotifyStats::Clock::time_point arrival);
+    void Decoded(const std::shared_ptr<SubscriptionContext>& context, DecodedValues values, const SubscriberIds& subscribers, NotifyStats::Clock::time_point arrival);
+    void Notify(const std::string& uuid, const std::string& serviceUuid, const std::string& characteristicUuid, bool state, const OperationError& error = {});
+    void DescriptorsDiscovered(const std::string& uuid, const std::string& serviceUuid, const std::string& characteristicUuid, const std::vector<std::string>& descriptorUuids, const OperationError& error = {});
+    void ReadValue(const std::string& uuid, const std::string& serviceUuid, const std::string& characteristicUuid, const std::string& descriptorUuid, const Payload& data, const OperationError& error = {});
+    void WriteValue(const std::string& uuid, const std::string& serviceUuid, const std::string& characteristicUuid, const std::string& descriptorUuid, const OperationError& error = {});
+    void ReadHandle(const std::string& uuid, int descriptorHandle, const Payload& data, const OperationError& error = {});
+    void WriteHandle(const std::string& uuid, int descriptorHandle, const OperationError& error = {});
+    void StreamProgress(const std::string& uuid, const std::string& serviceUuid, const std::string& characteristicUuid, size_t sent, size_t total, double bytesPerSecond);
+    void StreamDone(const std::string& uuid, const std::string& serviceUuid, const std::string& characteristicUuid, size_t sent, size_t total, double bytesPerSecond, const OperationError& error = {});
+    void Mtu(const std::string& uuid, int mtu);
+    void ConnectionMode(const std::string& uuid, const PresetResult& result);
+    void Health(const std::string& uuid, LinkState state, std::chrono::milliseconds silent);
+    void ReadMany(const std::string& uuid, const std::vector<BatchItemResult>& results);
+    void WriteMany(const std::string& uuid, const std::vector<BatchItemResult>& results);
+    void AllDiscovered(const std::string& uuid, const std::vector<DiscoveredService>& services, const OperationError& error = {});
     // clang-format on
 protected:
     std::shared_ptr<ThreadSafeCallback> mCallback;
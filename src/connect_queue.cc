@@ -0,0 +1,145 @@
+#include "connect_queue.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "scope_exit.h"
+
+ConnectQueue::ConnectQueue(size_t maxConcurrent)
+    : mMaxConcurrent(std::max<size_t>(maxConcurrent, 1))
+{
+}
+
+void ConnectQueue::SetLimit(size_t maxConcurrent)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mMaxConcurrent = std::max<size_t>(maxConcurrent, 1);
+    }
+    Pump();
+}
+
+bool ConnectQueue::Enqueue(const std::string& device, int priority, Attempt attempt)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mDevices.insert(device).second)
+        {
+            return false;
+        }
+        auto key = std::make_pair(priority, mSequence++);
+        mPending.emplace(key, Pending{ device, std::move(attempt), Clock::now() });
+        mStats.queued++;
+        mStats.pending++;
+    }
+    Pump();
+    return true;
+}
+
+bool ConnectQueue::Cancel(const std::string& device)
+{
+    Attempt attempt;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = std::find_if(mPending.begin(), mPending.end(),
+                               [&](const auto& entry) { return entry.second.device == device; });
+        if (it == mPending.end())
+        {
+            return false;
+        }
+        // destroyed outside of the lock
+        attempt = std::move(it->second.attempt);
+        mPending.erase(it);
+        mDevices.erase(device);
+        mStats.pending--;
+    }
+    return true;
+}
+
+ConnectStats ConnectQueue::Stats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
+
+void ConnectQueue::Pump()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mPumping)
+        {
+            // attempts that finish synchronously don't recurse, the running pump starts the next
+            return;
+        }
+        mPumping = true;
+    }
+    ScopeExit stopPumping([this]() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPumping = false;
+    });
+    while (true)
+    {
+        std::vector<Pending> ready;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            while (mStats.inFlight < mMaxConcurrent && !mPending.empty())
+            {
+                ready.push_back(std::move(mPending.begin()->second));
+                mPending.erase(mPending.begin());
+                mStats.pending--;
+                mStats.inFlight++;
+            }
+            if (ready.empty())
+            {
+                mPumping = false;
+                stopPumping.Dismiss();
+                return;
+            }
+        }
+        for (auto& pending : ready)
+        {
+            auto device = pending.device;
+            auto queuedAt = pending.queuedAt;
+            // an attempt that throws while starting has failed, its slot is released only once
+            auto finished = std::make_shared<std::atomic<bool>>(false);
+            Done done = [this, device, queuedAt, finished](bool connected) {
+                if (!finished->exchange(true))
+                {
+                    Finish(device, queuedAt, connected);
+                }
+            };
+            try
+            {
+                pending.attempt(done);
+            }
+            catch (...)
+            {
+                done(false);
+            }
+        }
+    }
+}
+
+void ConnectQueue::Finish(const std::string& device, Clock::time_point queuedAt, bool connected)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDevices.erase(device);
+        mStats.inFlight--;
+        if (connected)
+        {
+            auto time =
+                std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - queuedAt);
+            mStats.connected++;
+            mStats.totalConnectTime += time;
+            mStats.maxConnectTime = std::max(mStats.maxConnectTime, time);
+        }
+        else
+        {
+            mStats.failed++;
+        }
+    }
+    Pump();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+
+#include "callable.h"
+
+struct ConnectStats
+{
+    uint64_t queued = 0;
+    uint64_t connected = 0;
+    uint64_t failed = 0;
+    size_t pending = 0;
+    size_t inFlight = 0;
+    // from queueing a connection until it is connected
+    std::chrono::microseconds totalConnectTime = std::chrono::microseconds(0);
+    std::chrono::microseconds maxConnectTime = std::chrono::microseconds(0);
+};
+
+// Starts connection attempts with at most `maxConcurrent` of them in flight so that bringing up
+// many devices doesn't overload the adapter. Lower priorities are started first, attempts of the
+// same priority in the order in which they were queued.
+class ConnectQueue
+{
+public:
+    using Done = std::function<void(bool connected)>;
+    // starts the attempt, `done` has to be called when it has finished, further calls are
+    // ignored. An attempt that throws has failed.
+    using Attempt = Callable<void(Done done), 128>;
+
+    explicit ConnectQueue(size_t maxConcurrent = 4);
+
+    void SetLimit(size_t maxConcurrent);
+    // Returns false and drops the attempt if the device is already queued or connecting.
+    bool Enqueue(const std::string& device, int priority, Attempt attempt);
+    // Removes an attempt that hasn't been started, returns false if there is none.
+    bool Cancel(const std::string& device);
+    ConnectStats Stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending
+    {
+        std::string device;
+        Attempt attempt;
+        Clock::time_point queuedAt;
+    };
+
+    void Pump();
+    void Finish(const std::string& device, Clock::time_point queuedAt, bool connected);
+
+    mutable std::mutex mMutex;
+    size_t mMaxConcurrent;
+    bool mPumping = false;
+    uint64_t mSequence = 0;
+    // ordered by priority and then by sequence
+    std::map<std::pair<int, uint64_t>, Pending> mPending;
+    // devices that are queued or connecting
+    std::unordered_set<std::string> mDevices;
+    ConnectStats mStats;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+// the presets of the preferred connection parameters that Windows accepts
+enum class ConnectionPreset : int
+{
+    Balanced = 0,
+    ThroughputOptimized = 1,
+    PowerOptimized = 2,
+};
+
+// how the presets are named in JS, by their value
+constexpr const char* CONNECTION_PRESET_NAMES[] = { "balanced", "throughput", "power" };
+const size_t CONNECTION_PRESETS = 3;
+
+enum class PresetStatus : int
+{
+    Success = 0,
+    // the OS has no API to request connection parameters
+    Unsupported = 1,
+    // the device isn't connected, the preset is requested again once it is
+    DeviceNotAvailable = 2,
+    AccessDenied = 3,
+    Failed = 4,
+};
+
+// in the units of the link layer
+struct ConnectionParameters
+{
+    // 1.25 ms
+    uint16_t interval = 0;
+    // connection events the peripheral may skip
+    uint16_t latency = 0;
+    // 10 ms
+    uint16_t timeout = 0;
+
+    double IntervalMs() const
+    {
+        return interval * 1.25;
+    }
+
+    double TimeoutMs() const
+    {
+        return timeout * 10.0;
+    }
+};
+
+struct PresetResult
+{
+    ConnectionPreset requested = ConnectionPreset::Balanced;
+    // the preset that is in effect, nothing if the OS decides
+    std::optional<ConnectionPreset> applied;
+    PresetStatus status = PresetStatus::Success;
+    // the parameters after the request if the OS reports them
+    std::optional<ConnectionParameters> parameters;
+};
+
+// The presets to try for a request, a preset the OS refuses falls back to Balanced.
+inline std::vector<ConnectionPreset> presetFallbacks(ConnectionPreset preset)
+{
+    if (preset == ConnectionPreset::Balanced)
+    {
+        return { ConnectionPreset::Balanced };
+    }
+    return { preset, ConnectionPreset::Balanced };
+}
+
+// Requests the preset through `backend` and falls back if the OS refuses it. The backend has
+// `bool IsSupported()`, `PresetStatus Request(ConnectionPreset)` and
+// `std::optional<ConnectionParameters> Current()`, so the policy runs against a stub as well.
+template <typename Backend> PresetResult applyPreset(Backend& backend, ConnectionPreset preset)
+{
+    PresetResult result;
+    result.requested = preset;
+    if (!backend.IsSupported())
+    {
+        result.status = PresetStatus::Unsupported;
+        return result;
+    }
+    for (auto candidate : presetFallbacks(preset))
+    {
+        result.status = backend.Request(candidate);
+        if (result.status == PresetStatus::Success)
+        {
+            result.applied = candidate;
+            break;
+        }
+        if (result.status == PresetStatus::DeviceNotAvailable)
+        {
+            // not a refusal of the preset, another one wouldn't fare better
+            break;
+        }
+    }
+    result.parameters = backend.Current();
+    return result;
+}
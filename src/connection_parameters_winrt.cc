@@ -0,0 +1,94 @@
+#include "connection_parameters_winrt.h"
+
+#include <sdkddkver.h>
+#include <winrt/Windows.Foundation.Metadata.h>
+
+// BluetoothLEDevice.RequestPreferredConnectionParameters came with the Windows 11 SDK
+#if defined(NTDDI_WIN10_CO) && WDK_NTDDI_VERSION >= NTDDI_WIN10_CO
+#define HAS_CONNECTION_PARAMETERS
+using winrt::Windows::Devices::Bluetooth::BluetoothLEPreferredConnectionParameters;
+using winrt::Windows::Devices::Bluetooth::BluetoothLEPreferredConnectionParametersRequestStatus;
+#endif
+
+using winrt::Windows::Foundation::Metadata::ApiInformation;
+
+ConnectionParametersWinrt::ConnectionParametersWinrt(BluetoothLEDevice device,
+                                                     winrt::Windows::Foundation::IClosable& request)
+    : mDevice(device), mRequest(request)
+{
+}
+
+bool ConnectionParametersWinrt::IsSupported() const
+{
+#ifdef HAS_CONNECTION_PARAMETERS
+    static const bool present = ApiInformation::IsMethodPresent(
+        L"Windows.Devices.Bluetooth.BluetoothLEDevice", L"RequestPreferredConnectionParameters");
+    return present;
+#else
+    return false;
+#endif
+}
+
+PresetStatus ConnectionParametersWinrt::Request(ConnectionPreset preset)
+{
+#ifdef HAS_CONNECTION_PARAMETERS
+    try
+    {
+        auto parameters = BluetoothLEPreferredConnectionParameters::Balanced();
+        if (preset == ConnectionPreset::ThroughputOptimized)
+        {
+            parameters = BluetoothLEPreferredConnectionParameters::ThroughputOptimized();
+        }
+        else if (preset == ConnectionPreset::PowerOptimized)
+        {
+            parameters = BluetoothLEPreferredConnectionParameters::PowerOptimized();
+        }
+        auto request = mDevice.RequestPreferredConnectionParameters(parameters);
+        switch (request.Status())
+        {
+        case BluetoothLEPreferredConnectionParametersRequestStatus::Success:
+            // the previous preset stays in effect until the new one has been accepted
+            if (mRequest)
+            {
+                mRequest.Close();
+            }
+            mRequest = request;
+            return PresetStatus::Success;
+        case BluetoothLEPreferredConnectionParametersRequestStatus::DeviceNotAvailable:
+            return PresetStatus::DeviceNotAvailable;
+        case BluetoothLEPreferredConnectionParametersRequestStatus::AccessDenied:
+            return PresetStatus::AccessDenied;
+        default:
+            return PresetStatus::Failed;
+        }
+    }
+    catch (const winrt::hresult_error&)
+    {
+        return PresetStatus::Failed;
+    }
+#else
+    return PresetStatus::Unsupported;
+#endif
+}
+
+std::optional<ConnectionParameters> ConnectionParametersWinrt::Current()
+{
+#ifdef HAS_CONNECTION_PARAMETERS
+    if (!IsSupported())
+    {
+        return std::nullopt;
+    }
+    try
+    {
+        auto parameters = mDevice.GetConnectionParameters();
+        return ConnectionParameters{ parameters.ConnectionInterval(),
+                                     parameters.ConnectionLatency(), parameters.LinkTimeout() };
+    }
+    catch (const winrt::hresult_error&)
+    {
+        return std::nullopt;
+    }
+#else
+    return std::nullopt;
+#endif
+}
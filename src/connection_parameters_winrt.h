@@ -0,0 +1,25 @@
+#pragma once
+
+#include <winrt/Windows.Devices.Bluetooth.h>
+
+#include "connection_mode.h"
+
+using winrt::Windows::Devices::Bluetooth::BluetoothLEDevice;
+
+// The backend of applyPreset for a connected device. Requesting connection parameters needs the
+// Windows 11 SDK to build and Windows 11 to run, elsewhere presets are unsupported.
+class ConnectionParametersWinrt
+{
+public:
+    // `request` keeps the accepted preset in effect until it is closed
+    ConnectionParametersWinrt(BluetoothLEDevice device,
+                              winrt::Windows::Foundation::IClosable& request);
+
+    bool IsSupported() const;
+    PresetStatus Request(ConnectionPreset preset);
+    std::optional<ConnectionParameters> Current();
+
+private:
+    BluetoothLEDevice mDevice;
+    winrt::Windows::Foundation::IClosable& mRequest;
+};
@@ -0,0 +1,221 @@
+#include "deadline_timer.h"
+
+#include <algorithm>
+#include <vector>
+
+const size_t MIN_SWEEP = 64;
+
+TimedOperation::TimedOperation(std::string device, OnFailed onFailed)
+    : mDevice(std::move(device)), mOnFailed(std::move(onFailed))
+{
+}
+
+bool TimedOperation::Settle()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mSettled)
+    {
+        return false;
+    }
+    mSettled = true;
+    return true;
+}
+
+bool TimedOperation::IsSettled()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mSettled;
+}
+
+void TimedOperation::Fail(const OperationError& error)
+{
+    Callable<void()> cancel;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mSettled)
+        {
+            return;
+        }
+        mSettled = true;
+        cancel = std::move(mCancel);
+    }
+    if (cancel)
+    {
+        cancel();
+    }
+    mOnFailed(error);
+}
+
+void TimedOperation::SetCancel(Callable<void()> cancel)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mSettled)
+        {
+            mCancel = std::move(cancel);
+            return;
+        }
+    }
+    cancel();
+}
+
+void TimedOperation::SetOnCompleted(Callable<void(const OperationError& error)> onCompleted)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mOnCompleted = std::move(onCompleted);
+}
+
+void TimedOperation::Completed(const OperationError& error)
+{
+    Callable<void(const OperationError& error)> onCompleted;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        onCompleted = std::move(mOnCompleted);
+    }
+    if (onCompleted)
+    {
+        onCompleted(error);
+    }
+}
+
+const std::string& TimedOperation::Device() const
+{
+    return mDevice;
+}
+
+DeadlineTimer::DeadlineTimer(std::function<void()> initThread)
+    : mThread(&DeadlineTimer::Run, this, std::move(initThread))
+{
+}
+
+DeadlineTimer::~DeadlineTimer()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopped = true;
+    }
+    mChanged.notify_one();
+    mThread.join();
+}
+
+std::shared_ptr<TimedOperation> DeadlineTimer::Start(const std::string& device,
+                                                     std::chrono::milliseconds timeout,
+                                                     TimedOperation::OnFailed onFailed)
+{
+    auto operation = std::make_shared<TimedOperation>(device, std::move(onFailed));
+    // operations without a deadline are still tracked so that they can be cancelled
+    auto deadline = timeout.count() > 0 ? Clock::now() + timeout : Clock::time_point::max();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mDeadlines.size() >= mSweepAt)
+        {
+            // drop the entries of completed operations that are still far from their deadline
+            for (auto it = mDeadlines.begin(); it != mDeadlines.end();)
+            {
+                it = it->second.expired() ? mDeadlines.erase(it) : std::next(it);
+            }
+            mSweepAt = std::max(MIN_SWEEP, mDeadlines.size() * 2);
+        }
+        mDeadlines.emplace(deadline, operation);
+    }
+    mChanged.notify_one();
+    return operation;
+}
+
+void DeadlineTimer::CancelAll(const std::string& device, const std::string& reason)
+{
+    std::vector<std::shared_ptr<TimedOperation>> cancelled;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto it = mDeadlines.begin(); it != mDeadlines.end();)
+        {
+            auto operation = it->second.lock();
+            if (!operation || operation->Device() == device)
+            {
+                if (operation)
+                {
+                    cancelled.push_back(operation);
+                }
+                it = mDeadlines.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+    // settled operations ignore the failure
+    for (auto& operation : cancelled)
+    {
+        operation->Fail({ OperationStatus::Cancelled, reason });
+    }
+}
+
+void DeadlineTimer::After(std::chrono::milliseconds delay, Callable<void()> callback)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mTimers.emplace(Clock::now() + delay, std::move(callback));
+    }
+    mChanged.notify_one();
+}
+
+void DeadlineTimer::Run(std::function<void()> initThread)
+{
+    if (initThread)
+    {
+        initThread();
+    }
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mStopped)
+    {
+        auto now = Clock::now();
+        std::vector<std::shared_ptr<TimedOperation>> expired;
+        while (!mDeadlines.empty() && mDeadlines.begin()->first <= now)
+        {
+            if (auto operation = mDeadlines.begin()->second.lock())
+            {
+                expired.push_back(operation);
+            }
+            mDeadlines.erase(mDeadlines.begin());
+        }
+        std::vector<Callable<void()>> due;
+        while (!mTimers.empty() && mTimers.begin()->first <= now)
+        {
+            due.push_back(std::move(mTimers.begin()->second));
+            mTimers.erase(mTimers.begin());
+        }
+        if (!expired.empty() || !due.empty())
+        {
+            lock.unlock();
+            for (auto& operation : expired)
+            {
+                operation->Fail({ OperationStatus::Timeout, "operation timed out" });
+            }
+            for (auto& callback : due)
+            {
+                callback();
+            }
+            lock.lock();
+            continue;
+        }
+        // the entries can be erased while waiting
+        auto next = Clock::time_point::max();
+        if (!mDeadlines.empty())
+        {
+            next = mDeadlines.begin()->first;
+        }
+        if (!mTimers.empty())
+        {
+            next = std::min(next, mTimers.begin()->first);
+        }
+        if (next == Clock::time_point::max())
+        {
+            mChanged.wait(lock);
+        }
+        else
+        {
+            mChanged.wait_until(lock, next);
+        }
+    }
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "callable.h"
+#include "operation_error.h"
+
+// deadlines per operation class, zero disables the deadline
+struct OperationTimeouts
+{
+    std::chrono::milliseconds discovery = std::chrono::seconds(30);
+    std::chrono::milliseconds read = std::chrono::seconds(10);
+    std::chrono::milliseconds write = std::chrono::seconds(10);
+    std::chrono::milliseconds notify = std::chrono::seconds(10);
+    std::chrono::milliseconds connect = std::chrono::seconds(20);
+};
+
+// An operation that races against its deadline. Whichever of completion, timeout or
+// cancellation comes first settles it, everything that comes later is ignored.
+class TimedOperation
+{
+public:
+    using OnFailed = std::function<void(const OperationError& error)>;
+
+    TimedOperation(std::string device, OnFailed onFailed);
+
+    // returns true if the caller settled the operation and has to report its result
+    bool Settle();
+    // settles the operation with the error, cancels the async operation and reports the error
+    void Fail(const OperationError& error);
+    bool IsSettled();
+    // registers how to cancel the async operation, runs it right away if already settled
+    void SetCancel(Callable<void()> cancel);
+    // observes the result of the async operation, failures by deadline or cancellation are
+    // reported through OnFailed instead
+    void SetOnCompleted(Callable<void(const OperationError& error)> onCompleted);
+    // called with the result of the async operation by whoever settled it
+    void Completed(const OperationError& error);
+
+    const std::string& Device() const;
+
+private:
+    std::mutex mMutex;
+    std::string mDevice;
+    OnFailed mOnFailed;
+    Callable<void()> mCancel;
+    Callable<void(const OperationError& error)> mOnCompleted;
+    bool mSettled = false;
+};
+
+// Fails operations with OperationStatus::Timeout once their deadline has passed and runs
+// delayed callbacks. Both are kept on a single thread, `initThread` runs on it first.
+class DeadlineTimer
+{
+public:
+    DeadlineTimer(std::function<void()> initThread = nullptr);
+    ~DeadlineTimer();
+
+    std::shared_ptr<TimedOperation> Start(const std::string& device,
+                                          std::chrono::milliseconds timeout,
+                                          TimedOperation::OnFailed onFailed);
+    // fails all unsettled operations of the device with OperationStatus::Cancelled
+    void CancelAll(const std::string& device, const std::string& reason);
+    // runs the callback on the timer thread once the delay has passed
+    void After(std::chrono::milliseconds delay, Callable<void()> callback);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void Run(std::function<void()> initThread);
+
+    std::mutex mMutex;
+    std::condition_variable mChanged;
+    std::multimap<Clock::time_point, std::weak_ptr<TimedOperation>> mDeadlines;
+    std::multimap<Clock::time_point, Callable<void()>> mTimers;
+    size_t mSweepAt = 64;
+    bool mStopped = false;
+    std::thread mThread;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+#include "cache_policy.h"
+#include "payload.h"
+
+// Cache state of a peripheral: when attribute lookups last went to the device, when the children
+// of each attribute were last discovered uncached and the cached values of static
+// characteristics. Lookups and reads complete on WinRT threads while the state is read on the JS
+// and scheduler threads, so all access is locked.
+template <typename Key, typename Hash = std::hash<Key>> class GattCache
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    GattCache() = default;
+    // a peripheral is only moved into the device map before any lookup is started
+    GattCache(GattCache&& other)
+        : mLookupPolicy(other.mLookupPolicy), mLookupTime(other.mLookupTime),
+          mDiscoveries(std::move(other.mDiscoveries)), mValues(std::move(other.mValues))
+    {
+    }
+
+    void SetLookupPolicy(const CachePolicy& policy)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mLookupPolicy = policy;
+    }
+
+    // Returns true if an attribute lookup may use the Windows cache, otherwise the lookup that is
+    // about to start revalidates it.
+    bool LookupFresh(Clock::time_point now)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mLookupPolicy.IsFresh(mLookupTime, now))
+        {
+            return true;
+        }
+        mLookupTime = now;
+        return false;
+    }
+
+    // Returns true if the ttl of the lookups has run out, the looked up attributes are dropped so
+    // that they are looked up again.
+    bool LookupsExpired(Clock::time_point now) const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mLookupPolicy.mode == CacheMode::Ttl && !mLookupPolicy.IsFresh(mLookupTime, now);
+    }
+
+    // Returns true if the children of the attribute may be discovered from the Windows cache.
+    bool DiscoveryFresh(const Key& key, const CachePolicy& policy, Clock::time_point now) const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mDiscoveries.find(key);
+        return policy.IsFresh(it != mDiscoveries.end() ? it->second : Clock::time_point(), now);
+    }
+
+    // Records an uncached discovery of the children of the attribute that started at `at` and
+    // succeeded.
+    void Discovered(const Key& key, Clock::time_point at)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto& time = mDiscoveries[key];
+        time = std::max(time, at);
+    }
+
+    std::optional<Payload> Value(const Key& key, const CachePolicy& policy,
+                                 Clock::time_point now) const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mValues.find(key);
+        if (it != mValues.end() && policy.IsFresh(it->second.time, now))
+        {
+            return it->second.data;
+        }
+        return std::nullopt;
+    }
+
+    void SetValue(const Key& key, const Payload& data, Clock::time_point now)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mValues.insert_or_assign(key, CachedValue{ data, now });
+    }
+
+    // Forgets everything but the policy, e.g. when the device disconnects.
+    void Clear()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mLookupTime = {};
+        mDiscoveries.clear();
+        mValues.clear();
+    }
+
+private:
+    struct CachedValue
+    {
+        Payload data;
+        Clock::time_point time;
+    };
+
+    mutable std::mutex mMutex;
+    CachePolicy mLookupPolicy = GattCachePolicy().lookup;
+    Clock::time_point mLookupTime;
+    std::unordered_map<Key, Clock::time_point, Hash> mDiscoveries;
+    std::unordered_map<Key, CachedValue, Hash> mValues;
+};
@@ -0,0 +1,149 @@
+#include "gatt_scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+#include "scope_exit.h"
+
+GattScheduler::GattScheduler(size_t depth, size_t maxInFlight)
+    : mDepth(std::max<size_t>(depth, 1)), mMaxInFlight(std::max<size_t>(maxInFlight, 1))
+{
+}
+
+void GattScheduler::SetLimits(size_t depth, size_t maxInFlight)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mDepth = std::max<size_t>(depth, 1);
+        mMaxInFlight = std::max<size_t>(maxInFlight, 1);
+    }
+    Pump();
+}
+
+void GattScheduler::Enqueue(const std::string& device, OperationPriority priority,
+                            Operation operation)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mDevices.find(device);
+        if (it == mDevices.end())
+        {
+            it = mDevices.emplace(device, DeviceQueue()).first;
+            mRoundRobin.push_back(device);
+        }
+        auto& queue = it->second;
+        queue.queues[static_cast<int>(priority)].push_back({ std::move(operation), Clock::now() });
+        queue.stats.enqueued++;
+        queue.stats.queued++;
+        queue.stats.maxQueued = std::max(queue.stats.maxQueued, queue.stats.queued);
+    }
+    Pump();
+}
+
+std::unordered_map<std::string, SchedulerStats> GattScheduler::Stats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::unordered_map<std::string, SchedulerStats> stats;
+    for (auto& entry : mDevices)
+    {
+        stats.emplace(entry.first, entry.second.stats);
+    }
+    return stats;
+}
+
+void GattScheduler::Pump()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mPumping)
+        {
+            // operations that complete synchronously don't recurse, the running pump picks up
+            // the free slot
+            return;
+        }
+        mPumping = true;
+    }
+    // lets the next Pump run if starting the operations throws past the catch below
+    ScopeExit stopPumping([this]() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPumping = false;
+    });
+    while (true)
+    {
+        std::vector<std::pair<std::string, Operation>> ready;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto now = Clock::now();
+            size_t idle = 0;
+            while (mInFlight < mMaxInFlight && idle < mRoundRobin.size())
+            {
+                std::string device = mRoundRobin.front();
+                mRoundRobin.pop_front();
+                mRoundRobin.push_back(device);
+                auto& queue = mDevices[device];
+                if (queue.stats.queued == 0 || queue.stats.inFlight >= mDepth)
+                {
+                    idle++;
+                    continue;
+                }
+                idle = 0;
+                for (auto& pending : queue.queues)
+                {
+                    if (!pending.empty())
+                    {
+                        auto wait = std::chrono::duration_cast<std::chrono::microseconds>(
+                            now - pending.front().queuedAt);
+                        queue.stats.totalWait += wait;
+                        queue.stats.maxWait = std::max(queue.stats.maxWait, wait);
+                        ready.emplace_back(device, std::move(pending.front().operation));
+                        pending.pop_front();
+                        break;
+                    }
+                }
+                queue.stats.queued--;
+                queue.stats.inFlight++;
+                mInFlight++;
+            }
+            if (ready.empty())
+            {
+                mPumping = false;
+                stopPumping.Dismiss();
+                return;
+            }
+        }
+        for (auto& entry : ready)
+        {
+            std::string device = entry.first;
+            // an operation that throws while starting may still have called or handed on `done`,
+            // the slot is released only once either way
+            auto finished = std::make_shared<std::atomic<bool>>(false);
+            Done done = [this, device, finished]() {
+                if (!finished->exchange(true))
+                {
+                    Finish(device);
+                }
+            };
+            try
+            {
+                entry.second(done);
+            }
+            catch (...)
+            {
+                done();
+            }
+        }
+    }
+}
+
+void GattScheduler::Finish(const std::string& device)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto& queue = mDevices[device];
+        queue.stats.inFlight--;
+        queue.stats.completed++;
+        mInFlight--;
+    }
+    Pump();
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "callable.h"
+
+// lower values are started first
+enum class OperationPriority : int
+{
+    Notify = 0,
+    Write = 1,
+    Read = 2,
+};
+
+struct SchedulerStats
+{
+    uint64_t enqueued = 0;
+    uint64_t completed = 0;
+    size_t queued = 0;
+    size_t inFlight = 0;
+    size_t maxQueued = 0;
+    std::chrono::microseconds totalWait = std::chrono::microseconds(0);
+    std::chrono::microseconds maxWait = std::chrono::microseconds(0);
+};
+
+// Queues GATT operations per device. Each device has at most `depth` operations in flight and
+// the adapter at most `maxInFlight`, free slots are handed out round-robin across devices.
+class GattScheduler
+{
+public:
+    using Done = std::function<void()>;
+    // starts the operation, `done` has to be called when it has finished, further calls are
+    // ignored. If the operation throws, its slot is released. The inline capacity fits the
+    // captures of the GATT operations.
+    using Operation = Callable<void(Done done), 384>;
+
+    GattScheduler(size_t depth = 4, size_t maxInFlight = 16);
+
+    void SetLimits(size_t depth, size_t maxInFlight);
+    void Enqueue(const std::string& device, OperationPriority priority, Operation operation);
+    std::unordered_map<std::string, SchedulerStats> Stats() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Pending
+    {
+        Operation operation;
+        Clock::time_point queuedAt;
+    };
+
+    struct DeviceQueue
+    {
+        std::array<std::deque<Pending>, 3> queues;
+        SchedulerStats stats;
+    };
+
+    void Pump();
+    void Finish(const std::string& device);
+
+    mutable std::mutex mMutex;
+    size_t mDepth;
+    size_t mMaxInFlight;
+    size_t mInFlight = 0;
+    bool mPumping = false;
+    std::unordered_map<std::string, DeviceQueue> mDevices;
+    // devices in the order in which they get their next turn
+    std::deque<std::string> mRoundRobin;
+};
@@ -0,0 +1,159 @@
+#include "link_health.h"
+
+#include <algorithm>
+#include <utility>
+
+bool LinkHealth::Watch(const std::string& device, const HealthOptions& options,
+                       Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& state = mDevices[device];
+    state.options = options;
+    state.lastActivity = std::max(state.lastActivity, now);
+    state.lastProbe = now;
+    return !std::exchange(mChecking, true);
+}
+
+void LinkHealth::Unwatch(const std::string& device)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mDevices.erase(device);
+}
+
+std::vector<std::string> LinkHealth::Devices() const
+{
+    std::vector<std::string> devices;
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& entry : mDevices)
+    {
+        devices.push_back(entry.first);
+    }
+    return devices;
+}
+
+void LinkHealth::Activity(const std::string& device, Clock::time_point at)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mDevices.find(device);
+    if (it != mDevices.end())
+    {
+        it->second.lastActivity = std::max(it->second.lastActivity, at);
+    }
+}
+
+void LinkHealth::Completed(const std::string& device, std::chrono::microseconds latency,
+                           bool succeeded, Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mDevices.find(device);
+    if (it == mDevices.end())
+    {
+        return;
+    }
+    auto& state = it->second;
+    state.latencies[state.samples++ % LATENCY_WINDOW] = latency.count();
+    if (succeeded)
+    {
+        state.succeeded++;
+        state.consecutiveFailures = 0;
+        state.lastActivity = std::max(state.lastActivity, now);
+    }
+    else
+    {
+        state.failed++;
+        state.consecutiveFailures++;
+    }
+}
+
+std::vector<HealthChange> LinkHealth::Check(Clock::time_point now, bool& keepChecking)
+{
+    std::vector<HealthChange> changes;
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mDevices.empty())
+    {
+        mChecking = false;
+        keepChecking = false;
+        return changes;
+    }
+    keepChecking = true;
+    for (auto& entry : mDevices)
+    {
+        auto& state = entry.second;
+        auto next = Evaluate(state, now);
+        if (next != state.state)
+        {
+            state.state = next;
+            auto silent =
+                std::chrono::duration_cast<std::chrono::milliseconds>(now - state.lastActivity);
+            changes.push_back({ entry.first, next, silent });
+        }
+    }
+    return changes;
+}
+
+std::vector<std::string> LinkHealth::DueProbes(Clock::time_point now)
+{
+    std::vector<std::string> due;
+    std::lock_guard<std::mutex> lock(mMutex);
+    for (auto& entry : mDevices)
+    {
+        auto& state = entry.second;
+        auto interval = state.options.probeInterval;
+        // a link that is busy anyway doesn't need a probe
+        if (interval.count() > 0 && now - state.lastActivity >= interval &&
+            now - state.lastProbe >= interval)
+        {
+            state.lastProbe = now;
+            due.push_back(entry.first);
+        }
+    }
+    return due;
+}
+
+std::optional<HealthSnapshot> LinkHealth::Snapshot(const std::string& device,
+                                                   Clock::time_point now) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mDevices.find(device);
+    if (it == mDevices.end())
+    {
+        return std::nullopt;
+    }
+    auto& state = it->second;
+    HealthSnapshot snapshot;
+    snapshot.state = state.state;
+    snapshot.silent =
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - state.lastActivity);
+    snapshot.succeeded = state.succeeded;
+    snapshot.failed = state.failed;
+    snapshot.samples = std::min(state.samples, LATENCY_WINDOW);
+    if (snapshot.samples > 0)
+    {
+        std::vector<int64_t> sorted(state.latencies.begin(),
+                                    state.latencies.begin() + snapshot.samples);
+        std::sort(sorted.begin(), sorted.end());
+        auto percentile = [&](size_t p) {
+            return std::chrono::microseconds(sorted[(sorted.size() - 1) * p / 100]);
+        };
+        snapshot.p50 = percentile(50);
+        snapshot.p90 = percentile(90);
+        snapshot.p99 = percentile(99);
+    }
+    return snapshot;
+}
+
+LinkState LinkHealth::Evaluate(const Device& device, Clock::time_point now)
+{
+    auto silent = now - device.lastActivity;
+    if (silent >= device.options.staleAfter)
+    {
+        return LinkState::Stale;
+    }
+    if (silent >= device.options.degradedAfter ||
+        (device.options.failuresDegraded > 0 &&
+         device.consecutiveFailures >= device.options.failuresDegraded))
+    {
+        return LinkState::Degraded;
+    }
+    return LinkState::Healthy;
+}
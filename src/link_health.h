@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class LinkState : int
+{
+    Healthy = 0,
+    // silent for a while or operations keep failing
+    Degraded = 1,
+    // silent for so long that the link is most likely gone
+    Stale = 2,
+};
+
+struct HealthOptions
+{
+    std::chrono::milliseconds degradedAfter = std::chrono::seconds(5);
+    std::chrono::milliseconds staleAfter = std::chrono::seconds(15);
+    // consecutive failed operations that degrade the link, 0 ignores failures
+    int failuresDegraded = 3;
+    // how often the link is probed while it is silent, 0 disables probing
+    std::chrono::milliseconds probeInterval = std::chrono::milliseconds(0);
+};
+
+struct HealthSnapshot
+{
+    LinkState state = LinkState::Healthy;
+    // since the last notification or successful operation
+    std::chrono::milliseconds silent = std::chrono::milliseconds(0);
+    uint64_t succeeded = 0;
+    uint64_t failed = 0;
+    // latency percentiles of the recent operations
+    size_t samples = 0;
+    std::chrono::microseconds p50 = std::chrono::microseconds(0);
+    std::chrono::microseconds p90 = std::chrono::microseconds(0);
+    std::chrono::microseconds p99 = std::chrono::microseconds(0);
+};
+
+struct HealthChange
+{
+    std::string device;
+    LinkState state;
+    std::chrono::milliseconds silent;
+};
+
+// Watchdog for the links of connected devices. A link degrades and goes stale as it stays silent,
+// any notification or successful operation makes it healthy again. The state is only evaluated
+// by Check, which the caller runs periodically while devices are watched.
+class LinkHealth
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Watches the device from now on, returns true if the caller has to start running Check.
+    bool Watch(const std::string& device, const HealthOptions& options, Clock::time_point now);
+    void Unwatch(const std::string& device);
+    std::vector<std::string> Devices() const;
+
+    // Marks the link as alive at `at`, earlier times than the last activity are ignored.
+    void Activity(const std::string& device, Clock::time_point at);
+    void Completed(const std::string& device, std::chrono::microseconds latency, bool succeeded,
+                   Clock::time_point now);
+
+    // Returns the devices whose state has changed. Returns nothing and clears `keepChecking` once
+    // no device is watched anymore, a later Watch asks to start again.
+    std::vector<HealthChange> Check(Clock::time_point now, bool& keepChecking);
+    // Returns the silent devices that are due for a probe and counts them as probed.
+    std::vector<std::string> DueProbes(Clock::time_point now);
+
+    std::optional<HealthSnapshot> Snapshot(const std::string& device, Clock::time_point now) const;
+
+private:
+    // recent operation latencies that the percentiles are taken from
+    static constexpr size_t LATENCY_WINDOW = 128;
+
+    struct Device
+    {
+        HealthOptions options;
+        LinkState state = LinkState::Healthy;
+        Clock::time_point lastActivity;
+        Clock::time_point lastProbe;
+        int consecutiveFailures = 0;
+        uint64_t succeeded = 0;
+        uint64_t failed = 0;
+        std::array<int64_t, LATENCY_WINDOW> latencies = {};
+        size_t samples = 0;
+    };
+
+    static LinkState Evaluate(const Device& device, Clock::time_point now);
+
+    mutable std::mutex mMutex;
+    std::unordered_map<std::string, Device> mDevices;
+    bool mChecking = false;
+};
@@ -9,6 +9,10 @@
 #include <winrt/Windows.Devices.Bluetooth.GenericAttributeProfile.h>
 #include <rpc.h>
 
+#include <algorithm>
+
+#include "winrt_cpp.h"
+
 using namespace winrt::Windows::Devices::Bluetooth;
 
 winrt::guid napiToUuid(Napi::String string)
@@ -33,6 +37,12 @@ winrt::guid napiToUuid(Napi::String string)
     return winrt::guid(uuid.Data1, uuid.Data2, uuid.Data3, data4);
 }
 
+// "AA:BB:CC:DD:EE:FF" and "aabbccddeeff" name the same device
+std::string napiToDeviceId(Napi::String string)
+{
+    return normalizeDeviceId(string.Utf8Value());
+}
+
 std::vector<winrt::guid> napiToUuidArray(Napi::Array array)
 {
     std::vector<winrt::guid> uuids;
@@ -52,6 +62,12 @@ Data napiToData(Napi::Buffer<byte> buffer)
     return data;
 }
 
+// copies the bytes out of the JS buffer, they are shared from then on
+Payload napiToPayload(Napi::Buffer<byte> buffer)
+{
+    return Payload(napiToData(buffer));
+}
+
 int napiToNumber(Napi::Number number)
 {
     return number.Int32Value();
@@ -74,3 +90,234 @@ bool getBool(const Napi::Value& value, bool def)
     }
     return def;
 }
+
+std::optional<CacheMode> getCacheMode(const Napi::Value& value)
+{
+    if (value.IsString())
+    {
+        std::string mode = value.As<Napi::String>().Utf8Value();
+        if (mode == "uncached")
+        {
+            return CacheMode::Uncached;
+        }
+        if (mode == "cached")
+        {
+            return CacheMode::Cached;
+        }
+        if (mode == "ttl")
+        {
+            return CacheMode::Ttl;
+        }
+    }
+    return std::nullopt;
+}
+
+GattCachePolicy napiToCachePolicy(Napi::Object object, GattCachePolicy policy)
+{
+    CachePolicy* policies[] = { &policy.discovery, &policy.lookup, &policy.read };
+    const char* names[] = { "discovery", "lookup", "read" };
+    for (size_t i = 0; i < 3; i++)
+    {
+        auto mode = getCacheMode(object.Get(names[i]));
+        if (mode)
+        {
+            policies[i]->mode = *mode;
+        }
+        if (object.Get("ttl").IsNumber())
+        {
+            auto ttl = object.Get("ttl").As<Napi::Number>().Int64Value();
+            policies[i]->ttl = std::chrono::milliseconds(ttl);
+        }
+    }
+    return policy;
+}
+
+OperationTimeouts napiToTimeouts(Napi::Object object, OperationTimeouts timeouts)
+{
+    std::chrono::milliseconds* values[] = { &timeouts.discovery, &timeouts.read, &timeouts.write,
+                                            &timeouts.notify, &timeouts.connect };
+    const char* names[] = { "discovery", "read", "write", "notify", "connect" };
+    for (size_t i = 0; i < 5; i++)
+    {
+        auto value = object.Get(names[i]);
+        if (value.IsNumber())
+        {
+            auto timeout = value.As<Napi::Number>().Int64Value();
+            *values[i] = std::chrono::milliseconds(std::max<int64_t>(timeout, 0));
+        }
+    }
+    return timeouts;
+}
+
+const char* OPERATION_CLASS_NAMES[] = { "discovery", "read", "write", "notify" };
+
+std::optional<OperationClass> getOperationClass(const Napi::Value& value)
+{
+    if (value.IsString())
+    {
+        std::string name = value.As<Napi::String>().Utf8Value();
+        for (size_t i = 0; i < OPERATION_CLASSES; i++)
+        {
+            if (name == OPERATION_CLASS_NAMES[i])
+            {
+                return static_cast<OperationClass>(i);
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+const char* operationClassToString(OperationClass operationClass)
+{
+    return OPERATION_CLASS_NAMES[static_cast<int>(operationClass)];
+}
+
+std::optional<ConnectionPreset> getConnectionPreset(const Napi::Value& value)
+{
+    if (value.IsString())
+    {
+        std::string name = value.As<Napi::String>().Utf8Value();
+        for (size_t i = 0; i < CONNECTION_PRESETS; i++)
+        {
+            if (name == CONNECTION_PRESET_NAMES[i])
+            {
+                return static_cast<ConnectionPreset>(i);
+            }
+        }
+    }
+    return std::nullopt;
+}
+
+RetryPolicy napiToRetryPolicy(Napi::Object object, RetryPolicy policy)
+{
+    if (object.Get("maxAttempts").IsNumber())
+    {
+        auto maxAttempts = napiToNumber(object.Get("maxAttempts").As<Napi::Number>());
+        policy.maxAttempts = std::max(maxAttempts, 1);
+    }
+    std::chrono::milliseconds* delays[] = { &policy.initialDelay, &policy.maxDelay };
+    const char* names[] = { "initialDelay", "maxDelay" };
+    for (size_t i = 0; i < 2; i++)
+    {
+        auto value = object.Get(names[i]);
+        if (value.IsNumber())
+        {
+            auto delay = value.As<Napi::Number>().Int64Value();
+            *delays[i] = std::chrono::milliseconds(std::max<int64_t>(delay, 0));
+        }
+    }
+    if (object.Get("multiplier").IsNumber())
+    {
+        auto multiplier = object.Get("multiplier").As<Napi::Number>().DoubleValue();
+        policy.multiplier = std::max(multiplier, 1.0);
+    }
+    if (object.Get("jitter").IsNumber())
+    {
+        auto jitter = object.Get("jitter").As<Napi::Number>().DoubleValue();
+        policy.jitter = std::clamp(jitter, 0.0, 1.0);
+    }
+    if (object.Get("retryable").IsArray())
+    {
+        auto statuses = object.Get("retryable").As<Napi::Array>();
+        policy.retryable.clear();
+        for (uint32_t i = 0; i < statuses.Length(); i++)
+        {
+            Napi::Value status = statuses[i];
+            if (status.IsNumber())
+            {
+                auto value = napiToNumber(status.As<Napi::Number>());
+                policy.retryable.push_back(static_cast<OperationStatus>(value));
+            }
+        }
+    }
+    return policy;
+}
+
+const char* FIELD_TYPE_NAMES[] = { "uint8", "int8",   "uint16", "int16",   "uint24",
+                                   "int24", "uint32", "int32",  "float32", "skip" };
+
+static std::optional<FieldSpec> napiToFieldSpec(const Napi::Value& value)
+{
+    if (!value.IsObject())
+    {
+        return std::nullopt;
+    }
+    auto object = value.As<Napi::Object>();
+    if (!object.Get("type").IsString())
+    {
+        return std::nullopt;
+    }
+    std::string type = object.Get("type").As<Napi::String>().Utf8Value();
+    FieldSpec field;
+    auto names = std::begin(FIELD_TYPE_NAMES);
+    auto name = std::find(names, std::end(FIELD_TYPE_NAMES), type);
+    if (name == std::end(FIELD_TYPE_NAMES))
+    {
+        return std::nullopt;
+    }
+    field.type = static_cast<FieldType>(name - names);
+    if (object.Get("endian").IsString())
+    {
+        field.bigEndian = object.Get("endian").As<Napi::String>().Utf8Value() == "big";
+    }
+    if (object.Get("scale").IsNumber())
+    {
+        field.scale = object.Get("scale").As<Napi::Number>().DoubleValue();
+    }
+    if (object.Get("offset").IsNumber())
+    {
+        field.offset = object.Get("offset").As<Napi::Number>().DoubleValue();
+    }
+    if (object.Get("size").IsNumber())
+    {
+        field.size = std::max(napiToNumber(object.Get("size").As<Napi::Number>()), 0);
+    }
+    return field;
+}
+
+static bool napiToFieldSpecs(const Napi::Value& value, std::vector<FieldSpec>& fields)
+{
+    if (value.IsUndefined())
+    {
+        return true;
+    }
+    if (!value.IsArray())
+    {
+        return false;
+    }
+    auto array = value.As<Napi::Array>();
+    for (uint32_t i = 0; i < array.Length(); i++)
+    {
+        Napi::Value item = array[i];
+        auto field = napiToFieldSpec(item);
+        if (!field)
+        {
+            return false;
+        }
+        fields.push_back(*field);
+    }
+    return true;
+}
+
+std::optional<DecoderSchema> napiToDecoderSchema(Napi::Object object)
+{
+    DecoderSchema schema;
+    if (!napiToFieldSpecs(object.Get("fields"), schema.fields) ||
+        !napiToFieldSpecs(object.Get("repeat"), schema.repeat))
+    {
+        return std::nullopt;
+    }
+    if (object.Get("output").IsString())
+    {
+        std::string output = object.Get("output").As<Napi::String>().Utf8Value();
+        if (output == "int32")
+        {
+            schema.output = DecoderOutput::Int32;
+        }
+        else if (output != "float32")
+        {
+            return std::nullopt;
+        }
+    }
+    return schema;
+}
@@ -3,10 +3,27 @@
 #include <napi.h>
 #include "winrt/base.h"
 #include "peripheral.h"
+#include "cache_policy.h"
+#include "connection_mode.h"
+#include "deadline_timer.h"
+#include "payload_decoder.h"
+#include "retry_policy.h"
+
+#include <optional>
 
 std::vector<winrt::guid> getUuidArray(const Napi::Value& value);
 bool getBool(const Napi::Value& value, bool def);
 
 winrt::guid napiToUuid(Napi::String string);
+std::string napiToDeviceId(Napi::String string);
 Data napiToData(Napi::Buffer<unsigned char> buffer);
+Payload napiToPayload(Napi::Buffer<unsigned char> buffer);
 int napiToNumber(Napi::Number number);
+std::optional<CacheMode> getCacheMode(const Napi::Value& value);
+GattCachePolicy napiToCachePolicy(Napi::Object object, GattCachePolicy policy);
+OperationTimeouts napiToTimeouts(Napi::Object object, OperationTimeouts timeouts);
+std::optional<OperationClass> getOperationClass(const Napi::Value& value);
+const char* operationClassToString(OperationClass operationClass);
+std::optional<ConnectionPreset> getConnectionPreset(const Napi::Value& value);
+RetryPolicy napiToRetryPolicy(Napi::Object object, RetryPolicy policy);
+std::optional<DecoderSchema> napiToDecoderSchema(Napi::Object object);
@@ -7,6 +7,9 @@
 #include "noble_winrt.h"
 
 #include "napi_winrt.h"
+#include "winrt_cpp.h"
+
+#include <algorithm>
 
 #define THROW(msg)                                                      \
     Napi::TypeError::New(info.Env(), msg).ThrowAsJavaScriptException(); \
@@ -55,6 +58,11 @@ NobleWinrt::NobleWinrt(const Napi::CallbackInfo& info) : ObjectWrap(info)
 {
 }
 
+NobleWinrt::~NobleWinrt()
+{
+    CloseRings();
+}
+
 Napi::Value NobleWinrt::Init(const Napi::CallbackInfo& info)
 {
     Napi::Function emit = info.This().As<Napi::Object>().Get("emit").As<Napi::Function>();
@@ -81,13 +89,46 @@ Napi::Value NobleWinrt::StopScan(const Napi::CallbackInfo& info)
     return Napi::Value();
 }
 
-// connect(deviceUuid)
+// connect(deviceUuid | address | [address], { priority })
 Napi::Value NobleWinrt::Connect(const Napi::CallbackInfo& info)
 {
     CHECK_MANAGER()
-    ARG1(String)
-    auto uuid = info[0].As<Napi::String>().Utf8Value();
-    manager->Connect(uuid);
+    std::vector<std::string> ids;
+    if (info[0].IsString())
+    {
+        ids.push_back(napiToDeviceId(info[0].As<Napi::String>()));
+    }
+    else if (info[0].IsArray())
+    {
+        auto array = info[0].As<Napi::Array>();
+        for (uint32_t i = 0; i < array.Length(); i++)
+        {
+            if (!array.Get(i).IsString())
+            {
+                THROW("The addresses have to be strings")
+            }
+            ids.push_back(napiToDeviceId(array.Get(i).As<Napi::String>()));
+        }
+    }
+    else
+    {
+        THROW("There should be one argument: (String | Array)")
+    }
+    // lower priorities connect first
+    int priority = 0;
+    if (info[1].IsObject())
+    {
+        auto options = info[1].As<Napi::Object>();
+        if (options.Get("priority").IsNumber())
+        {
+            priority = napiToNumber(options.Get("priority").As<Napi::Number>());
+        }
+    }
+    // the connect queue limits how many of them connect at once
+    for (auto& id : ids)
+    {
+        manager->Connect(id, priority);
+    }
     return Napi::Value();
 }
 
@@ -96,7 +137,7 @@ Napi::Value NobleWinrt::Disconnect(const Napi::CallbackInfo& info)
 {
     CHECK_MANAGER()
     ARG1(String)
-    auto uuid = info[0].As<Napi::String>().Utf8Value();
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
     manager->Disconnect(uuid);
     return Napi::Value();
 }
@@ -106,55 +147,59 @@ Napi::Value NobleWinrt::UpdateRSSI(const Napi::CallbackInfo& info)
 {
     CHECK_MANAGER()
     ARG1(String)
-    auto uuid = info[0].As<Napi::String>().Utf8Value();
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
     manager->UpdateRSSI(uuid);
     return Napi::Value();
 }
 
-// discoverServices(deviceUuid, uuids)
+// discoverServices(deviceUuid, uuids, cacheMode)
 Napi::Value NobleWinrt::DiscoverServices(const Napi::CallbackInfo& info)
 {
     CHECK_MANAGER()
     ARG1(String)
-    auto uuid = info[0].As<Napi::String>().Utf8Value();
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
     std::vector<winrt::guid> uuids = getUuidArray(info[1]);
-    manager->DiscoverServices(uuid, uuids);
+    auto cacheMode = getCacheMode(info[2]);
+    manager->DiscoverServices(uuid, uuids, cacheMode);
     return Napi::Value();
 }
 
-// discoverIncludedServices(deviceUuid, serviceUuid, serviceUuids)
+// discoverIncludedServices(deviceUuid, serviceUuid, serviceUuids, cacheMode)
 Napi::Value NobleWinrt::DiscoverIncludedServices(const Napi::CallbackInfo& info)
 {
     CHECK_MANAGER()
     ARG2(String, String)
-    auto uuid = info[0].As<Napi::String>().Utf8Value();
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
     auto service = napiToUuid(info[1].As<Napi::String>());
     std::vector<winrt::guid> uuids = getUuidArray(info[2]);
-    manager->DiscoverIncludedServices(uuid, service, uuids);
+    auto cacheMode = getCacheMode(info[3]);
+    manager->DiscoverIncludedServices(uuid, service, uuids, cacheMode);
     return Napi::Value();
 }
 
-// discoverCharacteristics(deviceUuid, serviceUuid, characteristicUuids)
+// discoverCharacteristics(deviceUuid, serviceUuid, characteristicUuids, cacheMode)
 Napi::Value NobleWinrt::DiscoverCharacteristics(const Napi::CallbackInfo& info)
 {
     CHECK_MANAGER()
     ARG2(String, String)
-    auto uuid = info[0].As<Napi::String>().Utf8Value();
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
     auto service = napiToUuid(info[1].As<Napi::String>());
     std::vector<winrt::guid> characteristics = getUuidArray(info[2]);
-    manager->DiscoverCharacteristics(uuid, service, characteristics);
+    auto cacheMode = getCacheMode(info[3]);
+    manager->DiscoverCharacteristics(uuid, service, characteristics, cacheMode);
     return Napi::Value();
 }
 
-// read(deviceUuid, serviceUuid, characteristicUuid)
+// read(deviceUuid, serviceUuid, characteristicUuid, cacheMode)
 Napi::Value NobleWinrt::Read(const Napi::CallbackInfo& info)
 {
     CHECK_MANAGER()
     ARG3(String, String, String)
-    auto uuid = info[0].As<Napi::String>().Utf8Value();
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
     auto service = napiToUuid(info[1].As<Napi::String>());
     auto characteristic = napiToUuid(info[2].As<Napi::String>());
-    manager->Read(uuid, service, characteristic);
+    auto cacheMode = getCacheMode(info[3]);
+    manager->Read(uuid, service, characteristic, cacheMode);
     return Napi::Value();
 }
 
@@ -163,50 +208,68 @@ Napi::Value NobleWinrt::Write(const Napi::CallbackInfo& info)
 {
     CHECK_MANAGER()
     ARG5(String, String, String, Buffer, Boolean)
-    auto uuid = info[0].As<Napi::String>().Utf8Value();
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
     auto service = napiToUuid(info[1].As<Napi::String>());
     auto characteristic = napiToUuid(info[2].As<Napi::String>());
-    auto data = napiToData(info[3].As<Napi::Buffer<unsigned char>>());
+    auto data = napiToPayload(info[3].As<Napi::Buffer<unsigned char>>());
     auto withoutResponse = info[4].As<Napi::Boolean>().Value();
     manager->Write(uuid, service, characteristic, data, withoutResponse);
     return Napi::Value();
 }
 
-// notify(deviceUuid, serviceUuid, characteristicUuid, notify)
+// notify(deviceUuid, serviceUuid, characteristicUuid, notify, { subscriber, minInterval })
 Napi::Value NobleWinrt::Notify(const Napi::CallbackInfo& info)
 {
     CHECK_MANAGER()
     ARG4(String, String, String, Boolean)
-    auto uuid = info[0].As<Napi::String>().Utf8Value();
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
     auto service = napiToUuid(info[1].As<Napi::String>());
     auto characteristic = napiToUuid(info[2].As<Napi::String>());
     auto on = info[3].As<Napi::Boolean>().Value();
-    manager->Notify(uuid, service, characteristic, on);
+    std::string subscriber;
+    SubscriberOptions subscriberOptions;
+    if (info[4].IsObject())
+    {
+        auto options = info[4].As<Napi::Object>();
+        if (options.Get("subscriber").IsString())
+        {
+            subscriber = options.Get("subscriber").As<Napi::String>().Utf8Value();
+        }
+        if (options.Get("minInterval").IsNumber())
+        {
+            auto minInterval = options.Get("minInterval").As<Napi::Number>().Int64Value();
+            subscriberOptions.minInterval =
+                std::chrono::milliseconds(std::max<int64_t>(minInterval, 0));
+        }
+    }
+    manager->Notify(uuid, service, characteristic, on, subscriber, subscriberOptions);
     return Napi::Value();
 }
 
-// discoverDescriptors(deviceUuid, serviceUuid, characteristicUuid)
+// discoverDescriptors(deviceUuid, serviceUuid, characteristicUuid, cacheMode)
 Napi::Value NobleWinrt::DiscoverDescriptors(const Napi::CallbackInfo& info)
 {
     CHECK_MANAGER()
     ARG3(String, String, String)
-    auto uuid = info[0].As<Napi::String>().Utf8Value();
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
     auto service = napiToUuid(info[1].As<Napi::String>());
     auto characteristic = napiToUuid(info[2].As<Napi::String>());
-    manager->DiscoverDescriptors(uuid, service, characteristic);
+    auto cacheMode = getCacheMode(info[3]);
+    manager->DiscoverDescriptors(uuid, service, characteristic, cacheMode);
     return Napi::Value();
 }
 
-// readValue(deviceUuid, serviceUuid, characteristicUuid, descriptorUuid)
+// readValue(deviceUuid, serviceUuid, characteristicUuid, descriptorUuid, cacheMode)
 Napi::Value NobleWinrt::ReadValue(const Napi::CallbackInfo& info)
 {
     CHECK_MANAGER()
     ARG4(String, String, String, String)
-    auto uuid = info[0].As<Napi::String>().Utf8Value();
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
     auto service = napiToUuid(info[1].As<Napi::String>());
     auto characteristic = napiToUuid(info[2].As<Napi::String>());
     auto descriptor = napiToUuid(info[3].As<Napi::String>());
-    manager->ReadValue(uuid, service, characteristic, descriptor);
+    auto cacheMode = getCacheMode(info[4]);
+    manager->ReadValue(uuid, service, characteristic, descriptor, cacheMode);
     return Napi::Value();
 }
 
@@ -215,11 +278,11 @@ Napi::Value NobleWinrt::WriteValue(const Napi::CallbackInfo& info)
 {
     CHECK_MANAGER()
     ARG5(String, String, String, String, Buffer)
-    auto uuid = info[0].As<Napi::String>().Utf8Value();
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
     auto service = napiToUuid(info[1].As<Napi::String>());
     auto characteristic = napiToUuid(info[2].As<Napi::String>());
     auto descriptor = napiToUuid(info[3].As<Napi::String>());
-    auto data = napiToData(info[4].As<Napi::Buffer<unsigned char>>());
+    auto data = napiToPayload(info[4].As<Napi::Buffer<unsigned char>>());
     manager->WriteValue(uuid, service, characteristic, descriptor, data);
     return Napi::Value();
 }
@@ -229,7 +292,7 @@ Napi::Value NobleWinrt::ReadHandle(const Napi::CallbackInfo& info)
 {
     CHECK_MANAGER()
     ARG2(String, Number)
-    auto uuid = info[0].As<Napi::String>().Utf8Value();
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
     auto handle = napiToNumber(info[1].As<Napi::Number>());
     manager->ReadHandle(uuid, handle);
     return Napi::Value();
@@ -240,16 +303,506 @@ Napi::Value NobleWinrt::WriteHandle(const Napi::CallbackInfo& info)
 {
     CHECK_MANAGER()
     ARG3(String, Number, Buffer)
-    auto uuid = info[0].As<Napi::String>().Utf8Value();
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
     auto handle = napiToNumber(info[1].As<Napi::Number>());
-    auto data = napiToData(info[2].As<Napi::Buffer<unsigned char>>());
+    auto data = napiToPayload(info[2].As<Napi::Buffer<unsigned char>>());
     manager->WriteHandle(uuid, handle, data);
     return Napi::Value();
 }
 
+// readMany(deviceUuid, [{ serviceUuid, characteristicUuid }], cacheMode)
+Napi::Value NobleWinrt::ReadMany(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG2(String, Array)
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
+    auto array = info[1].As<Napi::Array>();
+    std::vector<AttributeKey> characteristics;
+    for (uint32_t i = 0; i < array.Length(); i++)
+    {
+        Napi::Value entry = array[i];
+        if (!entry.IsObject())
+        {
+            THROW("Each item should be an object: { serviceUuid, characteristicUuid }")
+        }
+        auto object = entry.As<Napi::Object>();
+        if (!object.Get("serviceUuid").IsString() || !object.Get("characteristicUuid").IsString())
+        {
+            THROW("Each item should be an object: { serviceUuid, characteristicUuid }")
+        }
+        auto service = napiToUuid(object.Get("serviceUuid").As<Napi::String>());
+        auto characteristic = napiToUuid(object.Get("characteristicUuid").As<Napi::String>());
+        characteristics.push_back({ service, characteristic });
+    }
+    auto cacheMode = getCacheMode(info[2]);
+    manager->ReadMany(uuid, characteristics, cacheMode);
+    return Napi::Value();
+}
+
+// writeMany(deviceUuid, [{ serviceUuid, characteristicUuid, data, withoutResponse }],
+//           { reliable })
+Napi::Value NobleWinrt::WriteMany(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG2(String, Array)
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
+    auto array = info[1].As<Napi::Array>();
+    std::vector<WriteItem> items;
+    for (uint32_t i = 0; i < array.Length(); i++)
+    {
+        Napi::Value entry = array[i];
+        if (!entry.IsObject())
+        {
+            THROW("Each item should be an object: { serviceUuid, characteristicUuid, data }")
+        }
+        auto object = entry.As<Napi::Object>();
+        if (!object.Get("serviceUuid").IsString() ||
+            !object.Get("characteristicUuid").IsString() || !object.Get("data").IsBuffer())
+        {
+            THROW("Each item should be an object: { serviceUuid, characteristicUuid, data }")
+        }
+        auto service = napiToUuid(object.Get("serviceUuid").As<Napi::String>());
+        auto characteristic = napiToUuid(object.Get("characteristicUuid").As<Napi::String>());
+        auto data = napiToPayload(object.Get("data").As<Napi::Buffer<unsigned char>>());
+        auto withoutResponse = getBool(object.Get("withoutResponse"), false);
+        items.push_back({ { service, characteristic }, data, withoutResponse });
+    }
+    bool reliable = false;
+    if (info[2].IsObject())
+    {
+        reliable = getBool(info[2].As<Napi::Object>().Get("reliable"), false);
+    }
+    manager->WriteMany(uuid, items, reliable);
+    return Napi::Value();
+}
+
+// discoverAll(deviceUuid, serviceUuids, cacheMode)
+Napi::Value NobleWinrt::DiscoverAll(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG1(String)
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
+    std::vector<winrt::guid> uuids = getUuidArray(info[1]);
+    auto cacheMode = getCacheMode(info[2]);
+    manager->DiscoverAll(uuid, uuids, cacheMode);
+    return Napi::Value();
+}
+
+// setCachePolicy({ discovery, lookup, read, ttl })
+Napi::Value NobleWinrt::SetCachePolicy(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG1(Object)
+    auto policy = napiToCachePolicy(info[0].As<Napi::Object>(), manager->GetCachePolicy());
+    manager->SetCachePolicy(policy);
+    return Napi::Value();
+}
+
+// setStaticCharacteristic(serviceUuid, characteristicUuid, isStatic)
+Napi::Value NobleWinrt::SetStaticCharacteristic(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG3(String, String, Boolean)
+    auto service = napiToUuid(info[0].As<Napi::String>());
+    auto characteristic = napiToUuid(info[1].As<Napi::String>());
+    auto isStatic = info[2].As<Napi::Boolean>().Value();
+    manager->SetStaticCharacteristic(service, characteristic, isStatic);
+    return Napi::Value();
+}
+
+// writeStream(deviceUuid, serviceUuid, characteristicUuid, data, { chunkSize, window })
+Napi::Value NobleWinrt::WriteStream(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG4(String, String, String, Buffer)
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
+    auto service = napiToUuid(info[1].As<Napi::String>());
+    auto characteristic = napiToUuid(info[2].As<Napi::String>());
+    auto data = napiToPayload(info[3].As<Napi::Buffer<unsigned char>>());
+    // 0 fills each chunk up to the negotiated ATT MTU
+    size_t chunkSize = 0;
+    size_t window = 8;
+    if (info[4].IsObject())
+    {
+        auto options = info[4].As<Napi::Object>();
+        if (options.Get("chunkSize").IsNumber())
+        {
+            chunkSize = std::max(napiToNumber(options.Get("chunkSize").As<Napi::Number>()), 1);
+        }
+        if (options.Get("window").IsNumber())
+        {
+            window = std::max(napiToNumber(options.Get("window").As<Napi::Number>()), 1);
+        }
+    }
+    manager->WriteStream(uuid, service, characteristic, data, chunkSize, window);
+    return Napi::Value();
+}
+
+// setTimeouts({ discovery, read, write, notify, connect })
+Napi::Value NobleWinrt::SetTimeouts(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG1(Object)
+    auto timeouts = napiToTimeouts(info[0].As<Napi::Object>(), manager->GetTimeouts());
+    manager->SetTimeouts(timeouts);
+    return Napi::Value();
+}
+
+// setSchedulerLimits(depth, maxInFlight)
+Napi::Value NobleWinrt::SetSchedulerLimits(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG2(Number, Number)
+    auto depth = napiToNumber(info[0].As<Napi::Number>());
+    auto maxInFlight = napiToNumber(info[1].As<Napi::Number>());
+    if (depth < 1 || maxInFlight < 1)
+    {
+        THROW("The limits have to be at least 1")
+    }
+    manager->SetSchedulerLimits(depth, maxInFlight);
+    return Napi::Value();
+}
+
+// getSchedulerStats()
+Napi::Value NobleWinrt::GetSchedulerStats(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    auto env = info.Env();
+    auto result = Napi::Object::New(env);
+    for (auto& entry : manager->GetSchedulerStats())
+    {
+        auto& stats = entry.second;
+        auto object = Napi::Object::New(env);
+        object.Set("enqueued", Napi::Number::New(env, static_cast<double>(stats.enqueued)));
+        object.Set("completed", Napi::Number::New(env, static_cast<double>(stats.completed)));
+        object.Set("queued", Napi::Number::New(env, static_cast<double>(stats.queued)));
+        object.Set("inFlight", Napi::Number::New(env, static_cast<double>(stats.inFlight)));
+        object.Set("maxQueued", Napi::Number::New(env, static_cast<double>(stats.maxQueued)));
+        object.Set("totalWaitMs", Napi::Number::New(env, stats.totalWait.count() / 1000.0));
+        object.Set("maxWaitMs", Napi::Number::New(env, stats.maxWait.count() / 1000.0));
+        result.Set(entry.first, object);
+    }
+    return result;
+}
+
+// setConnectionMode(deviceUuid, preset)
+Napi::Value NobleWinrt::SetConnectionMode(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG2(String, String)
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
+    auto preset = getConnectionPreset(info[1]);
+    if (!preset)
+    {
+        THROW("The preset has to be balanced, throughput or power")
+    }
+    manager->SetConnectionMode(uuid, *preset);
+    return Napi::Value();
+}
+
+// getConnectionParameters(deviceUuid)
+Napi::Value NobleWinrt::GetConnectionParameters(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG1(String)
+    auto env = info.Env();
+    auto parameters = manager->GetConnectionParameters(napiToDeviceId(info[0].As<Napi::String>()));
+    if (!parameters)
+    {
+        return env.Null();
+    }
+    auto result = Napi::Object::New(env);
+    result.Set("intervalMs", Napi::Number::New(env, parameters->IntervalMs()));
+    result.Set("latency", Napi::Number::New(env, parameters->latency));
+    result.Set("timeoutMs", Napi::Number::New(env, parameters->TimeoutMs()));
+    return result;
+}
+
+// setHealthMonitor(deviceUuid, { degradedAfter, staleAfter, failuresDegraded, probeInterval,
+//                                probeService, probeCharacteristic } | null)
+Napi::Value NobleWinrt::SetHealthMonitor(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG1(String)
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
+    std::optional<HealthOptions> options;
+    std::optional<AttributeKey> probe;
+    if (info[1].IsObject())
+    {
+        auto object = info[1].As<Napi::Object>();
+        options = HealthOptions();
+        std::chrono::milliseconds* durations[] = { &options->degradedAfter, &options->staleAfter,
+                                                   &options->probeInterval };
+        const char* names[] = { "degradedAfter", "staleAfter", "probeInterval" };
+        for (size_t i = 0; i < 3; i++)
+        {
+            auto value = object.Get(names[i]);
+            if (value.IsNumber())
+            {
+                auto duration = value.As<Napi::Number>().Int64Value();
+                *durations[i] = std::chrono::milliseconds(std::max<int64_t>(duration, 0));
+            }
+        }
+        if (object.Get("failuresDegraded").IsNumber())
+        {
+            auto failures = napiToNumber(object.Get("failuresDegraded").As<Napi::Number>());
+            options->failuresDegraded = std::max(failures, 0);
+        }
+        if (object.Get("probeService").IsString() && object.Get("probeCharacteristic").IsString())
+        {
+            auto service = napiToUuid(object.Get("probeService").As<Napi::String>());
+            auto characteristic = napiToUuid(object.Get("probeCharacteristic").As<Napi::String>());
+            probe = AttributeKey{ service, characteristic };
+        }
+        else
+        {
+            // nothing to probe with
+            options->probeInterval = std::chrono::milliseconds(0);
+        }
+    }
+    manager->SetHealthMonitor(uuid, options, probe);
+    return Napi::Value();
+}
+
+// getLinkHealth(deviceUuid)
+Napi::Value NobleWinrt::GetLinkHealth(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG1(String)
+    auto env = info.Env();
+    auto health = manager->GetLinkHealth(napiToDeviceId(info[0].As<Napi::String>()));
+    if (!health)
+    {
+        return env.Null();
+    }
+    const char* states[] = { "healthy", "degraded", "stale" };
+    auto total = health->succeeded + health->failed;
+    auto successRate = total ? static_cast<double>(health->succeeded) / total : 1.0;
+    auto result = Napi::Object::New(env);
+    result.Set("state", Napi::String::New(env, states[static_cast<int>(health->state)]));
+    result.Set("silentMs", Napi::Number::New(env, static_cast<double>(health->silent.count())));
+    result.Set("succeeded", Napi::Number::New(env, static_cast<double>(health->succeeded)));
+    result.Set("failed", Napi::Number::New(env, static_cast<double>(health->failed)));
+    result.Set("successRate", Napi::Number::New(env, successRate));
+    result.Set("samples", Napi::Number::New(env, static_cast<double>(health->samples)));
+    result.Set("p50Ms", Napi::Number::New(env, health->p50.count() / 1000.0));
+    result.Set("p90Ms", Napi::Number::New(env, health->p90.count() / 1000.0));
+    result.Set("p99Ms", Napi::Number::New(env, health->p99.count() / 1000.0));
+    return result;
+}
+
+// setConnectLimit(maxConcurrent)
+Napi::Value NobleWinrt::SetConnectLimit(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG1(Number)
+    auto maxConcurrent = napiToNumber(info[0].As<Napi::Number>());
+    if (maxConcurrent < 1)
+    {
+        THROW("The limit has to be at least 1")
+    }
+    manager->SetConnectLimit(maxConcurrent);
+    return Napi::Value();
+}
+
+// getConnectStats()
+Napi::Value NobleWinrt::GetConnectStats(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    auto env = info.Env();
+    auto stats = manager->GetConnectStats();
+    auto result = Napi::Object::New(env);
+    result.Set("queued", Napi::Number::New(env, static_cast<double>(stats.queued)));
+    result.Set("connected", Napi::Number::New(env, static_cast<double>(stats.connected)));
+    result.Set("failed", Napi::Number::New(env, static_cast<double>(stats.failed)));
+    result.Set("pending", Napi::Number::New(env, static_cast<double>(stats.pending)));
+    result.Set("inFlight", Napi::Number::New(env, static_cast<double>(stats.inFlight)));
+    result.Set("totalConnectMs", Napi::Number::New(env, stats.totalConnectTime.count() / 1000.0));
+    result.Set("maxConnectMs", Napi::Number::New(env, stats.maxConnectTime.count() / 1000.0));
+    return result;
+}
+
+static Napi::Object durationsToNapi(Napi::Env env, const DurationSnapshot& durations)
+{
+    auto object = Napi::Object::New(env);
+    object.Set("count", Napi::Number::New(env, static_cast<double>(durations.count)));
+    object.Set("maxMs", Napi::Number::New(env, durations.max / 1000.0));
+    auto mean = durations.count ? durations.sum / 1000.0 / durations.count : 0.0;
+    object.Set("meanMs", Napi::Number::New(env, mean));
+    auto buckets = Napi::Array::New(env, DURATION_BUCKETS);
+    for (size_t i = 0; i < DURATION_BUCKETS; i++)
+    {
+        buckets.Set(i, Napi::Number::New(env, static_cast<double>(durations.buckets[i])));
+    }
+    object.Set("histogram", buckets);
+    return object;
+}
+
+// getNotifyStats()
+Napi::Value NobleWinrt::GetNotifyStats(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    auto env = info.Env();
+    auto contexts = manager->GetNotifyStats();
+    auto result = Napi::Array::New(env, contexts.size());
+    for (size_t i = 0; i < contexts.size(); i++)
+    {
+        auto& context = contexts[i];
+        auto stats = context->stats.Snapshot();
+        auto object = Napi::Object::New(env);
+        object.Set("deviceUuid", context->uuid);
+        object.Set("serviceUuid", context->serviceUuid);
+        object.Set("characteristicUuid", context->characteristicUuid);
+        auto notifications = static_cast<double>(stats.notifications);
+        object.Set("notifications", Napi::Number::New(env, notifications));
+        object.Set("bytes", Napi::Number::New(env, static_cast<double>(stats.bytes)));
+        object.Set("throttled", Napi::Number::New(env, static_cast<double>(stats.throttled)));
+        object.Set("decodeErrors", Napi::Number::New(env, static_cast<double>(stats.decodeErrors)));
+        object.Set("gaps", durationsToNapi(env, stats.gaps));
+        object.Set("queueDelay", durationsToNapi(env, stats.queueDelay));
+        result.Set(i, object);
+    }
+    return result;
+}
+
+// setRetryPolicy(operationClass, { maxAttempts, initialDelay, maxDelay, multiplier, jitter,
+//                                  retryable })
+Napi::Value NobleWinrt::SetRetryPolicy(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG2(String, Object)
+    auto operationClass = getOperationClass(info[0]);
+    if (!operationClass)
+    {
+        THROW("The operation class has to be discovery, read, write or notify")
+    }
+    auto policy = manager->GetRetryPolicy(*operationClass);
+    manager->SetRetryPolicy(*operationClass,
+                            napiToRetryPolicy(info[1].As<Napi::Object>(), policy));
+    return Napi::Value();
+}
+
+// getRetryStats()
+Napi::Value NobleWinrt::GetRetryStats(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    auto env = info.Env();
+    auto result = Napi::Object::New(env);
+    auto stats = manager->GetRetryStats();
+    for (size_t i = 0; i < stats.size(); i++)
+    {
+        auto object = Napi::Object::New(env);
+        object.Set("operations", Napi::Number::New(env, static_cast<double>(stats[i].operations)));
+        object.Set("retries", Napi::Number::New(env, static_cast<double>(stats[i].retries)));
+        object.Set("recovered", Napi::Number::New(env, static_cast<double>(stats[i].recovered)));
+        object.Set("exhausted", Napi::Number::New(env, static_cast<double>(stats[i].exhausted)));
+        result.Set(operationClassToString(static_cast<OperationClass>(i)), object);
+    }
+    return result;
+}
+
+// setReconnectPolicy({ enabled, maxAttempts, initialDelay, maxDelay, multiplier, jitter })
+Napi::Value NobleWinrt::SetReconnectPolicy(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG1(Object)
+    auto object = info[0].As<Napi::Object>();
+    auto policy = manager->GetReconnectPolicy();
+    if (object.Get("enabled").IsBoolean())
+    {
+        policy.enabled = object.Get("enabled").As<Napi::Boolean>().Value();
+    }
+    policy.backoff = napiToRetryPolicy(object, policy.backoff);
+    manager->SetReconnectPolicy(policy);
+    return Napi::Value();
+}
+
+// getReconnectStats()
+Napi::Value NobleWinrt::GetReconnectStats(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    auto env = info.Env();
+    auto stats = manager->GetReconnectStats();
+    auto result = Napi::Object::New(env);
+    result.Set("drops", Napi::Number::New(env, static_cast<double>(stats.drops)));
+    result.Set("attempts", Napi::Number::New(env, static_cast<double>(stats.attempts)));
+    result.Set("restored", Napi::Number::New(env, static_cast<double>(stats.restored)));
+    result.Set("exhausted", Napi::Number::New(env, static_cast<double>(stats.exhausted)));
+    result.Set("totalLatencyMs", Napi::Number::New(env, stats.totalLatency.count() / 1000.0));
+    result.Set("maxLatencyMs", Napi::Number::New(env, stats.maxLatency.count() / 1000.0));
+    return result;
+}
+
+// setDecoder(deviceUuid, serviceUuid, characteristicUuid, { fields, repeat, output } | null)
+Napi::Value NobleWinrt::SetDecoder(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG3(String, String, String)
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
+    auto service = napiToUuid(info[1].As<Napi::String>());
+    auto characteristic = napiToUuid(info[2].As<Napi::String>());
+    std::shared_ptr<const PayloadDecoder> decoder;
+    if (info[3].IsObject())
+    {
+        auto schema = napiToDecoderSchema(info[3].As<Napi::Object>());
+        auto compiled = schema ? PayloadDecoder::Compile(*schema) : std::nullopt;
+        if (!compiled)
+        {
+            THROW("The decoder schema is invalid")
+        }
+        decoder = std::make_shared<const PayloadDecoder>(std::move(*compiled));
+    }
+    manager->SetDecoder(uuid, service, characteristic, decoder);
+    return Napi::Value();
+}
+
+// setNotifyRing(deviceUuid, serviceUuid, characteristicUuid, Uint8Array | null)
+Napi::Value NobleWinrt::SetNotifyRing(const Napi::CallbackInfo& info)
+{
+    CHECK_MANAGER()
+    ARG3(String, String, String)
+    auto uuid = napiToDeviceId(info[0].As<Napi::String>());
+    auto service = napiToUuid(info[1].As<Napi::String>());
+    auto characteristic = napiToUuid(info[2].As<Napi::String>());
+    auto key = uuid + "/" + toStr(service) + "/" + toStr(characteristic);
+    RingMemory ringMemory;
+    if (info[3].IsTypedArray())
+    {
+        auto memory = info[3].As<Napi::Uint8Array>();
+        ringMemory.ring = NotifyRing::Create(memory.Data(), memory.ByteLength());
+        if (!ringMemory.ring)
+        {
+            THROW("The ring needs a Uint8Array of at least 192 bytes at an 8 byte aligned offset")
+        }
+        ringMemory.memory = Napi::Persistent(memory);
+    }
+    auto replaced = manager->SetNotifyRing(uuid, service, characteristic, ringMemory.ring);
+    if (replaced)
+    {
+        // nothing writes to the old memory afterwards, its reference can be dropped
+        replaced->Close();
+    }
+    rings.erase(key);
+    if (ringMemory.ring)
+    {
+        rings.emplace(key, std::move(ringMemory));
+    }
+    return Napi::Value();
+}
+
+void NobleWinrt::CloseRings()
+{
+    for (auto& entry : rings)
+    {
+        entry.second.ring->Close();
+    }
+    rings.clear();
+}
+
 Napi::Value NobleWinrt::CleanUp(const Napi::CallbackInfo& info)
 {
     CHECK_MANAGER()
+    CloseRings();
     delete manager;
     manager = nullptr;
     return Napi::Value();
@@ -276,6 +829,28 @@ Napi::Function NobleWinrt::GetClass(Napi::Env env)
         NobleWinrt::InstanceMethod("writeValue", &NobleWinrt::WriteValue),
         NobleWinrt::InstanceMethod("readHandle", &NobleWinrt::ReadHandle),
         NobleWinrt::InstanceMethod("writeHandle", &NobleWinrt::WriteHandle),
+        NobleWinrt::InstanceMethod("readMany", &NobleWinrt::ReadMany),
+        NobleWinrt::InstanceMethod("writeMany", &NobleWinrt::WriteMany),
+        NobleWinrt::InstanceMethod("discoverAll", &NobleWinrt::DiscoverAll),
+        NobleWinrt::InstanceMethod("setCachePolicy", &NobleWinrt::SetCachePolicy),
+        NobleWinrt::InstanceMethod("setStaticCharacteristic", &NobleWinrt::SetStaticCharacteristic),
+        NobleWinrt::InstanceMethod("writeStream", &NobleWinrt::WriteStream),
+        NobleWinrt::InstanceMethod("setSchedulerLimits", &NobleWinrt::SetSchedulerLimits),
+        NobleWinrt::InstanceMethod("setTimeouts", &NobleWinrt::SetTimeouts),
+        NobleWinrt::InstanceMethod("getSchedulerStats", &NobleWinrt::GetSchedulerStats),
+        NobleWinrt::InstanceMethod("setConnectLimit", &NobleWinrt::SetConnectLimit),
+        NobleWinrt::InstanceMethod("getConnectStats", &NobleWinrt::GetConnectStats),
+        NobleWinrt::InstanceMethod("setConnectionMode", &NobleWinrt::SetConnectionMode),
+        NobleWinrt::InstanceMethod("getConnectionParameters", &NobleWinrt::GetConnectionParameters),
+        NobleWinrt::InstanceMethod("setHealthMonitor", &NobleWinrt::SetHealthMonitor),
+        NobleWinrt::InstanceMethod("getLinkHealth", &NobleWinrt::GetLinkHealth),
+        NobleWinrt::InstanceMethod("setRetryPolicy", &NobleWinrt::SetRetryPolicy),
+        NobleWinrt::InstanceMethod("getRetryStats", &NobleWinrt::GetRetryStats),
+        NobleWinrt::InstanceMethod("setReconnectPolicy", &NobleWinrt::SetReconnectPolicy),
+        NobleWinrt::InstanceMethod("getReconnectStats", &NobleWinrt::GetReconnectStats),
+        NobleWinrt::InstanceMethod("setDecoder", &NobleWinrt::SetDecoder),
+        NobleWinrt::InstanceMethod("setNotifyRing", &NobleWinrt::SetNotifyRing),
+        NobleWinrt::InstanceMethod("getNotifyStats", &NobleWinrt::GetNotifyStats),
         NobleWinrt::InstanceMethod("cleanUp", &NobleWinrt::CleanUp),
     });
     // clang-format on
@@ -2,12 +2,15 @@
 
 #include <napi.h>
 
+#include <unordered_map>
+
 #include "ble_manager.h"
 
 class NobleWinrt : public Napi::ObjectWrap<NobleWinrt>
 {
 public:
     NobleWinrt(const Napi::CallbackInfo&);
+    ~NobleWinrt();
     Napi::Value Init(const Napi::CallbackInfo&);
     Napi::Value CleanUp(const Napi::CallbackInfo&);
     Napi::Value Scan(const Napi::CallbackInfo&);
@@ -26,9 +29,41 @@ public:
     Napi::Value WriteValue(const Napi::CallbackInfo& info);
     Napi::Value ReadHandle(const Napi::CallbackInfo& info);
     Napi::Value WriteHandle(const Napi::CallbackInfo& info);
+    Napi::Value WriteMany(const Napi::CallbackInfo& info);
+    Napi::Value ReadMany(const Napi::CallbackInfo& info);
+    Napi::Value DiscoverAll(const Napi::CallbackInfo& info);
+    Napi::Value SetCachePolicy(const Napi::CallbackInfo& info);
+    Napi::Value SetStaticCharacteristic(const Napi::CallbackInfo& info);
+    Napi::Value WriteStream(const Napi::CallbackInfo& info);
+    Napi::Value SetSchedulerLimits(const Napi::CallbackInfo& info);
+    Napi::Value SetTimeouts(const Napi::CallbackInfo& info);
+    Napi::Value GetSchedulerStats(const Napi::CallbackInfo& info);
+    Napi::Value SetConnectLimit(const Napi::CallbackInfo& info);
+    Napi::Value GetConnectStats(const Napi::CallbackInfo& info);
+    Napi::Value SetConnectionMode(const Napi::CallbackInfo& info);
+    Napi::Value GetConnectionParameters(const Napi::CallbackInfo& info);
+    Napi::Value SetHealthMonitor(const Napi::CallbackInfo& info);
+    Napi::Value GetLinkHealth(const Napi::CallbackInfo& info);
+    Napi::Value GetNotifyStats(const Napi::CallbackInfo& info);
+    Napi::Value SetRetryPolicy(const Napi::CallbackInfo& info);
+    Napi::Value GetRetryStats(const Napi::CallbackInfo& info);
+    Napi::Value SetReconnectPolicy(const Napi::CallbackInfo& info);
+    Napi::Value GetReconnectStats(const Napi::CallbackInfo& info);
+    Napi::Value SetDecoder(const Napi::CallbackInfo& info);
+    Napi::Value SetNotifyRing(const Napi::CallbackInfo& info);
 
     static Napi::Function GetClass(Napi::Env);
 
 private:
+    // a ring and the JS memory it writes to, the memory is only released once the ring is closed
+    struct RingMemory
+    {
+        std::shared_ptr<NotifyRing> ring;
+        Napi::Reference<Napi::Uint8Array> memory;
+    };
+
+    void CloseRings();
+
     BLEManager* manager;
+    std::unordered_map<std::string, RingMemory> rings;
 };
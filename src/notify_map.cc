@@ -7,56 +7,225 @@
 
 #include "notify_map.h"
 
-bool Key::operator==(const Key& other) const
-{
-    return (uuid == other.uuid && serviceUuid == other.serviceUuid &&
-            characteristicUuid == other.characteristicUuid);
-}
+#include <cstring>
+#include <utility>
 
-void NotifyMap::Add(std::string uuid, GattCharacteristic characteristic, winrt::event_token token)
+bool SubscriptionKey::operator<(const SubscriptionKey& other) const
 {
-    Key key = { uuid, characteristic.Service().Uuid(), characteristic.Uuid() };
-    mNotifyMap.insert(std::make_pair(key, token));
+    int order = memcmp(&service, &other.service, sizeof(winrt::guid));
+    if (order != 0)
+    {
+        return order < 0;
+    }
+    return memcmp(&characteristic, &other.characteristic, sizeof(winrt::guid)) < 0;
 }
 
-bool NotifyMap::IsSubscribed(std::string uuid, GattCharacteristic characteristic)
+static void revoke(GattCharacteristic& characteristic, winrt::event_token token)
 {
+    if (!characteristic)
+    {
+        return;
+    }
     try
     {
-        Key key = { uuid, characteristic.Service().Uuid(), characteristic.Uuid() };
-        return mNotifyMap.find(key) != mNotifyMap.end();
+        characteristic.ValueChanged(token);
     }
     catch (...)
     {
-        return false;
     }
 }
 
-void NotifyMap::Unsubscribe(std::string uuid, GattCharacteristic characteristic)
+void NotifyMap::BeginWrite(const std::string& uuid, const SubscriptionKey& key, WriteTurn turn)
 {
-    Key key = { uuid, characteristic.Service().Uuid(), characteristic.Uuid() };
-    auto& it = mNotifyMap.find(key);
-    if (it == mNotifyMap.end())
     {
-        return;
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (auto waiting = mWrites.Find(uuid, key))
+        {
+            waiting->push_back(std::move(turn));
+            return;
+        }
+        mWrites.Add(uuid, key, {});
+    }
+    turn();
+}
+
+void NotifyMap::EndWrite(const std::string& uuid, const SubscriptionKey& key)
+{
+    WriteTurn next;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto waiting = mWrites.Find(uuid, key);
+        if (!waiting)
+        {
+            return;
+        }
+        if (waiting->empty())
+        {
+            mWrites.Remove(uuid, key);
+            return;
+        }
+        next = std::move(waiting->front());
+        waiting->erase(waiting->begin());
+    }
+    next();
+}
+
+SubscribeResult NotifyMap::Subscribe(const std::string& uuid, const SubscriptionKey& key,
+                                     const std::string& subscriber,
+                                     const SubscriberOptions& options,
+                                     const std::shared_ptr<SubscriptionContext>& context)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto subscription = mIndex.Find(uuid, key);
+    if (!subscription)
+    {
+        context->subscribers.Add(subscriber, options);
+        if (auto delivery = mDeliveries.Find(uuid, key))
+        {
+            context->SetDelivery(*delivery);
+        }
+        mIndex.Add(uuid, key, { nullptr, {}, context });
+        return SubscribeResult::Enable;
+    }
+    subscription->context->subscribers.Add(subscriber, options);
+    return SubscribeResult::Active;
+}
+
+bool NotifyMap::Attach(const std::string& uuid, const SubscriptionKey& key,
+                       const std::shared_ptr<SubscriptionContext>& context,
+                       GattCharacteristic characteristic, winrt::event_token token)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto subscription = mIndex.Find(uuid, key);
+        if (subscription && subscription->context == context && !subscription->characteristic)
+        {
+            subscription->characteristic = characteristic;
+            subscription->token = token;
+            return true;
+        }
+    }
+    revoke(characteristic, token);
+    return false;
+}
+
+void NotifyMap::Abort(const std::string& uuid, const SubscriptionKey& key,
+                      const std::shared_ptr<SubscriptionContext>& context)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto subscription = mIndex.Find(uuid, key);
+    if (subscription && subscription->context == context && !subscription->characteristic)
+    {
+        mIndex.Remove(uuid, key);
     }
-    auto& token = it->second;
-    characteristic.ValueChanged(token);
-    mNotifyMap.erase(key);
 }
 
-void NotifyMap::Remove(std::string uuid)
+UnsubscribeResult NotifyMap::Unsubscribe(const std::string& uuid, const SubscriptionKey& key,
+                                         const std::string& subscriber)
 {
-    for (auto it = mNotifyMap.begin(); it != mNotifyMap.end();)
+    std::optional<Subscription> removed;
     {
-        auto& key = it->first;
-        if (key.uuid == uuid)
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto subscription = mIndex.Find(uuid, key);
+        if (!subscription || !subscription->context->subscribers.Remove(subscriber))
         {
-            it = mNotifyMap.erase(it);
+            return UnsubscribeResult::NotSubscribed;
         }
-        else
+        if (!subscription->context->subscribers.Empty())
         {
-            it++;
+            return UnsubscribeResult::Remaining;
         }
+        removed = mIndex.Remove(uuid, key);
+    }
+    revoke(removed->characteristic, removed->token);
+    return UnsubscribeResult::Disable;
+}
+
+template <typename F>
+void NotifyMap::UpdateDelivery(const std::string& uuid, const SubscriptionKey& key, F update)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    NotifyDelivery delivery;
+    if (auto existing = mDeliveries.Remove(uuid, key))
+    {
+        delivery = std::move(*existing);
+    }
+    update(delivery);
+    if (auto subscription = mIndex.Find(uuid, key))
+    {
+        subscription->context->SetDelivery(delivery);
+    }
+    if (delivery.decoder || delivery.ring)
+    {
+        mDeliveries.Add(uuid, key, std::move(delivery));
+    }
+}
+
+void NotifyMap::SetDecoder(const std::string& uuid, const SubscriptionKey& key,
+                           std::shared_ptr<const PayloadDecoder> decoder)
+{
+    UpdateDelivery(uuid, key, [&](NotifyDelivery& delivery) { delivery.decoder = decoder; });
+}
+
+std::shared_ptr<NotifyRing> NotifyMap::SetRing(const std::string& uuid, const SubscriptionKey& key,
+                                               std::shared_ptr<NotifyRing> ring)
+{
+    std::shared_ptr<NotifyRing> replaced;
+    UpdateDelivery(uuid, key, [&](NotifyDelivery& delivery) {
+        replaced = std::exchange(delivery.ring, ring);
+    });
+    return replaced;
+}
+
+std::vector<std::shared_ptr<SubscriptionContext>> NotifyMap::Contexts()
+{
+    std::vector<std::shared_ptr<SubscriptionContext>> contexts;
+    std::lock_guard<std::mutex> lock(mMutex);
+    mIndex.ForEach([&](const std::string&, const SubscriptionKey&, Subscription& subscription) {
+        contexts.push_back(subscription.context);
+    });
+    return contexts;
+}
+
+std::vector<std::shared_ptr<SubscriptionContext>> NotifyMap::Contexts(const std::string& uuid)
+{
+    std::vector<std::shared_ptr<SubscriptionContext>> contexts;
+    std::lock_guard<std::mutex> lock(mMutex);
+    mIndex.ForEach(uuid, [&](const SubscriptionKey&, Subscription& subscription) {
+        contexts.push_back(subscription.context);
+    });
+    return contexts;
+}
+
+std::vector<SubscriptionKey> NotifyMap::Enabled(const std::string& uuid)
+{
+    std::vector<SubscriptionKey> keys;
+    std::lock_guard<std::mutex> lock(mMutex);
+    mIndex.ForEach(uuid, [&](const SubscriptionKey& key, Subscription& subscription) {
+        if (subscription.characteristic)
+        {
+            keys.push_back(key);
+        }
+    });
+    return keys;
+}
+
+GattCharacteristic NotifyMap::Characteristic(const std::string& uuid, const SubscriptionKey& key)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto subscription = mIndex.Find(uuid, key);
+    return subscription ? subscription->characteristic : nullptr;
+}
+
+void NotifyMap::Remove(const std::string& uuid)
+{
+    std::vector<std::pair<SubscriptionKey, Subscription>> removed;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        removed = mIndex.Remove(uuid);
+    }
+    for (auto& entry : removed)
+    {
+        revoke(entry.second.characteristic, entry.second.token);
     }
 }
@@ -8,43 +8,106 @@
 #pragma once
 
 #include <winrt/Windows.Devices.Bluetooth.GenericAttributeProfile.h>
+
+#include <mutex>
+#include <vector>
+
+#include "callable.h"
+#include "peripheral.h"
+#include "subscription_index.h"
 #include "winrt_guid.h"
 
 using namespace winrt::Windows::Devices::Bluetooth::GenericAttributeProfile;
 
-struct Key
+struct SubscriptionKey
 {
-public:
-    std::string uuid;
-    winrt::guid serviceUuid;
-    winrt::guid characteristicUuid;
+    winrt::guid service;
+    winrt::guid characteristic;
+
+    bool operator<(const SubscriptionKey& other) const;
+};
+
+struct Subscription
+{
+    // null while notifications are being enabled
+    GattCharacteristic characteristic = nullptr;
+    winrt::event_token token;
+    // shared with the ValueChanged handler
+    std::shared_ptr<SubscriptionContext> context;
+};
 
-    bool operator==(const Key& other) const;
+enum class SubscribeResult
+{
+    // first subscriber, the caller enables notifications
+    Enable,
+    // joined an active subscription
+    Active,
 };
 
-namespace std
+enum class UnsubscribeResult
 {
-    template <> struct hash<Key>
-    {
-        std::size_t operator()(const Key& k) const
-        {
-            auto serviceHash = std::hash<winrt::guid>()(k.serviceUuid);
-            auto characteristicHash = std::hash<winrt::guid>()(k.characteristicUuid);
-            return ((std::hash<std::string>()(k.uuid) ^ (serviceHash << 1)) >> 1) ^
-                (characteristicHash << 1);
-        }
-    };
-} // namespace std
+    // last subscriber, the handler has been revoked and the caller disables notifications
+    Disable,
+    // other subscribers remain
+    Remaining,
+    NotSubscribed,
+};
 
+// The notification subscriptions of all devices. Several subscribers share one subscription per
+// characteristic, the descriptor is only written for the first and the last of them.
 class NotifyMap
 {
 public:
-    void Add(std::string uuid, GattCharacteristic characteristic, winrt::event_token token);
-    bool IsSubscribed(std::string uuid, GattCharacteristic characteristic);
-    void Unsubscribe(std::string uuid, GattCharacteristic characteristic);
+    using WriteTurn = Callable<void()>;
+
+    // Serializes the requests that may write the descriptor of a characteristic, so that enabling
+    // and disabling can't complete out of order. `turn` runs now if no other request of the
+    // characteristic holds its turn, otherwise after the previous one has called EndWrite.
+    // Subscribe and Unsubscribe are called within the turn, a subscription is therefore never
+    // joined while its notifications are being enabled.
+    void BeginWrite(const std::string& uuid, const SubscriptionKey& key, WriteTurn turn);
+    void EndWrite(const std::string& uuid, const SubscriptionKey& key);
 
-    void Remove(std::string uuid);
+    // `context` is used if the subscriber is the first one.
+    SubscribeResult Subscribe(const std::string& uuid, const SubscriptionKey& key,
+                              const std::string& subscriber, const SubscriberOptions& options,
+                              const std::shared_ptr<SubscriptionContext>& context);
+    // Attaches the handler once notifications have been enabled, returns false and revokes it if
+    // the subscription has been dropped meanwhile.
+    bool Attach(const std::string& uuid, const SubscriptionKey& key,
+                const std::shared_ptr<SubscriptionContext>& context,
+                GattCharacteristic characteristic, winrt::event_token token);
+    // Drops the subscription if enabling notifications for `context` failed.
+    void Abort(const std::string& uuid, const SubscriptionKey& key,
+               const std::shared_ptr<SubscriptionContext>& context);
+    UnsubscribeResult Unsubscribe(const std::string& uuid, const SubscriptionKey& key,
+                                  const std::string& subscriber);
+    // Decodes the notifications of the characteristic from now on, nullptr emits them raw again.
+    void SetDecoder(const std::string& uuid, const SubscriptionKey& key,
+                    std::shared_ptr<const PayloadDecoder> decoder);
+    // Writes the notifications of the characteristic into the ring instead of emitting them,
+    // nullptr emits them again. Returns the ring that has been replaced.
+    std::shared_ptr<NotifyRing> SetRing(const std::string& uuid, const SubscriptionKey& key,
+                                        std::shared_ptr<NotifyRing> ring);
+
+    std::vector<std::shared_ptr<SubscriptionContext>> Contexts();
+    std::vector<std::shared_ptr<SubscriptionContext>> Contexts(const std::string& uuid);
+    // the characteristics of the device with notifications enabled
+    std::vector<SubscriptionKey> Enabled(const std::string& uuid);
+    // the characteristic if its notifications are enabled and it still has subscribers, nullptr
+    // otherwise
+    GattCharacteristic Characteristic(const std::string& uuid, const SubscriptionKey& key);
+
+    void Remove(const std::string& uuid);
 
 private:
-    std::unordered_map<Key, winrt::event_token> mNotifyMap;
+    template <typename F>
+    void UpdateDelivery(const std::string& uuid, const SubscriptionKey& key, F update);
+
+    std::mutex mMutex;
+    SubscriptionIndex<SubscriptionKey, Subscription> mIndex;
+    // kept across subscriptions and connections
+    SubscriptionIndex<SubscriptionKey, NotifyDelivery> mDeliveries;
+    // present while a request holds the turn of the characteristic, with the requests waiting
+    SubscriptionIndex<SubscriptionKey, std::vector<WriteTurn>> mWrites;
 };
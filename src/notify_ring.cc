@@ -0,0 +1,123 @@
+#include "notify_ring.h"
+
+#include <algorithm>
+#include <cstring>
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "atomics must overlay memory");
+
+const size_t WRITE_POSITION = 0;
+const size_t CAPACITY = 4;
+const size_t DROPPED = 8;
+const size_t READ_POSITION = 64;
+
+static uint32_t recordSize(size_t length)
+{
+    return static_cast<uint32_t>(NotifyRing::RECORD_HEADER_SIZE + ((length + 7) & ~size_t(7)));
+}
+
+std::shared_ptr<NotifyRing> NotifyRing::Create(uint8_t* memory, size_t size)
+{
+    if (reinterpret_cast<uintptr_t>(memory) % 8 != 0 || size < HEADER_SIZE + 64)
+    {
+        return nullptr;
+    }
+    size_t available = std::min<size_t>(size - HEADER_SIZE, size_t(1) << 31);
+    uint32_t capacity = 64;
+    while (capacity * 2 <= available)
+    {
+        capacity *= 2;
+    }
+    return std::make_shared<NotifyRing>(memory, capacity);
+}
+
+NotifyRing::NotifyRing(uint8_t* memory, uint32_t capacity)
+    : mMemory(memory), mData(memory + HEADER_SIZE), mCapacity(capacity)
+{
+    memset(mMemory, 0, HEADER_SIZE);
+    At(CAPACITY).store(capacity, std::memory_order_release);
+}
+
+std::atomic<uint32_t>& NotifyRing::At(size_t offset) const
+{
+    return *reinterpret_cast<std::atomic<uint32_t>*>(mMemory + offset);
+}
+
+bool NotifyRing::Push(uint64_t timestamp, const uint8_t* data, size_t size)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mMemory)
+    {
+        return false;
+    }
+    if (size > mCapacity)
+    {
+        At(DROPPED).fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    uint32_t record = recordSize(size);
+    uint32_t write = At(WRITE_POSITION).load(std::memory_order_relaxed);
+    uint32_t read = At(READ_POSITION).load(std::memory_order_acquire);
+    uint32_t position = write & (mCapacity - 1);
+    uint32_t tail = mCapacity - position;
+    uint32_t needed = record + (tail < record ? tail : 0);
+    if (record > mCapacity || write - read + needed > mCapacity)
+    {
+        At(DROPPED).fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    if (tail < record)
+    {
+        // records are 8 byte aligned, so there is room for the marker
+        uint32_t marker = WRAP_MARKER;
+        memcpy(mData + position, &marker, sizeof(marker));
+        write += tail;
+        position = 0;
+    }
+    uint32_t length = static_cast<uint32_t>(size);
+    uint32_t reserved = 0;
+    memcpy(mData + position, &length, sizeof(length));
+    memcpy(mData + position + 4, &reserved, sizeof(reserved));
+    memcpy(mData + position + 8, &timestamp, sizeof(timestamp));
+    if (size > 0)
+    {
+        memcpy(mData + position + RECORD_HEADER_SIZE, data, size);
+    }
+    At(WRITE_POSITION).store(write + record, std::memory_order_release);
+    return true;
+}
+
+bool NotifyRing::Pop(uint64_t& timestamp, std::vector<uint8_t>& data)
+{
+    uint32_t read = At(READ_POSITION).load(std::memory_order_relaxed);
+    uint32_t write = At(WRITE_POSITION).load(std::memory_order_acquire);
+    if (read == write)
+    {
+        return false;
+    }
+    uint32_t position = read & (mCapacity - 1);
+    uint32_t length;
+    memcpy(&length, mData + position, sizeof(length));
+    if (length == WRAP_MARKER)
+    {
+        read += mCapacity - position;
+        position = 0;
+        memcpy(&length, mData, sizeof(length));
+    }
+    memcpy(&timestamp, mData + position + 8, sizeof(timestamp));
+    const uint8_t* payload = mData + position + RECORD_HEADER_SIZE;
+    data.assign(payload, payload + length);
+    At(READ_POSITION).store(read + recordSize(length), std::memory_order_release);
+    return true;
+}
+
+void NotifyRing::Close()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mMemory = nullptr;
+}
+
+uint32_t NotifyRing::Dropped()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mMemory ? At(DROPPED).load(std::memory_order_relaxed) : 0;
+}
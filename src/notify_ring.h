@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// A ring of notification records in memory that is shared with JS, written by the native side
+// and read by JS without any callback. Layout, all integers little endian:
+//   0    uint32 write position, only advanced by the producer
+//   4    uint32 capacity of the data area in bytes, a power of two
+//   8    uint32 records dropped because the ring was full
+//   64   uint32 read position, only advanced by the consumer
+//   128  data area
+// Positions count bytes and wrap around at 2^32, a record starts at position & (capacity - 1).
+// A record is a uint32 length, 4 reserved bytes, a uint64 timestamp in microseconds and the
+// payload, padded to a multiple of 8 bytes. A length of 0xffffffff marks the unused end of the
+// data area, the next record starts at the beginning. The producer publishes a record by storing
+// the write position after it, the consumer frees it by storing the read position after it.
+class NotifyRing
+{
+public:
+    static const size_t HEADER_SIZE = 128;
+    static const size_t RECORD_HEADER_SIZE = 16;
+    static const uint32_t WRAP_MARKER = 0xffffffff;
+
+    // nullptr if the memory is too small for a ring or isn't 8 byte aligned
+    static std::shared_ptr<NotifyRing> Create(uint8_t* memory, size_t size);
+
+    NotifyRing(uint8_t* memory, uint32_t capacity);
+
+    // Appends a record, returns false and counts it as dropped if it doesn't fit.
+    bool Push(uint64_t timestamp, const uint8_t* data, size_t size);
+    // Takes the oldest record, for consumers on the native side. Not after Close.
+    bool Pop(uint64_t& timestamp, std::vector<uint8_t>& data);
+
+    // Stops writing to the memory, once this returns the memory may be released.
+    void Close();
+
+    uint32_t Capacity() const
+    {
+        return mCapacity;
+    }
+
+    uint32_t Dropped();
+
+private:
+    std::atomic<uint32_t>& At(size_t offset) const;
+
+    // serializes producers, the consumer never takes it
+    std::mutex mMutex;
+    uint8_t* mMemory;
+    uint8_t* mData;
+    uint32_t mCapacity;
+};
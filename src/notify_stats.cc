@@ -0,0 +1,95 @@
+#include "notify_stats.h"
+
+#include <algorithm>
+
+static size_t bucket(uint64_t micros)
+{
+    size_t width = 0;
+    while (micros != 0 && width < DURATION_BUCKETS - 1)
+    {
+        micros >>= 1;
+        width++;
+    }
+    return width;
+}
+
+static uint64_t toMicros(std::chrono::steady_clock::duration duration)
+{
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    return static_cast<uint64_t>(std::max<int64_t>(micros, 0));
+}
+
+void DurationHistogram::Add(uint64_t micros)
+{
+    mBuckets[bucket(micros)].fetch_add(1, std::memory_order_relaxed);
+    mCount.fetch_add(1, std::memory_order_relaxed);
+    mSum.fetch_add(micros, std::memory_order_relaxed);
+    auto max = mMax.load(std::memory_order_relaxed);
+    while (micros > max && !mMax.compare_exchange_weak(max, micros, std::memory_order_relaxed))
+    {
+    }
+}
+
+DurationSnapshot DurationHistogram::Snapshot() const
+{
+    DurationSnapshot snapshot;
+    snapshot.count = mCount.load(std::memory_order_relaxed);
+    snapshot.max = mMax.load(std::memory_order_relaxed);
+    snapshot.sum = mSum.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < DURATION_BUCKETS; i++)
+    {
+        snapshot.buckets[i] = mBuckets[i].load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+void NotifyStats::Arrived(Clock::time_point now, size_t bytes)
+{
+    mNotifications.fetch_add(1, std::memory_order_relaxed);
+    mBytes.fetch_add(bytes, std::memory_order_relaxed);
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch());
+    // the clock never reads 0 in practice, it only marks the first notification
+    auto last = mLastArrival.exchange(std::max<int64_t>(micros.count(), 1),
+                                      std::memory_order_relaxed);
+    if (last != 0)
+    {
+        mGaps.Add(static_cast<uint64_t>(std::max<int64_t>(micros.count() - last, 0)));
+    }
+}
+
+void NotifyStats::Dispatched(Clock::time_point arrival, Clock::time_point now)
+{
+    mQueueDelay.Add(toMicros(now - arrival));
+}
+
+void NotifyStats::Throttled()
+{
+    mThrottled.fetch_add(1, std::memory_order_relaxed);
+}
+
+void NotifyStats::DecodeError()
+{
+    mDecodeErrors.fetch_add(1, std::memory_order_relaxed);
+}
+
+NotifyStatsSnapshot NotifyStats::Snapshot() const
+{
+    NotifyStatsSnapshot snapshot;
+    snapshot.notifications = mNotifications.load(std::memory_order_relaxed);
+    snapshot.bytes = mBytes.load(std::memory_order_relaxed);
+    snapshot.throttled = mThrottled.load(std::memory_order_relaxed);
+    snapshot.decodeErrors = mDecodeErrors.load(std::memory_order_relaxed);
+    snapshot.gaps = mGaps.Snapshot();
+    snapshot.queueDelay = mQueueDelay.Snapshot();
+    return snapshot;
+}
+
+std::optional<NotifyStats::Clock::time_point> NotifyStats::LastArrival() const
+{
+    auto micros = mLastArrival.load(std::memory_order_relaxed);
+    if (micros == 0)
+    {
+        return std::nullopt;
+    }
+    return Clock::time_point(std::chrono::microseconds(micros));
+}
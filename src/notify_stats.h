@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+const size_t DURATION_BUCKETS = 32;
+
+struct DurationSnapshot
+{
+    uint64_t count = 0;
+    // in microseconds
+    uint64_t max = 0;
+    uint64_t sum = 0;
+    // bucket 0 counts durations of 0 us, bucket i > 0 durations from 2^(i - 1) up to 2^i us
+    std::array<uint64_t, DURATION_BUCKETS> buckets = {};
+};
+
+// Histogram of durations with power of two buckets, can be updated from any thread without a lock.
+class DurationHistogram
+{
+public:
+    void Add(uint64_t micros);
+    DurationSnapshot Snapshot() const;
+
+private:
+    std::array<std::atomic<uint64_t>, DURATION_BUCKETS> mBuckets = {};
+    std::atomic<uint64_t> mCount = 0;
+    std::atomic<uint64_t> mMax = 0;
+    std::atomic<uint64_t> mSum = 0;
+};
+
+struct NotifyStatsSnapshot
+{
+    uint64_t notifications = 0;
+    uint64_t bytes = 0;
+    uint64_t throttled = 0;
+    uint64_t decodeErrors = 0;
+    // time between consecutive notifications
+    DurationSnapshot gaps;
+    // time from the arrival of a notification until its event is dispatched in JS
+    DurationSnapshot queueDelay;
+};
+
+// Counters of one subscription, cheap enough to stay on: an update is a few relaxed atomics.
+class NotifyStats
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void Arrived(Clock::time_point now, size_t bytes);
+    void Dispatched(Clock::time_point arrival, Clock::time_point now);
+    void Throttled();
+    void DecodeError();
+
+    NotifyStatsSnapshot Snapshot() const;
+    // nothing before the first notification
+    std::optional<Clock::time_point> LastArrival() const;
+
+private:
+    std::atomic<uint64_t> mNotifications = 0;
+    std::atomic<uint64_t> mBytes = 0;
+    std::atomic<uint64_t> mThrottled = 0;
+    std::atomic<uint64_t> mDecodeErrors = 0;
+    // arrival of the last notification in microseconds, 0 before the first one
+    std::atomic<int64_t> mLastArrival = 0;
+    DurationHistogram mGaps;
+    DurationHistogram mQueueDelay;
+};
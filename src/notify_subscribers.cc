@@ -0,0 +1,81 @@
+#include "notify_subscribers.h"
+
+#include <algorithm>
+
+bool NotifySubscribers::Add(const std::string& id, const SubscriberOptions& options)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = std::find_if(mSubscribers.begin(), mSubscribers.end(),
+                           [&](const Subscriber& subscriber) { return subscriber.id == id; });
+    if (it != mSubscribers.end())
+    {
+        it->options = options;
+        Update();
+        return false;
+    }
+    mSubscribers.push_back({ id, options, {}, false });
+    Update();
+    return true;
+}
+
+bool NotifySubscribers::Remove(const std::string& id)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = std::find_if(mSubscribers.begin(), mSubscribers.end(),
+                           [&](const Subscriber& subscriber) { return subscriber.id == id; });
+    if (it == mSubscribers.end())
+    {
+        return false;
+    }
+    mSubscribers.erase(it);
+    Update();
+    return true;
+}
+
+bool NotifySubscribers::Empty() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mSubscribers.empty();
+}
+
+SubscriberIds NotifySubscribers::Deliver(std::chrono::steady_clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mLimited)
+    {
+        return mAll;
+    }
+    std::vector<std::string> due;
+    for (auto& subscriber : mSubscribers)
+    {
+        if (subscriber.delivered && now - subscriber.last < subscriber.options.minInterval)
+        {
+            continue;
+        }
+        subscriber.delivered = true;
+        subscriber.last = now;
+        due.push_back(subscriber.id);
+    }
+    if (due.empty())
+    {
+        return nullptr;
+    }
+    if (due.size() == mSubscribers.size())
+    {
+        return mAll;
+    }
+    return std::make_shared<const std::vector<std::string>>(std::move(due));
+}
+
+// rebuilds the list that is handed out when nobody is rate limited
+void NotifySubscribers::Update()
+{
+    std::vector<std::string> ids;
+    mLimited = false;
+    for (auto& subscriber : mSubscribers)
+    {
+        ids.push_back(subscriber.id);
+        mLimited = mLimited || subscriber.options.minInterval.count() > 0;
+    }
+    mAll = ids.empty() ? nullptr : std::make_shared<const std::vector<std::string>>(std::move(ids));
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct SubscriberOptions
+{
+    // notifications that arrive sooner after the last one delivered to the subscriber are dropped
+    std::chrono::milliseconds minInterval = std::chrono::milliseconds(0);
+};
+
+using SubscriberIds = std::shared_ptr<const std::vector<std::string>>;
+
+// The consumers of the notifications of one characteristic, each with its own rate limit.
+class NotifySubscribers
+{
+public:
+    // Adds the subscriber or updates its options, returns false if it was already subscribed.
+    bool Add(const std::string& id, const SubscriberOptions& options);
+    // Returns false if it wasn't subscribed.
+    bool Remove(const std::string& id);
+    bool Empty() const;
+
+    // The subscribers that get a notification that arrived at `now`, nullptr if every subscriber
+    // is rate limited. Without rate limits this is always the same list.
+    SubscriberIds Deliver(std::chrono::steady_clock::time_point now);
+
+private:
+    struct Subscriber
+    {
+        std::string id;
+        SubscriberOptions options;
+        std::chrono::steady_clock::time_point last;
+        bool delivered = false;
+    };
+
+    void Update();
+
+    mutable std::mutex mMutex;
+    std::vector<Subscriber> mSubscribers;
+    SubscriberIds mAll;
+    bool mLimited = false;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+// status of a failed operation as reported to JS, the first values match GattCommunicationStatus
+enum class OperationStatus : int
+{
+    Success = 0,
+    Unreachable = 1,
+    ProtocolError = 2,
+    AccessDenied = 3,
+    // the service, characteristic, descriptor or handle doesn't exist
+    NotFound = 4,
+    // the operation didn't complete before its deadline
+    Timeout = 5,
+    // the operation was cancelled, e.g. because the device disconnected
+    Cancelled = 6,
+    // the async operation failed
+    Failed = 7,
+    // the device isn't connected or disconnected during the operation
+    NotConnected = 8,
+};
+
+struct OperationError
+{
+    OperationStatus status = OperationStatus::Success;
+    std::string message;
+
+    explicit operator bool() const
+    {
+        return status != OperationStatus::Success;
+    }
+};
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Bytes that are handed on without copying them, `owner` keeps them alive. The bytes aren't
+// modified once a payload has been created.
+struct Payload
+{
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    std::shared_ptr<const void> owner;
+
+    Payload() = default;
+
+    Payload(const uint8_t* data, size_t size, std::shared_ptr<const void> owner)
+        : data(data), size(size), owner(std::move(owner))
+    {
+    }
+
+    // takes over the bytes of the vector
+    explicit Payload(std::vector<uint8_t> bytes)
+    {
+        auto shared = std::make_shared<const std::vector<uint8_t>>(std::move(bytes));
+        data = shared->data();
+        size = shared->size();
+        owner = std::move(shared);
+    }
+
+    bool empty() const
+    {
+        return size == 0;
+    }
+
+    const uint8_t* begin() const
+    {
+        return data;
+    }
+
+    const uint8_t* end() const
+    {
+        return data + size;
+    }
+};
@@ -0,0 +1,190 @@
+#include "payload_decoder.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+static size_t fieldSize(const FieldSpec& field)
+{
+    switch (field.type)
+    {
+    case FieldType::UInt8:
+    case FieldType::Int8:
+        return 1;
+    case FieldType::UInt16:
+    case FieldType::Int16:
+        return 2;
+    case FieldType::UInt24:
+    case FieldType::Int24:
+        return 3;
+    case FieldType::UInt32:
+    case FieldType::Int32:
+    case FieldType::Float32:
+        return 4;
+    case FieldType::Skip:
+        return field.size;
+    }
+    return 0;
+}
+
+static uint32_t readUnsigned(const uint8_t* data, size_t size, bool bigEndian)
+{
+    uint32_t value = 0;
+    for (size_t i = 0; i < size; i++)
+    {
+        size_t shift = 8 * (bigEndian ? size - 1 - i : i);
+        value |= static_cast<uint32_t>(data[i]) << shift;
+    }
+    return value;
+}
+
+static double readField(FieldType type, bool bigEndian, const uint8_t* data)
+{
+    switch (type)
+    {
+    case FieldType::UInt8:
+        return data[0];
+    case FieldType::Int8:
+        return static_cast<int8_t>(data[0]);
+    case FieldType::UInt16:
+        return readUnsigned(data, 2, bigEndian);
+    case FieldType::Int16:
+        return static_cast<int16_t>(readUnsigned(data, 2, bigEndian));
+    case FieldType::UInt24:
+        return readUnsigned(data, 3, bigEndian);
+    case FieldType::Int24:
+    {
+        // sign extend from bit 23
+        auto value = readUnsigned(data, 3, bigEndian);
+        return static_cast<int32_t>(value << 8) >> 8;
+    }
+    case FieldType::UInt32:
+        return readUnsigned(data, 4, bigEndian);
+    case FieldType::Int32:
+        return static_cast<int32_t>(readUnsigned(data, 4, bigEndian));
+    case FieldType::Float32:
+    {
+        auto bits = readUnsigned(data, 4, bigEndian);
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    case FieldType::Skip:
+        break;
+    }
+    return 0;
+}
+
+static int32_t toInt32(double value)
+{
+    if (std::isnan(value))
+    {
+        return 0;
+    }
+    value = std::round(value);
+    if (value <= std::numeric_limits<int32_t>::min())
+    {
+        return std::numeric_limits<int32_t>::min();
+    }
+    if (value >= std::numeric_limits<int32_t>::max())
+    {
+        return std::numeric_limits<int32_t>::max();
+    }
+    return static_cast<int32_t>(value);
+}
+
+size_t PayloadDecoder::Compile(const std::vector<FieldSpec>& fields, std::vector<Step>& steps)
+{
+    size_t position = 0;
+    for (auto& field : fields)
+    {
+        if (field.type != FieldType::Skip)
+        {
+            bool scaled = field.scale != 1 || field.offset != 0;
+            steps.push_back({ field.type, field.bigEndian, scaled,
+                              static_cast<uint32_t>(position), field.scale, field.offset });
+        }
+        position += fieldSize(field);
+    }
+    return position;
+}
+
+std::optional<PayloadDecoder> PayloadDecoder::Compile(const DecoderSchema& schema)
+{
+    PayloadDecoder decoder;
+    decoder.mOutput = schema.output;
+    decoder.mFieldsSize = Compile(schema.fields, decoder.mFields);
+    decoder.mRepeatSize = Compile(schema.repeat, decoder.mRepeat);
+    if (decoder.mFields.empty() && decoder.mRepeat.empty())
+    {
+        return std::nullopt;
+    }
+    if (!schema.repeat.empty() && decoder.mRepeatSize == 0)
+    {
+        return std::nullopt;
+    }
+    return decoder;
+}
+
+template <typename T>
+void PayloadDecoder::Run(const std::vector<Step>& steps, const uint8_t* data,
+                         std::vector<T>& out) const
+{
+    for (auto& step : steps)
+    {
+        double value = readField(step.type, step.bigEndian, data + step.position);
+        if (step.scaled)
+        {
+            value = value * step.scale + step.offset;
+        }
+        if constexpr (std::is_same_v<T, float>)
+        {
+            out.push_back(static_cast<float>(value));
+        }
+        else
+        {
+            out.push_back(toInt32(value));
+        }
+    }
+}
+
+bool PayloadDecoder::Decode(const uint8_t* data, size_t size, DecodedValues& values) const
+{
+    if (size < mFieldsSize)
+    {
+        return false;
+    }
+    size_t rows = 0;
+    if (mRepeatSize > 0)
+    {
+        size_t rest = size - mFieldsSize;
+        if (rest % mRepeatSize != 0)
+        {
+            return false;
+        }
+        rows = rest / mRepeatSize;
+    }
+    size_t count = mFields.size() + rows * mRepeat.size();
+    values.output = mOutput;
+    values.rows += rows;
+    if (mOutput == DecoderOutput::Float32)
+    {
+        values.floats.reserve(values.floats.size() + count);
+        Run(mFields, data, values.floats);
+        for (size_t row = 0; row < rows; row++)
+        {
+            Run(mRepeat, data + mFieldsSize + row * mRepeatSize, values.floats);
+        }
+    }
+    else
+    {
+        values.ints.reserve(values.ints.size() + count);
+        Run(mFields, data, values.ints);
+        for (size_t row = 0; row < rows; row++)
+        {
+            Run(mRepeat, data + mFieldsSize + row * mRepeatSize, values.ints);
+        }
+    }
+    return true;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+enum class FieldType
+{
+    UInt8,
+    Int8,
+    UInt16,
+    Int16,
+    UInt24,
+    Int24,
+    UInt32,
+    Int32,
+    Float32,
+    // `size` bytes that aren't decoded
+    Skip,
+};
+
+// A field is decoded as raw * scale + offset.
+struct FieldSpec
+{
+    FieldType type = FieldType::UInt8;
+    bool bigEndian = false;
+    double scale = 1;
+    double offset = 0;
+    size_t size = 0;
+};
+
+enum class DecoderOutput
+{
+    Float32,
+    // values are rounded after scaling
+    Int32,
+};
+
+// Layout of a payload: `fields` once at the start, followed by `repeat` as often as it fits.
+struct DecoderSchema
+{
+    std::vector<FieldSpec> fields;
+    std::vector<FieldSpec> repeat;
+    DecoderOutput output = DecoderOutput::Float32;
+};
+
+// decoded values, the fields followed by the rows of the repeated group, Decode appends to them
+struct DecodedValues
+{
+    DecoderOutput output = DecoderOutput::Float32;
+    std::vector<float> floats;
+    std::vector<int32_t> ints;
+    size_t rows = 0;
+};
+
+// A schema compiled into fixed byte positions, decoding only walks the precomputed steps.
+class PayloadDecoder
+{
+public:
+    // nothing if the schema doesn't decode any value or the repeated group has no size
+    static std::optional<PayloadDecoder> Compile(const DecoderSchema& schema);
+
+    // Returns false if the payload is shorter than the fields or ends within a repeated group.
+    bool Decode(const uint8_t* data, size_t size, DecodedValues& values) const;
+
+    DecoderOutput Output() const
+    {
+        return mOutput;
+    }
+
+private:
+    struct Step
+    {
+        FieldType type;
+        bool bigEndian;
+        bool scaled;
+        uint32_t position;
+        double scale;
+        double offset;
+    };
+
+    static size_t Compile(const std::vector<FieldSpec>& fields, std::vector<Step>& steps);
+    template <typename T>
+    void Run(const std::vector<Step>& steps, const uint8_t* data, std::vector<T>& out) const;
+
+    std::vector<Step> mFields;
+    size_t mFieldsSize = 0;
+    std::vector<Step> mRepeat;
+    size_t mRepeatSize = 0;
+    DecoderOutput mOutput = DecoderOutput::Float32;
+};
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "callable.h"
+
+// inline capacity of a lookup callback, enough for the captures of the GATT operations that wait
+// for an attribute
+const size_t LOOKUP_CALLBACK_CAPACITY = 256;
+
+template <typename Value>
+using LookupCallback = Callable<void(std::optional<Value>), LOOKUP_CALLBACK_CAPACITY>;
+
+// Table of in-flight lookups: concurrent requests for the same key wait for the one async
+// operation that was started by the first request instead of starting their own.
+template <typename Key, typename Value, typename Hash = std::hash<Key>> class PendingLookups
+{
+public:
+    using Callback = LookupCallback<Value>;
+
+    PendingLookups() = default;
+    // a peripheral is only moved into the device map before any lookup is started
+    PendingLookups(PendingLookups&& other) : mPending(std::move(other.mPending))
+    {
+    }
+
+    // Registers the callback, returns true if the caller has to start the lookup.
+    bool Add(const Key& key, Callback callback)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto& waiters = mPending[key];
+        waiters.push_back(std::move(callback));
+        return waiters.size() == 1;
+    }
+
+    // Completes all callbacks that are waiting for the key.
+    void Complete(const Key& key, std::optional<Value> value)
+    {
+        std::vector<Callback> waiters;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto it = mPending.find(key);
+            if (it == mPending.end())
+            {
+                return;
+            }
+            waiters = std::move(it->second);
+            mPending.erase(it);
+        }
+        for (auto& waiter : waiters)
+        {
+            waiter(value);
+        }
+    }
+
+    // Fails all lookups that are still in flight.
+    void Clear()
+    {
+        std::unordered_map<Key, std::vector<Callback>, Hash> pending;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            pending.swap(mPending);
+        }
+        for (auto& entry : pending)
+        {
+            for (auto& waiter : entry.second)
+            {
+                waiter(std::nullopt);
+            }
+        }
+    }
+
+private:
+    std::mutex mMutex;
+    std::unordered_map<Key, std::vector<Callback>, Hash> mPending;
+};
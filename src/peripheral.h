@@ -1,7 +1,80 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
+
+#include "notify_ring.h"
+#include "notify_stats.h"
+#include "notify_subscribers.h"
+#include "operation_error.h"
+#include "payload.h"
+#include "payload_decoder.h"
+
 using Data = std::vector<uint8_t>;
 
+struct DiscoveredCharacteristic
+{
+    std::string uuid;
+    std::vector<std::string> properties;
+    std::vector<std::string> descriptorUuids;
+    // set if the descriptors couldn't be discovered
+    OperationError error;
+};
+
+struct DiscoveredService
+{
+    std::string uuid;
+    std::vector<DiscoveredCharacteristic> characteristics;
+    // set if the characteristics couldn't be discovered
+    OperationError error;
+};
+
+// result of one item of a batch operation
+struct BatchItemResult
+{
+    std::string serviceUuid;
+    std::string characteristicUuid;
+    Payload data;
+    OperationError error;
+};
+
+// How the notifications of a characteristic are handed to JS, by default as raw read events.
+struct NotifyDelivery
+{
+    // decoded into typed arrays
+    std::shared_ptr<const PayloadDecoder> decoder;
+    // written into a ring in memory shared with JS, without any event
+    std::shared_ptr<NotifyRing> ring;
+};
+
+// Everything delivering a notification needs, built once when subscribing so that a notification
+// doesn't look anything up or format anything. The ids are already in the form emitted to JS.
+struct SubscriptionContext
+{
+    std::string uuid;
+    std::string serviceUuid;
+    std::string characteristicUuid;
+    NotifySubscribers subscribers;
+    NotifyStats stats;
+
+    NotifyDelivery Delivery()
+    {
+        std::lock_guard<std::mutex> lock(deliveryMutex);
+        return delivery;
+    }
+
+    void SetDelivery(NotifyDelivery value)
+    {
+        std::lock_guard<std::mutex> lock(deliveryMutex);
+        delivery = std::move(value);
+    }
+
+private:
+    // replaced while notifications arrive
+    std::mutex deliveryMutex;
+    NotifyDelivery delivery;
+};
+
 enum AddressType
 {
     PUBLIC,
@@ -1,14 +1,14 @@
 #include "peripheral_winrt.h"
+#include "winrt_buffer.h"
 #include "winrt_cpp.h"
 
-#include <winrt/Windows.Storage.Streams.h>
-using namespace winrt::Windows::Storage::Streams;
-
 using winrt::Windows::Devices::Bluetooth::BluetoothCacheMode;
 using winrt::Windows::Devices::Bluetooth::GenericAttributeProfile::GattCharacteristicsResult;
+using winrt::Windows::Devices::Bluetooth::GenericAttributeProfile::GattCommunicationStatus;
 using winrt::Windows::Devices::Bluetooth::GenericAttributeProfile::GattDescriptorsResult;
 using winrt::Windows::Devices::Bluetooth::GenericAttributeProfile::GattDeviceServicesResult;
 using winrt::Windows::Foundation::AsyncStatus;
+using winrt::Windows::Foundation::IAsyncAction;
 using winrt::Windows::Foundation::IAsyncOperation;
 
 PeripheralWinrt::PeripheralWinrt(uint64_t bluetoothAddress,
@@ -22,12 +22,26 @@ PeripheralWinrt::PeripheralWinrt(uint64_t bluetoothAddress,
     Update(rssiValue, advertisment, advertismentType);
 }
 
+PeripheralWinrt::PeripheralWinrt(uint64_t bluetoothAddress)
+{
+    this->bluetoothAddress = bluetoothAddress;
+    address = formatBluetoothAddress(bluetoothAddress);
+    addressType = (bluetoothAddress >= 211106232532992) ? RANDOM : PUBLIC;
+    connectable = true;
+    // unknown until it advertises
+    rssi = 127;
+}
+
 PeripheralWinrt::~PeripheralWinrt()
 {
     if (device.has_value() && connectionToken)
     {
         device->ConnectionStatusChanged(connectionToken);
     }
+    if (session.has_value() && mtuToken)
+    {
+        session->MaxPduSizeChanged(mtuToken);
+    }
 }
 
 void PeripheralWinrt::Update(const int rssiValue, const BluetoothLEAdvertisement& advertisment,
@@ -48,19 +62,19 @@ void PeripheralWinrt::Update(const int rssiValue, const BluetoothLEAdvertisement
         if (ds.DataType() == BluetoothLEAdvertisementDataTypes::TxPowerLevel())
         {
             auto d = ds.Data();
-            auto dr = DataReader::FromBuffer(d);
-            txPowerLevel = dr.ReadByte();
-            if (txPowerLevel >= 128)
-                txPowerLevel -= 256;
-            dr.Close();
+            auto bytes = bufferBytes(d);
+            if (!bytes.empty())
+            {
+                txPowerLevel = bytes[0];
+                if (txPowerLevel >= 128)
+                    txPowerLevel -= 256;
+            }
         }
         if (ds.DataType() == BluetoothLEAdvertisementDataTypes::ManufacturerSpecificData())
         {
             auto d = ds.Data();
-            auto dr = DataReader::FromBuffer(d);
-            manufacturerData.resize(d.Length());
-            dr.ReadBytes(manufacturerData);
-            dr.Close();
+            auto bytes = bufferBytes(d);
+            manufacturerData.assign(bytes.begin(), bytes.end());
         }
     }
 
@@ -75,20 +89,116 @@ void PeripheralWinrt::Update(const int rssiValue, const BluetoothLEAdvertisement
 
 void PeripheralWinrt::Disconnect()
 {
-    cachedServices.clear();
+    attributes.Clear();
+    cache.Clear();
+    pendingServices.Clear();
+    pendingCharacteristics.Clear();
+    pendingDescriptors.Clear();
+    pendingLoad.Clear();
     if (device.has_value() && connectionToken)
     {
         device->ConnectionStatusChanged(connectionToken);
     }
+    if (session.has_value())
+    {
+        if (mtuToken)
+        {
+            session->MaxPduSizeChanged(mtuToken);
+        }
+        session->Close();
+    }
+    if (parametersRequest)
+    {
+        parametersRequest.Close();
+        parametersRequest = nullptr;
+    }
     device = std::nullopt;
+    session = std::nullopt;
+    mtu = DEFAULT_ATT_MTU;
+}
+
+void PeripheralWinrt::SetLookupPolicy(const CachePolicy& policy)
+{
+    cache.SetLookupPolicy(policy);
 }
 
-void PeripheralWinrt::GetServiceFromDevice(
-    winrt::guid serviceUuid, std::function<void(std::optional<GattDeviceService>)> callback)
+BluetoothCacheMode PeripheralWinrt::DiscoveryCacheMode(const AttributeKey& parent,
+                                                       const CachePolicy& policy)
 {
-    if (device.has_value())
+    // an uncached discovery only revalidates the cache once it has succeeded
+    return cache.DiscoveryFresh(parent, policy, std::chrono::steady_clock::now())
+        ? BluetoothCacheMode::Cached
+        : BluetoothCacheMode::Uncached;
+}
+
+void PeripheralWinrt::Discovered(const AttributeKey& parent,
+                                 std::chrono::steady_clock::time_point startedAt)
+{
+    cache.Discovered(parent, startedAt);
+}
+
+BluetoothCacheMode PeripheralWinrt::LookupCacheMode()
+{
+    return cache.LookupFresh(std::chrono::steady_clock::now()) ? BluetoothCacheMode::Cached
+                                                               : BluetoothCacheMode::Uncached;
+}
+
+void PeripheralWinrt::ExpireLookups()
+{
+    if (cache.LookupsExpired(std::chrono::steady_clock::now()))
     {
-        device->GetGattServicesForUuidAsync(serviceUuid, BluetoothCacheMode::Cached)
+        // drop the attributes so that they are looked up again with the uncached mode
+        attributes.Clear();
+    }
+}
+
+std::optional<Payload> PeripheralWinrt::GetCachedValue(const AttributeKey& key,
+                                                       const CachePolicy& policy)
+{
+    return cache.Value(key, policy, std::chrono::steady_clock::now());
+}
+
+void PeripheralWinrt::CacheValue(const AttributeKey& key, const Payload& data)
+{
+    cache.SetValue(key, data, std::chrono::steady_clock::now());
+}
+
+void PeripheralWinrt::CacheService(GattDeviceService service)
+{
+    attributes.Add(service.Uuid(), service);
+}
+
+void PeripheralWinrt::CacheCharacteristic(winrt::guid serviceUuid,
+                                          GattCharacteristic characteristic)
+{
+    attributes.Add(serviceUuid, characteristic.Uuid(), characteristic);
+}
+
+void PeripheralWinrt::CacheDescriptor(winrt::guid serviceUuid, winrt::guid characteristicUuid,
+                                      GattDescriptor descriptor)
+{
+    attributes.Add(serviceUuid, characteristicUuid, descriptor.Uuid(), descriptor);
+}
+
+void PeripheralWinrt::GetServiceFromDevice(winrt::guid serviceUuid,
+                                           LookupCallback<GattDeviceService> callback)
+{
+    if (!device.has_value())
+    {
+        printf("GetGattServicesForUuidAsync: no device currently connected\n");
+        callback(std::nullopt);
+        return;
+    }
+    AttributeKey key = { serviceUuid };
+    if (!pendingServices.Add(key, std::move(callback)))
+    {
+        // there is already a lookup for this service in flight
+        return;
+    }
+    // the lookup can't be started if the device object has been closed
+    try
+    {
+        device->GetGattServicesForUuidAsync(serviceUuid, LookupCacheMode())
             .Completed([=](IAsyncOperation<GattDeviceServicesResult> result, auto& status) {
                 if (status == AsyncStatus::Completed)
                 {
@@ -97,200 +207,286 @@ void PeripheralWinrt::GetServiceFromDevice(
                     if (service.HasCurrent())
                     {
                         GattDeviceService& s = service.Current();
-                        cachedServices.insert(std::make_pair(serviceUuid, CachedService(s)));
-                        callback(s);
+                        attributes.Add(serviceUuid, s);
+                        pendingServices.Complete(key, s);
                     }
                     else
                     {
                         printf("GetGattServicesForUuidAsync: no service with given id\n");
-                        callback(std::nullopt);
+                        pendingServices.Complete(key, std::nullopt);
                     }
                 }
                 else
                 {
                     printf("GetGattServicesForUuidAsync: failed with status: %d\n", status);
-                    callback(std::nullopt);
+                    pendingServices.Complete(key, std::nullopt);
                 }
             });
     }
-    else
+    catch (const winrt::hresult_error& e)
     {
-        printf("GetGattServicesForUuidAsync: no device currently connected\n");
-        callback(std::nullopt);
+        printf("GetGattServicesForUuidAsync: %s\n", winrt::to_string(e.message()).c_str());
+        pendingServices.Complete(key, std::nullopt);
     }
 }
 
-void PeripheralWinrt::GetService(winrt::guid serviceUuid,
-                                 std::function<void(std::optional<GattDeviceService>)> callback)
+Task<std::optional<GattDeviceService>> PeripheralWinrt::ServiceAsync(winrt::guid serviceUuid)
 {
-    auto it = cachedServices.find(serviceUuid);
-    if (it != cachedServices.end())
+    ExpireLookups();
+    auto service = attributes.Find({ serviceUuid });
+    if (service)
     {
-        callback(it->second.service);
+        co_return service->service;
     }
-    else
+    co_return co_await awaitCallback<std::optional<GattDeviceService>>(
+        [&](auto callback) { GetServiceFromDevice(serviceUuid, callback); });
+}
+
+void PeripheralWinrt::GetService(winrt::guid serviceUuid,
+                                 LookupCallback<GattDeviceService> callback)
+{
+    ExpireLookups();
+    // a cached service doesn't need a coroutine frame
+    auto service = attributes.Find({ serviceUuid });
+    if (service)
     {
-        GetServiceFromDevice(serviceUuid, callback);
+        callback(service->service);
+        return;
     }
+    startTask(ServiceAsync(serviceUuid), std::move(callback));
 }
 
 void PeripheralWinrt::GetCharacteristicFromService(
-    GattDeviceService service, winrt::guid characteristicUuid,
-    std::function<void(std::optional<GattCharacteristic>)> callback)
+    GattDeviceService service, winrt::guid serviceUuid, winrt::guid characteristicUuid,
+    LookupCallback<GattCharacteristic> callback)
 {
-    service.GetCharacteristicsForUuidAsync(characteristicUuid, BluetoothCacheMode::Cached)
-        .Completed([=](IAsyncOperation<GattCharacteristicsResult> result, auto& status) {
-            if (status == AsyncStatus::Completed)
-            {
-                auto& characteristics = result.GetResults();
-                auto& characteristic = characteristics.Characteristics().First();
-                if (characteristic.HasCurrent())
+    AttributeKey key = { serviceUuid, characteristicUuid };
+    if (!pendingCharacteristics.Add(key, std::move(callback)))
+    {
+        // there is already a lookup for this characteristic in flight
+        return;
+    }
+    // the lookup can't be started if the device object has been closed
+    try
+    {
+        service.GetCharacteristicsForUuidAsync(characteristicUuid, LookupCacheMode())
+            .Completed([=](IAsyncOperation<GattCharacteristicsResult> result, auto& status) {
+                if (status == AsyncStatus::Completed)
                 {
-                    winrt::guid serviceUuid = service.Uuid();
-                    CachedService& cachedService = cachedServices[serviceUuid];
-                    GattCharacteristic& c = characteristic.Current();
-                    cachedService.characterisitics.insert(
-                        std::make_pair(c.Uuid(), CachedCharacteristic(c)));
-                    callback(c);
+                    auto& characteristics = result.GetResults();
+                    auto& characteristic = characteristics.Characteristics().First();
+                    if (characteristic.HasCurrent())
+                    {
+                        GattCharacteristic& c = characteristic.Current();
+                        attributes.Add(serviceUuid, characteristicUuid, c);
+                        pendingCharacteristics.Complete(key, c);
+                    }
+                    else
+                    {
+                        printf("GetCharacteristicsForUuidAsync: no characteristic with given id\n");
+                        pendingCharacteristics.Complete(key, std::nullopt);
+                    }
                 }
                 else
                 {
-                    printf("GetCharacteristicsForUuidAsync: no characteristic with given id\n");
-                    callback(std::nullopt);
+                    printf("GetCharacteristicsForUuidAsync: failed with status: %d\n", status);
+                    pendingCharacteristics.Complete(key, std::nullopt);
                 }
-            }
-            else
-            {
-                printf("GetCharacteristicsForUuidAsync: failed with status: %d\n", status);
-                callback(std::nullopt);
-            }
-        });
+            });
+    }
+    catch (const winrt::hresult_error& e)
+    {
+        printf("GetCharacteristicsForUuidAsync: %s\n", winrt::to_string(e.message()).c_str());
+        pendingCharacteristics.Complete(key, std::nullopt);
+    }
 }
 
-void PeripheralWinrt::GetCharacteristic(
-    winrt::guid serviceUuid, winrt::guid characteristicUuid,
-    std::function<void(std::optional<GattCharacteristic>)> callback)
+Task<std::optional<GattCharacteristic>>
+PeripheralWinrt::CharacteristicAsync(winrt::guid serviceUuid, winrt::guid characteristicUuid)
 {
-    auto it = cachedServices.find(serviceUuid);
-    if (it != cachedServices.end())
+    ExpireLookups();
+    auto characteristic = attributes.Find({ serviceUuid, characteristicUuid });
+    if (characteristic)
     {
-        auto& cachedService = it->second;
-        auto cit = cachedService.characterisitics.find(characteristicUuid);
-        if (cit != cachedService.characterisitics.end())
-        {
-            callback(cit->second.characteristic);
-        }
-        else
-        {
-            GetCharacteristicFromService(cachedService.service, characteristicUuid, callback);
-        }
+        co_return characteristic->characteristic;
     }
-    else
+    auto service = co_await ServiceAsync(serviceUuid);
+    if (!service)
     {
-        GetServiceFromDevice(serviceUuid, [=](std::optional<GattDeviceService> service) {
-            if (service)
-            {
-                GetCharacteristicFromService(*service, characteristicUuid, callback);
-            }
-            else
-            {
-                printf("GetCharacteristic: get service failed\n");
-                callback(nullptr);
-            }
-        });
+        printf("GetCharacteristic: get service failed\n");
+        co_return std::nullopt;
+    }
+    co_return co_await awaitCallback<std::optional<GattCharacteristic>>([&](auto callback) {
+        GetCharacteristicFromService(*service, serviceUuid, characteristicUuid, callback);
+    });
+}
+
+void PeripheralWinrt::GetCharacteristic(winrt::guid serviceUuid, winrt::guid characteristicUuid,
+                                        LookupCallback<GattCharacteristic> callback)
+{
+    ExpireLookups();
+    auto characteristic = attributes.Find({ serviceUuid, characteristicUuid });
+    if (characteristic)
+    {
+        callback(characteristic->characteristic);
+        return;
     }
+    startTask(CharacteristicAsync(serviceUuid, characteristicUuid), std::move(callback));
 }
 
 void PeripheralWinrt::GetDescriptorFromCharacteristic(
-    GattCharacteristic characteristic, winrt::guid descriptorUuid,
-    std::function<void(std::optional<GattDescriptor>)> callback)
+    GattCharacteristic characteristic, winrt::guid serviceUuid, winrt::guid characteristicUuid,
+    winrt::guid descriptorUuid, LookupCallback<GattDescriptor> callback)
 {
-    characteristic.GetDescriptorsForUuidAsync(descriptorUuid, BluetoothCacheMode::Cached)
-        .Completed([=](IAsyncOperation<GattDescriptorsResult> result, auto& status) {
-            if (status == AsyncStatus::Completed)
-            {
-                auto& descriptors = result.GetResults();
-                auto& descriptor = descriptors.Descriptors().First();
-                if (descriptor.HasCurrent())
+    AttributeKey key = { serviceUuid, characteristicUuid, descriptorUuid };
+    if (!pendingDescriptors.Add(key, std::move(callback)))
+    {
+        // there is already a lookup for this descriptor in flight
+        return;
+    }
+    // the lookup can't be started if the device object has been closed
+    try
+    {
+        characteristic.GetDescriptorsForUuidAsync(descriptorUuid, LookupCacheMode())
+            .Completed([=](IAsyncOperation<GattDescriptorsResult> result, auto& status) {
+                if (status == AsyncStatus::Completed)
                 {
-                    GattDescriptor d = descriptor.Current();
-                    winrt::guid characteristicUuid = characteristic.Uuid();
-                    winrt::guid descriptorUuid = d.Uuid();
-                    winrt::guid serviceUuid = characteristic.Service().Uuid();
-                    CachedService& cachedService = cachedServices[serviceUuid];
-                    CachedCharacteristic& c = cachedService.characterisitics[characteristicUuid];
-                    c.descriptors.insert(std::make_pair(descriptorUuid, d));
-                    callback(d);
+                    auto& descriptors = result.GetResults();
+                    auto& descriptor = descriptors.Descriptors().First();
+                    if (descriptor.HasCurrent())
+                    {
+                        GattDescriptor d = descriptor.Current();
+                        attributes.Add(serviceUuid, characteristicUuid, descriptorUuid, d);
+                        pendingDescriptors.Complete(key, d);
+                    }
+                    else
+                    {
+                        printf("GetDescriptorsForUuidAsync: no characteristic with given id\n");
+                        pendingDescriptors.Complete(key, std::nullopt);
+                    }
                 }
                 else
                 {
-                    printf("GetDescriptorsForUuidAsync: no characteristic with given id\n");
-                    callback(std::nullopt);
+                    printf("GetDescriptorsForUuidAsync: failed with status: %d\n", status);
+                    pendingDescriptors.Complete(key, std::nullopt);
                 }
-            }
-            else
-            {
-                printf("GetDescriptorsForUuidAsync: failed with status: %d\n", status);
-                callback(std::nullopt);
-            }
-        });
+            });
+    }
+    catch (const winrt::hresult_error& e)
+    {
+        printf("GetDescriptorsForUuidAsync: %s\n", winrt::to_string(e.message()).c_str());
+        pendingDescriptors.Complete(key, std::nullopt);
+    }
+}
+
+Task<std::optional<GattDescriptor>> PeripheralWinrt::DescriptorAsync(winrt::guid serviceUuid,
+                                                                    winrt::guid characteristicUuid,
+                                                                    winrt::guid descriptorUuid)
+{
+    ExpireLookups();
+    auto descriptor = attributes.Find({ serviceUuid, characteristicUuid, descriptorUuid });
+    if (descriptor)
+    {
+        co_return descriptor->descriptor;
+    }
+    auto characteristic = co_await CharacteristicAsync(serviceUuid, characteristicUuid);
+    if (!characteristic)
+    {
+        printf("GetDescriptor: get characteristic failed\n");
+        co_return std::nullopt;
+    }
+    co_return co_await awaitCallback<std::optional<GattDescriptor>>([&](auto callback) {
+        GetDescriptorFromCharacteristic(*characteristic, serviceUuid, characteristicUuid,
+                                        descriptorUuid, callback);
+    });
 }
 
 void PeripheralWinrt::GetDescriptor(winrt::guid serviceUuid, winrt::guid characteristicUuid,
                                     winrt::guid descriptorUuid,
-                                    std::function<void(std::optional<GattDescriptor>)> callback)
+                                    LookupCallback<GattDescriptor> callback)
 {
-    auto it = cachedServices.find(serviceUuid);
-    if (it != cachedServices.end())
+    ExpireLookups();
+    auto descriptor = attributes.Find({ serviceUuid, characteristicUuid, descriptorUuid });
+    if (descriptor)
     {
-        auto& cachedService = it->second;
-        auto cit = cachedService.characterisitics.find(characteristicUuid);
-        if (cit != cachedService.characterisitics.end())
-        {
-            GetDescriptorFromCharacteristic(cit->second.characteristic, descriptorUuid, callback);
-        }
-        else
+        callback(descriptor->descriptor);
+        return;
+    }
+    startTask(DescriptorAsync(serviceUuid, characteristicUuid, descriptorUuid),
+              std::move(callback));
+}
+
+void PeripheralWinrt::GetAttribute(uint16_t handle, LookupCallback<Attribute> callback)
+{
+    ExpireLookups();
+    auto attribute = attributes.Find(handle);
+    if (attribute)
+    {
+        callback(attribute);
+    }
+    else if (device.has_value())
+    {
+        // the handle belongs to an attribute that wasn't looked up yet, concurrent misses wait for
+        // the same load
+        auto loaded = [this, handle, callback = std::move(callback)](std::optional<bool> success) {
+            callback(success ? attributes.Find(handle) : std::nullopt);
+        };
+        if (!pendingLoad.Add(ALL_ATTRIBUTES, std::move(loaded)))
         {
-            GetCharacteristicFromService(
-                cachedService.service, characteristicUuid,
-                [=](std::optional<GattCharacteristic> characteristic) {
-                    if (characteristic)
-                    {
-                        GetDescriptorFromCharacteristic(*characteristic, descriptorUuid, callback);
-                    }
-                    else
-                    {
-                        printf("GetDescriptor: get characteristic failed 1\n");
-                        callback(nullptr);
-                    }
-                });
+            return;
         }
+        auto completed = [this](auto&&, AsyncStatus status) {
+            if (status == AsyncStatus::Completed)
+            {
+                pendingLoad.Complete(ALL_ATTRIBUTES, true);
+            }
+            else
+            {
+                printf("GetAttribute: loading attributes failed with status: %d\n", status);
+                pendingLoad.Complete(ALL_ATTRIBUTES, std::nullopt);
+            }
+        };
+        LoadAttributesAsync(*device).Completed(completed);
     }
     else
     {
-        GetServiceFromDevice(serviceUuid, [=](std::optional<GattDeviceService> service) {
-            if (service)
+        printf("GetAttribute: no device currently connected\n");
+        callback(std::nullopt);
+    }
+}
+
+IAsyncAction PeripheralWinrt::LoadAttributesAsync(BluetoothLEDevice device)
+{
+    auto mode = LookupCacheMode();
+    auto servicesResult = co_await device.GetGattServicesAsync(mode);
+    if (!servicesResult || servicesResult.Status() != GattCommunicationStatus::Success)
+    {
+        co_return;
+    }
+    for (auto&& service : servicesResult.Services())
+    {
+        auto serviceUuid = service.Uuid();
+        attributes.Add(serviceUuid, service);
+        auto characteristicsResult = co_await service.GetCharacteristicsAsync(mode);
+        if (!characteristicsResult ||
+            characteristicsResult.Status() != GattCommunicationStatus::Success)
+        {
+            continue;
+        }
+        for (auto&& characteristic : characteristicsResult.Characteristics())
+        {
+            auto characteristicUuid = characteristic.Uuid();
+            attributes.Add(serviceUuid, characteristicUuid, characteristic);
+            auto descriptorsResult = co_await characteristic.GetDescriptorsAsync(mode);
+            if (!descriptorsResult ||
+                descriptorsResult.Status() != GattCommunicationStatus::Success)
             {
-                GetCharacteristicFromService(
-                    *service, characteristicUuid,
-                    [=](std::optional<GattCharacteristic> characteristic) {
-                        if (characteristic)
-                        {
-                            GetDescriptorFromCharacteristic(*characteristic, descriptorUuid,
-                                                            callback);
-                        }
-                        else
-                        {
-                            printf("GetDescriptor: get characteristic failed 2\n");
-                            callback(nullptr);
-                        }
-                    });
+                continue;
             }
-            else
+            for (auto&& descriptor : descriptorsResult.Descriptors())
             {
-                printf("GetDescriptor: get service failed\n");
-                callback(nullptr);
+                attributes.Add(serviceUuid, characteristicUuid, descriptor.Uuid(), descriptor);
             }
-        });
+        }
     }
 }
@@ -6,42 +6,28 @@
 #include <winrt/Windows.Devices.Bluetooth.Advertisement.h>
 
 using namespace winrt::Windows::Devices::Bluetooth::Advertisement;
+using winrt::Windows::Devices::Bluetooth::BluetoothCacheMode;
 using winrt::Windows::Devices::Bluetooth::BluetoothLEDevice;
 using winrt::Windows::Devices::Bluetooth::GenericAttributeProfile::GattCharacteristic;
 using winrt::Windows::Devices::Bluetooth::GenericAttributeProfile::GattDescriptor;
 using winrt::Windows::Devices::Bluetooth::GenericAttributeProfile::GattDeviceService;
+using winrt::Windows::Devices::Bluetooth::GenericAttributeProfile::GattSession;
 
 #include "winrt/Windows.Devices.Bluetooth.h"
 
 #include <string>
 #include <optional>
 
+#include "attribute_table.h"
+#include "cache_policy.h"
+#include "connection_mode.h"
+#include "gatt_cache.h"
+#include "link_health.h"
 #include "peripheral.h"
+#include "pending_lookups.h"
+#include "task.h"
 #include "winrt_guid.h"
-
-class CachedCharacteristic
-{
-public:
-    CachedCharacteristic() = default;
-    CachedCharacteristic(GattCharacteristic& c) : characteristic(c)
-    {
-    }
-
-    GattCharacteristic characteristic = nullptr;
-    std::unordered_map<winrt::guid, GattDescriptor> descriptors;
-};
-
-class CachedService
-{
-public:
-    CachedService() = default;
-    CachedService(GattDeviceService& s) : service(s)
-    {
-    }
-
-    GattDeviceService service = nullptr;
-    std::unordered_map<winrt::guid, CachedCharacteristic> characterisitics;
-};
+#include "write_segmentation.h"
 
 class PeripheralWinrt : public Peripheral
 {
@@ -49,6 +35,9 @@ public:
     PeripheralWinrt() = default;
     PeripheralWinrt(uint64_t bluetoothAddress, BluetoothLEAdvertisementType advertismentType,
                     int rssiValue, const BluetoothLEAdvertisement& advertisment);
+    // a device that is connected by its address without having been scanned
+    explicit PeripheralWinrt(uint64_t bluetoothAddress);
+    PeripheralWinrt(PeripheralWinrt&&) = default;
     ~PeripheralWinrt();
 
     void Update(int rssiValue, const BluetoothLEAdvertisement& advertisment,
@@ -56,27 +45,66 @@ public:
 
     void Disconnect();
 
-    void GetService(winrt::guid serviceUuid,
-                    std::function<void(std::optional<GattDeviceService>)> callback);
+    void CacheService(GattDeviceService service);
+    void CacheCharacteristic(winrt::guid serviceUuid, GattCharacteristic characteristic);
+    void CacheDescriptor(winrt::guid serviceUuid, winrt::guid characteristicUuid,
+                         GattDescriptor descriptor);
+
+    void GetService(winrt::guid serviceUuid, LookupCallback<GattDeviceService> callback);
     void GetCharacteristic(winrt::guid serviceUuid, winrt::guid characteristicUuid,
-                           std::function<void(std::optional<GattCharacteristic>)> callback);
+                           LookupCallback<GattCharacteristic> callback);
     void GetDescriptor(winrt::guid serviceUuid, winrt::guid characteristicUuid,
-                       winrt::guid descriptorUuid,
-                       std::function<void(std::optional<GattDescriptor>)> callback);
+                       winrt::guid descriptorUuid, LookupCallback<GattDescriptor> callback);
+    void GetAttribute(uint16_t handle, LookupCallback<Attribute> callback);
+
+    // the lookups as coroutines, the callback versions above run them
+    Task<std::optional<GattDeviceService>> ServiceAsync(winrt::guid serviceUuid);
+    Task<std::optional<GattCharacteristic>> CharacteristicAsync(winrt::guid serviceUuid,
+                                                                winrt::guid characteristicUuid);
+    Task<std::optional<GattDescriptor>>
+    DescriptorAsync(winrt::guid serviceUuid, winrt::guid characteristicUuid,
+                    winrt::guid descriptorUuid);
+
+    void SetLookupPolicy(const CachePolicy& policy);
+    // the cache mode for discovering the children of `parent`, {} for the services of the device
+    BluetoothCacheMode DiscoveryCacheMode(const AttributeKey& parent, const CachePolicy& policy);
+    // an uncached discovery of the children of `parent` that started at `startedAt` succeeded
+    void Discovered(const AttributeKey& parent, std::chrono::steady_clock::time_point startedAt);
+    std::optional<Payload> GetCachedValue(const AttributeKey& key, const CachePolicy& policy);
+    void CacheValue(const AttributeKey& key, const Payload& data);
 
     int rssi;
     uint64_t bluetoothAddress;
     std::optional<BluetoothLEDevice> device;
     winrt::event_token connectionToken;
+    std::optional<GattSession> session;
+    winrt::event_token mtuToken;
+    uint16_t mtu = DEFAULT_ATT_MTU;
+    // requested again whenever the device connects
+    std::optional<ConnectionPreset> connectionPreset;
+    // the accepted preset request, closing it withdraws the preset
+    winrt::Windows::Foundation::IClosable parametersRequest = nullptr;
+    // the link is watched whenever the device is connected
+    std::optional<HealthOptions> health;
+    std::optional<AttributeKey> healthProbe;
 
 private:
-    void GetServiceFromDevice(winrt::guid serviceUuid,
-                              std::function<void(std::optional<GattDeviceService>)> callback);
-    void
-    GetCharacteristicFromService(GattDeviceService service, winrt::guid characteristicUuid,
-                                 std::function<void(std::optional<GattCharacteristic>)> callback);
-    void
-    GetDescriptorFromCharacteristic(GattCharacteristic characteristic, winrt::guid descriptorUuid,
-                                    std::function<void(std::optional<GattDescriptor>)> callback);
-    std::unordered_map<winrt::guid, CachedService> cachedServices;
+    BluetoothCacheMode LookupCacheMode();
+    void ExpireLookups();
+    winrt::Windows::Foundation::IAsyncAction LoadAttributesAsync(BluetoothLEDevice device);
+    void GetServiceFromDevice(winrt::guid serviceUuid, LookupCallback<GattDeviceService> callback);
+    void GetCharacteristicFromService(GattDeviceService service, winrt::guid serviceUuid,
+                                      winrt::guid characteristicUuid,
+                                      LookupCallback<GattCharacteristic> callback);
+    void GetDescriptorFromCharacteristic(
+        GattCharacteristic characteristic, winrt::guid serviceUuid, winrt::guid characteristicUuid,
+        winrt::guid descriptorUuid, LookupCallback<GattDescriptor> callback);
+    AttributeTable attributes;
+    PendingLookups<AttributeKey, GattDeviceService, AttributeKeyHash> pendingServices;
+    PendingLookups<AttributeKey, GattCharacteristic, AttributeKeyHash> pendingCharacteristics;
+    PendingLookups<AttributeKey, GattDescriptor, AttributeKeyHash> pendingDescriptors;
+    // handle lookups that wait for all attributes to be loaded, there is a single load at a time
+    static const int ALL_ATTRIBUTES = 0;
+    PendingLookups<int, bool> pendingLoad;
+    GattCache<AttributeKey, AttributeKeyHash> cache;
 };
@@ -8,16 +8,12 @@
 #pragma once
 
 #include "radio_watcher.h"
+#include "callable.h"
 #include "winrt_cpp.h"
 
 using winrt::Windows::Devices::Radios::RadioKind;
 using winrt::Windows::Foundation::AsyncStatus;
 
-template <typename O, typename M, class... Types> auto bind2(O* object, M method, Types&... args)
-{
-    return std::bind(method, object, std::placeholders::_1, std::placeholders::_2, args...);
-}
-
 #define RADIO_INTERFACE_CLASS_GUID \
     L"System.Devices.InterfaceClassGuid:=\"{A8804298-2D5F-42E3-9531-9C8C39EB29CE}\""
 
@@ -31,9 +27,9 @@ RadioWatcher::RadioWatcher()
     mCompletedRevoker = watcher.EnumerationCompleted(winrt::auto_revoke, completed);
 }
 
-void RadioWatcher::Start(std::function<void(Radio& radio)> on)
+void RadioWatcher::Start(Callable<void(Radio& radio)> on)
 {
-    radioStateChanged = on;
+    radioStateChanged = std::move(on);
     inEnumeration = true;
     initialDone = false;
     initialCount = 0;
@@ -7,11 +7,12 @@
 
 #pragma once
 
-#include <functional>
 #include <set>
 #include <winrt/Windows.Devices.Enumeration.h>
 #include <winrt/Windows.Devices.Radios.h>
 
+#include "callable.h"
+
 using namespace winrt::Windows::Devices::Enumeration;
 
 using winrt::Windows::Devices::Radios::IRadio;
@@ -35,7 +36,7 @@ class RadioWatcher
 public:
     RadioWatcher();
 
-    void Start(std::function<void(Radio& radio)> on);
+    void Start(Callable<void(Radio& radio)> on);
 
 private:
     IAsyncOperation<Radio> GetRadios(std::set<winrt::hstring> ids);
@@ -57,5 +58,5 @@ private:
     std::set<winrt::hstring> radioIds;
     Radio mRadio;
     winrt::event_revoker<IRadio> mRadioStateChangedRevoker;
-    std::function<void(Radio& radio)> radioStateChanged;
+    Callable<void(Radio& radio)> radioStateChanged;
 };
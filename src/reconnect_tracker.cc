@@ -0,0 +1,104 @@
+#include "reconnect_tracker.h"
+
+#include <algorithm>
+
+ReconnectTracker::ReconnectTracker() : mRandom(std::random_device()())
+{
+}
+
+void ReconnectTracker::SetPolicy(const ReconnectPolicy& policy)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPolicy = policy;
+}
+
+ReconnectPolicy ReconnectTracker::GetPolicy() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPolicy;
+}
+
+std::optional<std::chrono::milliseconds> ReconnectTracker::Dropped(const std::string& device,
+                                                                   Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mPolicy.enabled || !mDevices.emplace(device, State{ now }).second)
+    {
+        return std::nullopt;
+    }
+    mStats.drops++;
+    return Delay(1);
+}
+
+bool ReconnectTracker::IsReconnecting(const std::string& device) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mDevices.find(device) != mDevices.end();
+}
+
+bool ReconnectTracker::Attempt(const std::string& device)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mDevices.find(device);
+    if (it == mDevices.end())
+    {
+        return false;
+    }
+    it->second.attempt++;
+    mStats.attempts++;
+    return true;
+}
+
+ReconnectStep ReconnectTracker::Failed(const std::string& device, std::chrono::milliseconds& delay)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mDevices.find(device);
+    if (it == mDevices.end())
+    {
+        return ReconnectStep::Stopped;
+    }
+    if (it->second.attempt >= mPolicy.backoff.maxAttempts)
+    {
+        mDevices.erase(it);
+        mStats.exhausted++;
+        return ReconnectStep::GiveUp;
+    }
+    delay = Delay(it->second.attempt + 1);
+    return ReconnectStep::Retry;
+}
+
+std::optional<std::chrono::microseconds> ReconnectTracker::Restored(const std::string& device,
+                                                                    Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mDevices.find(device);
+    if (it == mDevices.end())
+    {
+        return std::nullopt;
+    }
+    auto latency =
+        std::chrono::duration_cast<std::chrono::microseconds>(now - it->second.droppedAt);
+    mDevices.erase(it);
+    mStats.restored++;
+    mStats.totalLatency += latency;
+    mStats.maxLatency = std::max(mStats.maxLatency, latency);
+    return latency;
+}
+
+bool ReconnectTracker::Cancel(const std::string& device)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mDevices.erase(device) > 0;
+}
+
+ReconnectStats ReconnectTracker::Stats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
+
+std::chrono::milliseconds ReconnectTracker::Delay(int attempt)
+{
+    double random = std::uniform_real_distribution<double>(0, 1)(mRandom);
+    return mPolicy.backoff.Delay(attempt, random);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "retry_policy.h"
+
+// Reconnects devices that lost their connection instead of dropping their subscriptions and
+// GATT cache, off unless enabled. Attempts are spaced like retries, the retryable statuses of
+// the backoff aren't used.
+struct ReconnectPolicy
+{
+    bool enabled = false;
+    RetryPolicy backoff = { 10, std::chrono::milliseconds(500), std::chrono::milliseconds(30000),
+                            2, 0.2 };
+};
+
+struct ReconnectStats
+{
+    uint64_t drops = 0;
+    uint64_t attempts = 0;
+    uint64_t restored = 0;
+    // devices that were given up after their last attempt
+    uint64_t exhausted = 0;
+    // from losing the connection until notifications are enabled again
+    std::chrono::microseconds totalLatency = std::chrono::microseconds(0);
+    std::chrono::microseconds maxLatency = std::chrono::microseconds(0);
+};
+
+enum class ReconnectStep
+{
+    // try again after the delay
+    Retry,
+    // the last attempt failed, the device has to be torn down
+    GiveUp,
+    // the device isn't reconnecting anymore, e.g. because it has been disconnected meanwhile
+    Stopped,
+};
+
+// The devices that are being reconnected and how far along they are.
+class ReconnectTracker
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    ReconnectTracker();
+
+    void SetPolicy(const ReconnectPolicy& policy);
+    ReconnectPolicy GetPolicy() const;
+
+    // Starts reconnecting the device and returns the delay before the first attempt, nothing if
+    // reconnecting is disabled or the device is already reconnecting.
+    std::optional<std::chrono::milliseconds> Dropped(const std::string& device,
+                                                     Clock::time_point now);
+    bool IsReconnecting(const std::string& device) const;
+    // Counts an attempt, returns false if the device isn't reconnecting anymore.
+    bool Attempt(const std::string& device);
+    // After a failed attempt, sets `delay` if the step is Retry.
+    ReconnectStep Failed(const std::string& device, std::chrono::milliseconds& delay);
+    // Returns the time since the connection was lost, nothing if the device isn't reconnecting.
+    std::optional<std::chrono::microseconds> Restored(const std::string& device,
+                                                      Clock::time_point now);
+    // Stops reconnecting the device, returns false if it wasn't.
+    bool Cancel(const std::string& device);
+    ReconnectStats Stats() const;
+
+private:
+    struct State
+    {
+        Clock::time_point droppedAt;
+        int attempt = 0;
+    };
+
+    std::chrono::milliseconds Delay(int attempt);
+
+    mutable std::mutex mMutex;
+    ReconnectPolicy mPolicy;
+    std::unordered_map<std::string, State> mDevices;
+    ReconnectStats mStats;
+    std::minstd_rand mRandom;
+};
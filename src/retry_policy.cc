@@ -0,0 +1,75 @@
+#include "retry_policy.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool RetryPolicy::IsRetryable(OperationStatus status) const
+{
+    return std::find(retryable.begin(), retryable.end(), status) != retryable.end();
+}
+
+std::chrono::milliseconds RetryPolicy::Delay(int attempt, double random) const
+{
+    double delay = initialDelay.count() * std::pow(multiplier, std::max(attempt - 1, 0));
+    delay = std::min(delay, static_cast<double>(maxDelay.count()));
+    delay *= 1 - std::clamp(jitter, 0.0, 1.0) * random;
+    return std::chrono::milliseconds(static_cast<int64_t>(delay));
+}
+
+RetryPolicies::RetryPolicies() : mRandom(std::random_device()())
+{
+    // a write that failed on the way back could have been applied already, only retry writes
+    // that never reached the device
+    mPolicies[static_cast<int>(OperationClass::Write)].retryable = {
+        OperationStatus::Unreachable
+    };
+}
+
+void RetryPolicies::Set(OperationClass operationClass, const RetryPolicy& policy)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mPolicies[static_cast<int>(operationClass)] = policy;
+}
+
+RetryPolicy RetryPolicies::Get(OperationClass operationClass) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPolicies[static_cast<int>(operationClass)];
+}
+
+std::optional<std::chrono::milliseconds>
+RetryPolicies::Next(OperationClass operationClass, int attempt, OperationStatus status)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto& policy = mPolicies[static_cast<int>(operationClass)];
+    auto& stats = mStats[static_cast<int>(operationClass)];
+    if (status == OperationStatus::Success)
+    {
+        stats.operations++;
+        if (attempt > 1)
+        {
+            stats.recovered++;
+        }
+        return std::nullopt;
+    }
+    if (!policy.IsRetryable(status))
+    {
+        stats.operations++;
+        return std::nullopt;
+    }
+    if (attempt >= policy.maxAttempts)
+    {
+        stats.operations++;
+        stats.exhausted++;
+        return std::nullopt;
+    }
+    stats.retries++;
+    double random = std::uniform_real_distribution<double>(0, 1)(mRandom);
+    return policy.Delay(attempt, random);
+}
+
+std::array<RetryStats, OPERATION_CLASSES> RetryPolicies::Stats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "operation_error.h"
+
+enum class OperationClass : int
+{
+    Discovery = 0,
+    Read = 1,
+    Write = 2,
+    Notify = 3,
+};
+
+const size_t OPERATION_CLASSES = 4;
+
+// Retries with exponential backoff: attempt n waits initialDelay * multiplier^(n - 1), at most
+// maxDelay, reduced by a random share of up to `jitter` so that retries of several devices
+// don't line up.
+struct RetryPolicy
+{
+    int maxAttempts = 3;
+    std::chrono::milliseconds initialDelay = std::chrono::milliseconds(50);
+    std::chrono::milliseconds maxDelay = std::chrono::milliseconds(1000);
+    double multiplier = 2;
+    double jitter = 0.5;
+    std::vector<OperationStatus> retryable = { OperationStatus::Unreachable,
+                                               OperationStatus::ProtocolError };
+
+    bool IsRetryable(OperationStatus status) const;
+    // `random` is in [0, 1)
+    std::chrono::milliseconds Delay(int attempt, double random) const;
+};
+
+struct RetryStats
+{
+    // operations that completed, successfully or not
+    uint64_t operations = 0;
+    uint64_t retries = 0;
+    // operations that succeeded after at least one retry
+    uint64_t recovered = 0;
+    // operations that failed with a retryable status after the last attempt
+    uint64_t exhausted = 0;
+};
+
+class RetryPolicies
+{
+public:
+    RetryPolicies();
+
+    void Set(OperationClass operationClass, const RetryPolicy& policy);
+    RetryPolicy Get(OperationClass operationClass) const;
+
+    // Returns the delay before the next attempt, nothing if the result of `attempt` is final.
+    std::optional<std::chrono::milliseconds> Next(OperationClass operationClass, int attempt,
+                                                  OperationStatus status);
+    std::array<RetryStats, OPERATION_CLASSES> Stats() const;
+
+private:
+    mutable std::mutex mMutex;
+    std::array<RetryPolicy, OPERATION_CLASSES> mPolicies;
+    std::array<RetryStats, OPERATION_CLASSES> mStats;
+    std::minstd_rand mRandom;
+};
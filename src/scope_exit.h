@@ -0,0 +1,33 @@
+#pragma once
+
+#include <utility>
+
+// Runs a function when the scope is left, also when it is left by an exception, unless it has
+// been dismissed before.
+template <typename F> class ScopeExit
+{
+public:
+    explicit ScopeExit(F f) : mF(std::move(f))
+    {
+    }
+
+    ~ScopeExit()
+    {
+        if (mActive)
+        {
+            mF();
+        }
+    }
+
+    ScopeExit(const ScopeExit&) = delete;
+    ScopeExit& operator=(const ScopeExit&) = delete;
+
+    void Dismiss()
+    {
+        mActive = false;
+    }
+
+private:
+    F mF;
+    bool mActive = true;
+};
@@ -0,0 +1,138 @@
+#include "stream_writer.h"
+
+#include <algorithm>
+
+#include "scope_exit.h"
+
+std::shared_ptr<StreamWriter> StreamWriter::Create(Payload data, size_t chunkSize, size_t window,
+                                                   WriteChunk write, OnProgress onProgress,
+                                                   OnDone onDone)
+{
+    return std::shared_ptr<StreamWriter>(
+        new StreamWriter(std::move(data), chunkSize, window, write, onProgress, onDone));
+}
+
+StreamWriter::StreamWriter(Payload data, size_t chunkSize, size_t window, WriteChunk write,
+                           OnProgress onProgress, OnDone onDone)
+    : mData(std::move(data)), mChunkSize(std::max<size_t>(chunkSize, 1)),
+      mWindow(std::max<size_t>(window, 1)), mWrite(write), mOnProgress(onProgress),
+      mOnDone(onDone)
+{
+}
+
+void StreamWriter::Start()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStart = std::chrono::steady_clock::now();
+        // report progress about every 5%
+        mNextReport = std::max(mData.size / 20, mChunkSize);
+    }
+    if (mData.empty())
+    {
+        mOnDone(true, Progress());
+        return;
+    }
+    Pump();
+}
+
+void StreamWriter::Cancel()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFailed = true;
+}
+
+void StreamWriter::Pump()
+{
+    auto self = shared_from_this();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mPumping)
+        {
+            // a chunk completed synchronously, the running pump uses the returned credit
+            return;
+        }
+        mPumping = true;
+    }
+    ScopeExit stopPumping([this]() {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPumping = false;
+    });
+    while (true)
+    {
+        const uint8_t* chunk;
+        size_t size;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            if (mFailed || mInFlight >= mWindow || mOffset >= mData.size)
+            {
+                mPumping = false;
+                stopPumping.Dismiss();
+                return;
+            }
+            chunk = mData.data + mOffset;
+            size = std::min(mChunkSize, mData.size - mOffset);
+            mOffset += size;
+            mInFlight++;
+        }
+        try
+        {
+            mWrite(chunk, size,
+                   [self, size](bool success) { self->OnChunkWritten(size, success); });
+        }
+        catch (...)
+        {
+            // the chunk was never written, this fails the stream once the others have completed
+            OnChunkWritten(size, false);
+        }
+    }
+}
+
+void StreamWriter::OnChunkWritten(size_t size, bool success)
+{
+    bool finished = false;
+    bool report = false;
+    bool failed;
+    StreamProgress progress;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mInFlight--;
+        if (success)
+        {
+            mSent += size;
+        }
+        else
+        {
+            mFailed = true;
+        }
+        failed = mFailed;
+        finished = mInFlight == 0 && (mFailed || mOffset >= mData.size);
+        if (!finished && mSent >= mNextReport)
+        {
+            report = true;
+            mNextReport += std::max(mData.size / 20, mChunkSize);
+        }
+    }
+    progress = Progress();
+    if (finished)
+    {
+        mOnDone(!failed, progress);
+        return;
+    }
+    if (report)
+    {
+        mOnProgress(progress);
+    }
+    Pump();
+}
+
+StreamProgress StreamWriter::Progress() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    StreamProgress progress;
+    progress.sent = mSent;
+    progress.total = mData.size;
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - mStart;
+    progress.bytesPerSecond = elapsed.count() > 0 ? mSent / elapsed.count() : 0;
+    return progress;
+}
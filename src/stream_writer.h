@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "payload.h"
+
+struct StreamProgress
+{
+    size_t sent = 0;
+    size_t total = 0;
+    double bytesPerSecond = 0;
+};
+
+// Pushes a large payload through write without response in chunks. Each chunk takes a credit
+// that is returned when its write has completed, at most `window` chunks are in flight. A chunk
+// whose write throws counts as failed.
+class StreamWriter : public std::enable_shared_from_this<StreamWriter>
+{
+public:
+    using ChunkDone = std::function<void(bool success)>;
+    using WriteChunk = std::function<void(const uint8_t* data, size_t size, ChunkDone done)>;
+    using OnProgress = std::function<void(const StreamProgress& progress)>;
+    using OnDone = std::function<void(bool success, const StreamProgress& progress)>;
+
+    static std::shared_ptr<StreamWriter> Create(Payload data, size_t chunkSize, size_t window,
+                                                WriteChunk write, OnProgress onProgress,
+                                                OnDone onDone);
+
+    void Start();
+    // stops writing chunks, finishes unsuccessfully once the chunks in flight have completed
+    void Cancel();
+
+private:
+    StreamWriter(Payload data, size_t chunkSize, size_t window, WriteChunk write,
+                 OnProgress onProgress, OnDone onDone);
+
+    void Pump();
+    void OnChunkWritten(size_t size, bool success);
+    StreamProgress Progress() const;
+
+    mutable std::mutex mMutex;
+    Payload mData;
+    size_t mChunkSize;
+    size_t mWindow;
+    WriteChunk mWrite;
+    OnProgress mOnProgress;
+    OnDone mOnDone;
+
+    size_t mOffset = 0;
+    size_t mSent = 0;
+    size_t mInFlight = 0;
+    size_t mNextReport = 0;
+    bool mFailed = false;
+    bool mPumping = false;
+    std::chrono::steady_clock::time_point mStart;
+};
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Subscriptions grouped by device. A device only has a handful of subscriptions, they are kept in
+// a vector sorted by key so a lookup is one hash of the device and a binary search, and dropping
+// a device is a single erase instead of a scan over every subscription.
+template <typename Key, typename Record, typename Less = std::less<Key>,
+          typename Device = std::string>
+class SubscriptionIndex
+{
+public:
+    using Entry = std::pair<Key, Record>;
+
+    // Returns false and leaves the existing record alone if the key is already subscribed.
+    bool Add(const Device& device, const Key& key, Record record)
+    {
+        auto& entries = mDevices[device];
+        auto it = LowerBound(entries, key);
+        if (it != entries.end() && !mLess(key, it->first))
+        {
+            return false;
+        }
+        entries.emplace(it, key, std::move(record));
+        mSize++;
+        return true;
+    }
+
+    Record* Find(const Device& device, const Key& key)
+    {
+        auto entries = mDevices.find(device);
+        if (entries == mDevices.end())
+        {
+            return nullptr;
+        }
+        auto it = LowerBound(entries->second, key);
+        if (it == entries->second.end() || mLess(key, it->first))
+        {
+            return nullptr;
+        }
+        return &it->second;
+    }
+
+    std::optional<Record> Remove(const Device& device, const Key& key)
+    {
+        auto entries = mDevices.find(device);
+        if (entries == mDevices.end())
+        {
+            return std::nullopt;
+        }
+        auto it = LowerBound(entries->second, key);
+        if (it == entries->second.end() || mLess(key, it->first))
+        {
+            return std::nullopt;
+        }
+        std::optional<Record> record(std::move(it->second));
+        entries->second.erase(it);
+        if (entries->second.empty())
+        {
+            mDevices.erase(entries);
+        }
+        mSize--;
+        return record;
+    }
+
+    // Removes all subscriptions of the device and returns them.
+    std::vector<Entry> Remove(const Device& device)
+    {
+        auto entries = mDevices.find(device);
+        if (entries == mDevices.end())
+        {
+            return {};
+        }
+        std::vector<Entry> removed = std::move(entries->second);
+        mDevices.erase(entries);
+        mSize -= removed.size();
+        return removed;
+    }
+
+    template <typename F> void ForEach(F function)
+    {
+        for (auto& device : mDevices)
+        {
+            for (auto& entry : device.second)
+            {
+                function(device.first, entry.first, entry.second);
+            }
+        }
+    }
+
+    template <typename F> void ForEach(const Device& device, F function)
+    {
+        auto entries = mDevices.find(device);
+        if (entries == mDevices.end())
+        {
+            return;
+        }
+        for (auto& entry : entries->second)
+        {
+            function(entry.first, entry.second);
+        }
+    }
+
+    size_t Size() const
+    {
+        return mSize;
+    }
+
+private:
+    typename std::vector<Entry>::iterator LowerBound(std::vector<Entry>& entries, const Key& key)
+    {
+        return std::lower_bound(entries.begin(), entries.end(), key,
+                                [this](const Entry& entry, const Key& k) {
+                                    return mLess(entry.first, k);
+                                });
+    }
+
+    std::unordered_map<Device, std::vector<Entry>> mDevices;
+    size_t mSize = 0;
+    Less mLess;
+};
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <exception>
+#include <optional>
+#include <utility>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+namespace coro = std;
+#else
+// msvc with /await
+#include <experimental/coroutine>
+namespace coro = std::experimental;
+#endif
+
+// A lazily started coroutine that produces a T. It starts when it is awaited and resumes the
+// awaiting coroutine inline on the thread that completes it, nothing is scheduled.
+template <typename T> class Task
+{
+public:
+    struct promise_type;
+    using Handle = coro::coroutine_handle<promise_type>;
+
+    struct FinalAwaiter
+    {
+        bool await_ready() noexcept
+        {
+            return false;
+        }
+
+        void await_suspend(Handle handle) noexcept
+        {
+            // the continuation may destroy this coroutine, nothing can touch it afterwards
+            auto continuation = handle.promise().continuation;
+            if (continuation)
+            {
+                continuation.resume();
+            }
+        }
+
+        void await_resume() noexcept
+        {
+        }
+    };
+
+    struct promise_type
+    {
+        std::optional<T> value;
+        std::exception_ptr exception;
+        coro::coroutine_handle<> continuation;
+
+        Task get_return_object()
+        {
+            return Task(Handle::from_promise(*this));
+        }
+
+        coro::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        FinalAwaiter final_suspend() noexcept
+        {
+            return {};
+        }
+
+        template <typename U> void return_value(U&& result)
+        {
+            value.emplace(std::forward<U>(result));
+        }
+
+        void unhandled_exception()
+        {
+            exception = std::current_exception();
+        }
+    };
+
+    Task(Task&& other) noexcept : mHandle(std::exchange(other.mHandle, nullptr))
+    {
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task()
+    {
+        if (mHandle)
+        {
+            mHandle.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept
+    {
+        return mHandle.done();
+    }
+
+    void await_suspend(coro::coroutine_handle<> continuation)
+    {
+        mHandle.promise().continuation = continuation;
+        mHandle.resume();
+    }
+
+    T await_resume()
+    {
+        auto& promise = mHandle.promise();
+        if (promise.exception)
+        {
+            std::rethrow_exception(promise.exception);
+        }
+        return std::move(*promise.value);
+    }
+
+private:
+    explicit Task(Handle handle) : mHandle(handle)
+    {
+    }
+
+    Handle mHandle;
+};
+
+// A coroutine that starts right away and destroys itself when it has finished.
+struct Detached
+{
+    struct promise_type
+    {
+        Detached get_return_object()
+        {
+            return {};
+        }
+
+        coro::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        coro::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void()
+        {
+        }
+
+        void unhandled_exception()
+        {
+            std::terminate();
+        }
+    };
+};
+
+// Runs the task and passes its result to the callback, for callers that aren't coroutines.
+template <typename T, typename F> Detached startTask(Task<T> task, F callback)
+{
+    callback(co_await task);
+}
+
+// Suspends until the callback that `start` has been given is called and resumes with its
+// argument on the calling thread. The callback may also be called before `start` returns.
+template <typename T, typename S> class CallbackAwaiter
+{
+public:
+    explicit CallbackAwaiter(S start) : mStart(std::move(start))
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    void await_suspend(coro::coroutine_handle<> handle)
+    {
+        mStart([this, handle](T value) {
+            mValue.emplace(std::move(value));
+            handle.resume();
+        });
+    }
+
+    T await_resume()
+    {
+        return std::move(*mValue);
+    }
+
+private:
+    S mStart;
+    std::optional<T> mValue;
+};
+
+template <typename T, typename S> CallbackAwaiter<T, S> awaitCallback(S start)
+{
+    return CallbackAwaiter<T, S>(std::move(start));
+}
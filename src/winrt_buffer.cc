@@ -0,0 +1,81 @@
+// classic COM interfaces have to be known before the winrt headers
+#include <unknwn.h>
+#include <robuffer.h>
+
+#include "winrt_buffer.h"
+
+using ::Windows::Storage::Streams::IBufferByteAccess;
+
+// A read-only IBuffer over the bytes of a payload, WinRT reads them through IBufferByteAccess.
+struct PayloadBuffer : winrt::implements<PayloadBuffer, IBuffer, IBufferByteAccess>
+{
+    PayloadBuffer(Payload payload, size_t offset, size_t length)
+        : mPayload(std::move(payload)), mOffset(offset), mLength(static_cast<uint32_t>(length))
+    {
+    }
+
+    uint32_t Capacity() const
+    {
+        return mLength;
+    }
+
+    uint32_t Length() const
+    {
+        return mLength;
+    }
+
+    void Length(uint32_t value)
+    {
+        if (value > mLength)
+        {
+            throw winrt::hresult_invalid_argument();
+        }
+        mLength = value;
+    }
+
+    HRESULT __stdcall Buffer(uint8_t** value) noexcept final
+    {
+        if (!value)
+        {
+            return E_POINTER;
+        }
+        *value = const_cast<uint8_t*>(mPayload.data + mOffset);
+        return S_OK;
+    }
+
+private:
+    Payload mPayload;
+    size_t mOffset;
+    uint32_t mLength;
+};
+
+winrt::array_view<const uint8_t> bufferBytes(const IBuffer& buffer)
+{
+    if (!buffer || buffer.Length() == 0)
+    {
+        return {};
+    }
+    uint8_t* bytes = nullptr;
+    winrt::check_hresult(buffer.as<IBufferByteAccess>()->Buffer(&bytes));
+    return { bytes, buffer.Length() };
+}
+
+Payload bufferPayload(const IBuffer& buffer)
+{
+    auto bytes = bufferBytes(buffer);
+    if (bytes.empty())
+    {
+        return {};
+    }
+    return { bytes.data(), bytes.size(), std::make_shared<const IBuffer>(buffer) };
+}
+
+IBuffer payloadBuffer(const Payload& payload, size_t offset, size_t length)
+{
+    return winrt::make<PayloadBuffer>(payload, offset, length);
+}
+
+IBuffer payloadBuffer(const Payload& payload)
+{
+    return payloadBuffer(payload, 0, payload.size);
+}
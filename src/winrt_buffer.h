@@ -0,0 +1,15 @@
+#pragma once
+
+#include <winrt/Windows.Storage.Streams.h>
+
+#include "payload.h"
+
+using winrt::Windows::Storage::Streams::IBuffer;
+
+// the bytes of the buffer, valid as long as the buffer is
+winrt::array_view<const uint8_t> bufferBytes(const IBuffer& buffer);
+// shares the bytes of the buffer, the payload keeps the buffer alive
+Payload bufferPayload(const IBuffer& buffer);
+// a buffer over `length` bytes of the payload starting at `offset`, nothing is copied
+IBuffer payloadBuffer(const Payload& payload, size_t offset, size_t length);
+IBuffer payloadBuffer(const Payload& payload);
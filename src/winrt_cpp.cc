@@ -34,6 +34,53 @@ std::string formatBluetoothUuid(unsigned long long BluetoothAddress)
     return ret.str();
 }
 
+std::optional<unsigned long long> parseBluetoothAddress(const std::string& address)
+{
+    bool colons = address.size() == 17;
+    if (!colons && address.size() != 12)
+    {
+        return std::nullopt;
+    }
+    unsigned long long result = 0;
+    for (size_t i = 0; i < address.size(); i++)
+    {
+        char c = address[i];
+        if (colons && i % 3 == 2)
+        {
+            if (c != ':')
+            {
+                return std::nullopt;
+            }
+            continue;
+        }
+        int value;
+        if (c >= '0' && c <= '9')
+        {
+            value = c - '0';
+        }
+        else if (c >= 'a' && c <= 'f')
+        {
+            value = c - 'a' + 10;
+        }
+        else if (c >= 'A' && c <= 'F')
+        {
+            value = c - 'A' + 10;
+        }
+        else
+        {
+            return std::nullopt;
+        }
+        result = (result << 4) | value;
+    }
+    return result;
+}
+
+std::string normalizeDeviceId(const std::string& id)
+{
+    auto address = parseBluetoothAddress(id);
+    return address ? formatBluetoothUuid(*address) : id;
+}
+
 std::string toStr(winrt::guid uuid)
 {
     try
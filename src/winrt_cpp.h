@@ -4,8 +4,14 @@
 
 using winrt::Windows::Devices::Bluetooth::GenericAttributeProfile::GattCharacteristicProperties;
 
+#include <optional>
+
 std::string ws2s(const wchar_t* wstr);
 std::string formatBluetoothAddress(unsigned long long BluetoothAddress);
 std::string formatBluetoothUuid(unsigned long long BluetoothAddress);
+// accepts 12 hex digits or 6 colon separated pairs, in either case
+std::optional<unsigned long long> parseBluetoothAddress(const std::string& address);
+// device ids that are addresses in any accepted format are turned into the uuid of the device
+std::string normalizeDeviceId(const std::string& id);
 std::string toStr(winrt::guid uuid);
 std::vector<std::string> toPropertyArray(GattCharacteristicProperties& properties);
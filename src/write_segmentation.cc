@@ -0,0 +1,31 @@
+#include "write_segmentation.h"
+
+#include <algorithm>
+
+// opcode and handle
+const size_t WRITE_HEADER = 3;
+// opcode, handle and offset
+const size_t PREPARE_WRITE_HEADER = 5;
+
+size_t maxWritePayload(uint16_t mtu)
+{
+    return std::max<size_t>(mtu, DEFAULT_ATT_MTU) - WRITE_HEADER;
+}
+
+size_t maxPreparePayload(uint16_t mtu)
+{
+    return std::max<size_t>(mtu, DEFAULT_ATT_MTU) - PREPARE_WRITE_HEADER;
+}
+
+WritePlan planWrite(size_t length, uint16_t mtu, bool withoutResponse, bool canPrepare)
+{
+    if (length <= maxWritePayload(mtu))
+    {
+        return { WriteMode::Single, length };
+    }
+    if (!withoutResponse && canPrepare)
+    {
+        return { WriteMode::Queued, maxPreparePayload(mtu) };
+    }
+    return { WriteMode::Segmented, maxWritePayload(mtu) };
+}
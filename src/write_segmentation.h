@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// ATT_MTU before the exchange MTU procedure
+const uint16_t DEFAULT_ATT_MTU = 23;
+
+enum class WriteMode
+{
+    // the value fits into a single write request or command
+    Single,
+    // the value is written as a sequence of independent writes of at most MTU - 3 bytes
+    Segmented,
+    // the value is written as one queued write (prepare write requests of at most MTU - 5 bytes
+    // followed by an execute write request)
+    Queued,
+};
+
+struct WritePlan
+{
+    WriteMode mode;
+    // the most bytes that one request carries, the value is split into segments of this size
+    size_t segmentSize;
+};
+
+// payload of a write request or write command
+size_t maxWritePayload(uint16_t mtu);
+// payload of a prepare write request
+size_t maxPreparePayload(uint16_t mtu);
+
+// Decides how a value of `length` bytes is written. Queued writes need a response and a
+// characteristic that accepts prepare write requests, which any characteristic that can be
+// written with response does.
+WritePlan planWrite(size_t length, uint16_t mtu, bool withoutResponse, bool canPrepare);
@@ -0,0 +1,144 @@
+// Compares SubscriptionIndex with the flat map NotifyMap used before, at 10k subscriptions
+// (1000 devices with 10 subscriptions each). Not a test, build it with
+// -DNOBLE_WINRT_BENCHMARKS=ON and run bench_subscription_index.
+#include "subscription_index.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using Clock = std::chrono::steady_clock;
+
+const int DEVICES = 1000;
+const int SUBSCRIPTIONS = 10;
+const int ROUNDS = 20;
+
+// stands in for the service and characteristic guids of a subscription
+struct Key
+{
+    uint64_t service;
+    uint64_t characteristic;
+
+    bool operator<(const Key& other) const
+    {
+        return service != other.service ? service < other.service
+                                        : characteristic < other.characteristic;
+    }
+};
+
+// the previous layout: one map keyed by device, service and characteristic
+struct FlatKey
+{
+    std::string device;
+    Key key;
+
+    bool operator==(const FlatKey& other) const
+    {
+        return device == other.device && key.service == other.key.service &&
+            key.characteristic == other.key.characteristic;
+    }
+};
+
+struct FlatKeyHash
+{
+    size_t operator()(const FlatKey& k) const
+    {
+        return std::hash<std::string>()(k.device) ^ std::hash<uint64_t>()(k.key.service) ^
+            std::hash<uint64_t>()(k.key.characteristic);
+    }
+};
+
+using Flat = std::unordered_map<FlatKey, int, FlatKeyHash>;
+
+static std::vector<std::string> devices()
+{
+    std::vector<std::string> ids;
+    for (int d = 0; d < DEVICES; d++)
+    {
+        // the length of a formatted bluetooth address
+        char id[18];
+        snprintf(id, sizeof(id), "aa:bb:cc:dd:%02x:%02x", d / 256, d % 256);
+        ids.push_back(id);
+    }
+    return ids;
+}
+
+static Key key(int s)
+{
+    return { 0x1800 + uint64_t(s / 3), 0x2a00 + uint64_t(s) };
+}
+
+template <typename F> static double measure(F function)
+{
+    auto start = Clock::now();
+    function();
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+int main()
+{
+    auto ids = devices();
+    double indexLookup = 0, flatLookup = 0, indexRemove = 0, flatRemove = 0;
+    long found = 0;
+    for (int round = 0; round < ROUNDS; round++)
+    {
+        SubscriptionIndex<Key, int> index;
+        Flat flat;
+        for (auto& id : ids)
+        {
+            for (int s = 0; s < SUBSCRIPTIONS; s++)
+            {
+                index.Add(id, key(s), s);
+                flat.emplace(FlatKey{ id, key(s) }, s);
+            }
+        }
+        indexLookup += measure([&]() {
+            for (auto& id : ids)
+            {
+                for (int s = 0; s < SUBSCRIPTIONS; s++)
+                {
+                    found += *index.Find(id, key(s));
+                }
+            }
+        });
+        flatLookup += measure([&]() {
+            for (auto& id : ids)
+            {
+                for (int s = 0; s < SUBSCRIPTIONS; s++)
+                {
+                    found += flat.find(FlatKey{ id, key(s) })->second;
+                }
+            }
+        });
+        indexRemove += measure([&]() {
+            for (auto& id : ids)
+            {
+                found += index.Remove(id).size();
+            }
+        });
+        flatRemove += measure([&]() {
+            // without a per-device index every subscription is visited for every device
+            for (auto& id : ids)
+            {
+                for (auto it = flat.begin(); it != flat.end();)
+                {
+                    it = it->first.device == id ? flat.erase(it) : std::next(it);
+                }
+            }
+        });
+    }
+    double lookups = double(ROUNDS) * DEVICES * SUBSCRIPTIONS;
+    printf("%d subscriptions (%d devices x %d), %d rounds\n", DEVICES * SUBSCRIPTIONS, DEVICES,
+           SUBSCRIPTIONS, ROUNDS);
+    printf("lookup:              index %6.1f ns, flat map %6.1f ns\n",
+           indexLookup * 1000 / lookups, flatLookup * 1000 / lookups);
+    printf("remove all devices:  index %6.2f ms, flat map %6.2f ms\n",
+           indexRemove / 1000 / ROUNDS, flatRemove / 1000 / ROUNDS);
+    // keeps the lookups from being optimized away
+    return found == 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal assertions for the native tests, a failed check is reported and counted but doesn't
+// stop the test so that one run shows every failure.
+inline int& checkFailures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                              \
+    do                                                                                \
+    {                                                                                 \
+        if (!(condition))                                                             \
+        {                                                                             \
+            std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            checkFailures()++;                                                        \
+        }                                                                             \
+    } while (false)
+
+// the exit code of a test
+inline int checkResult()
+{
+    if (checkFailures() > 0)
+    {
+        std::printf("%d checks failed\n", checkFailures());
+        return 1;
+    }
+    return 0;
+}
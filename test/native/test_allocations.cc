@@ -0,0 +1,108 @@
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+
+#include "callable.h"
+#include "gatt_cache.h"
+#include "pending_lookups.h"
+
+#include "check.h"
+
+// counts the heap allocations of the whole test
+static std::atomic<size_t> allocations{ 0 };
+
+void* operator new(size_t size)
+{
+    allocations++;
+    if (void* memory = std::malloc(size ? size : 1))
+    {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+// stands in for BLEManager, whose result handlers take the bound arguments as const references
+struct Manager
+{
+    size_t received = 0;
+
+    void OnRead(const std::optional<Payload>& value, int handle, const std::string& uuid,
+                const std::string& characteristic)
+    {
+        received += value->size + handle + uuid.size() + characteristic.size();
+    }
+};
+
+static void countsAllocations()
+{
+    auto before = allocations.load();
+    auto value = new int(1);
+    delete value;
+    CHECK(allocations - before == 1);
+}
+
+static void cachedLookupsDoNotAllocate()
+{
+    GattCache<std::string> cache;
+    auto start = GattCache<std::string>::Clock::now();
+    // the key and the owner of the bytes are allocated before counting
+    std::string key = "characteristic";
+    std::string uuid = "device";
+    cache.SetValue(key, Payload(std::vector<uint8_t>{ 1, 2, 3 }), start);
+    Manager manager;
+    CachePolicy policy = { CacheMode::Cached };
+
+    auto before = allocations.load();
+    for (int i = 0; i < 1000; i++)
+    {
+        auto value = cache.Value(key, policy, start);
+        auto handler = bind2(&manager, &Manager::OnRead, uuid, key);
+        LookupCallback<int> callback = [value, handler = std::move(handler)](auto handle) {
+            handler(value, *handle);
+        };
+        callback(i);
+    }
+    CHECK(allocations == before);
+    CHECK(manager.received > 0);
+}
+
+static void inlineCallablesDoNotAllocate()
+{
+    using Handler = Callable<void(std::optional<Payload>, int), LOOKUP_CALLBACK_CAPACITY>;
+    std::string uuid = "device";
+    Manager manager;
+    auto before = allocations.load();
+    for (int i = 0; i < 1000; i++)
+    {
+        Handler handler = bind2(&manager, &Manager::OnRead, uuid, uuid);
+        auto moved = std::move(handler);
+        moved(Payload(), i);
+    }
+    CHECK(allocations == before);
+
+    // a callable beyond the capacity is moved to the heap once
+    before = allocations.load();
+    std::array<char, 128> padding{};
+    Callable<char(), 64> big = [padding]() { return padding[0]; };
+    CHECK(allocations - before == 1);
+}
+
+int main()
+{
+    countsAllocations();
+    cachedLookupsDoNotAllocate();
+    inlineCallablesDoNotAllocate();
+    return checkResult();
+}
@@ -0,0 +1,166 @@
+#include "callable.h"
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+// counts the living copies of a captured value
+struct Tracked
+{
+    static int alive;
+    static int moves;
+
+    Tracked()
+    {
+        alive++;
+    }
+
+    Tracked(const Tracked&)
+    {
+        alive++;
+    }
+
+    Tracked(Tracked&&) noexcept
+    {
+        alive++;
+        moves++;
+    }
+
+    ~Tracked()
+    {
+        alive--;
+    }
+};
+
+int Tracked::alive = 0;
+int Tracked::moves = 0;
+
+static void callsTheFunction()
+{
+    Callable<int(int, int)> add = [](int a, int b) { return a + b; };
+    CHECK(add);
+    CHECK(add(2, 3) == 5);
+
+    std::string log;
+    Callable<void(const std::string&)> append = [&](const std::string& text) { log += text; };
+    append("a");
+    append("b");
+    CHECK(log == "ab");
+}
+
+static void emptyAndNull()
+{
+    Callable<void()> empty;
+    CHECK(!empty);
+    Callable<void()> null = nullptr;
+    CHECK(!null);
+    Callable<void()> function = []() {};
+    function = nullptr;
+    CHECK(!function);
+}
+
+static void acceptsMoveOnlyCallables()
+{
+    auto value = std::make_unique<int>(3);
+    Callable<int()> function = [value = std::move(value)]() { return *value; };
+    Callable<int()> moved = std::move(function);
+    CHECK(!function);
+    CHECK(moved() == 3);
+}
+
+static void keepsSmallCallablesInline()
+{
+    Tracked::alive = 0;
+    {
+        Callable<void(), 64> function = [tracked = Tracked()]() {};
+        CHECK(Tracked::alive == 1);
+        Tracked::moves = 0;
+        Callable<void(), 64> moved = std::move(function);
+        // moving an inline callable moves what it captured
+        CHECK(Tracked::moves == 1);
+        CHECK(Tracked::alive == 1);
+    }
+    CHECK(Tracked::alive == 0);
+}
+
+static void movesBigCallablesToTheHeap()
+{
+    Tracked::alive = 0;
+    {
+        std::array<char, 256> padding{};
+        padding[0] = 'x';
+        Callable<char(), 64> function = [tracked = Tracked(), padding]() { return padding[0]; };
+        CHECK(Tracked::alive == 1);
+        Tracked::moves = 0;
+        Callable<char(), 64> moved = std::move(function);
+        // only the pointer moves
+        CHECK(Tracked::moves == 0);
+        CHECK(moved() == 'x');
+    }
+    CHECK(Tracked::alive == 0);
+}
+
+static void assignmentDestroysThePreviousCallable()
+{
+    Tracked::alive = 0;
+    Callable<void()> function = [tracked = Tracked()]() {};
+    Callable<void()> other = [tracked = Tracked()]() {};
+    CHECK(Tracked::alive == 2);
+    function = std::move(other);
+    CHECK(Tracked::alive == 1);
+    function = std::move(function);
+    CHECK(function);
+    CHECK(Tracked::alive == 1);
+    function = nullptr;
+    CHECK(Tracked::alive == 0);
+}
+
+static void survivesContainerGrowth()
+{
+    std::vector<Callable<int()>> functions;
+    for (int i = 0; i < 100; i++)
+    {
+        functions.push_back([i]() { return i; });
+    }
+    int sum = 0;
+    for (auto& function : functions)
+    {
+        sum += function();
+    }
+    CHECK(sum == 4950);
+}
+
+struct Handler
+{
+    std::string received;
+
+    void OnEvent(const std::string& first, int second, const std::string& bound)
+    {
+        received = first + std::to_string(second) + bound;
+    }
+};
+
+static void bindsMemberFunctions()
+{
+    Handler handler;
+    std::string bound = "!";
+    Callable<void(std::string, int)> function = bind2(&handler, &Handler::OnEvent, bound);
+    function("a", 1);
+    CHECK(handler.received == "a1!");
+}
+
+int main()
+{
+    callsTheFunction();
+    emptyAndNull();
+    acceptsMoveOnlyCallables();
+    keepsSmallCallablesInline();
+    movesBigCallablesToTheHeap();
+    assignmentDestroysThePreviousCallable();
+    survivesContainerGrowth();
+    bindsMemberFunctions();
+    return checkResult();
+}
@@ -0,0 +1,147 @@
+#include "connect_queue.h"
+
+#include <stdexcept>
+#include <vector>
+
+#include "check.h"
+
+// records the started attempts and keeps them connecting until finished
+struct Adapter
+{
+    std::vector<std::string> started;
+    std::vector<ConnectQueue::Done> connecting;
+
+    ConnectQueue::Attempt Attempt(const std::string& device)
+    {
+        return [this, device](ConnectQueue::Done done) {
+            started.push_back(device);
+            connecting.push_back(done);
+        };
+    }
+
+    void FinishFirst(bool connected = true)
+    {
+        auto done = connecting.front();
+        connecting.erase(connecting.begin());
+        done(connected);
+    }
+};
+
+static void limitsConcurrentAttempts()
+{
+    ConnectQueue queue(2);
+    Adapter adapter;
+    for (auto device : { "a", "b", "c", "d" })
+    {
+        CHECK(queue.Enqueue(device, 0, adapter.Attempt(device)));
+    }
+    CHECK((adapter.started == std::vector<std::string>{ "a", "b" }));
+    auto stats = queue.Stats();
+    CHECK(stats.inFlight == 2 && stats.pending == 2 && stats.queued == 4);
+
+    adapter.FinishFirst(true);
+    adapter.FinishFirst(false);
+    CHECK((adapter.started == std::vector<std::string>{ "a", "b", "c", "d" }));
+    adapter.FinishFirst();
+    adapter.FinishFirst();
+    stats = queue.Stats();
+    CHECK(stats.connected == 3 && stats.failed == 1);
+    CHECK(stats.inFlight == 0 && stats.pending == 0);
+    CHECK(stats.maxConnectTime >= std::chrono::microseconds(0));
+}
+
+static void startsLowerPrioritiesFirst()
+{
+    ConnectQueue queue(1);
+    Adapter adapter;
+    queue.Enqueue("busy", 0, adapter.Attempt("busy"));
+    queue.Enqueue("late", 5, adapter.Attempt("late"));
+    queue.Enqueue("first", 1, adapter.Attempt("first"));
+    queue.Enqueue("second", 1, adapter.Attempt("second"));
+    while (!adapter.connecting.empty())
+    {
+        adapter.FinishFirst();
+    }
+    CHECK((adapter.started == std::vector<std::string>{ "busy", "first", "second", "late" }));
+}
+
+static void rejectsDevicesThatAreQueuedOrConnecting()
+{
+    ConnectQueue queue(1);
+    Adapter adapter;
+    CHECK(queue.Enqueue("a", 0, adapter.Attempt("a")));
+    CHECK(queue.Enqueue("b", 0, adapter.Attempt("b")));
+    // connecting
+    CHECK(!queue.Enqueue("a", 0, adapter.Attempt("a")));
+    // queued
+    CHECK(!queue.Enqueue("b", 0, adapter.Attempt("b")));
+    adapter.FinishFirst();
+    adapter.FinishFirst();
+    // a device can be connected again once its attempt has finished
+    CHECK(queue.Enqueue("a", 0, adapter.Attempt("a")));
+}
+
+static void cancelsAttemptsThatHaveNotStarted()
+{
+    ConnectQueue queue(1);
+    Adapter adapter;
+    queue.Enqueue("a", 0, adapter.Attempt("a"));
+    queue.Enqueue("b", 0, adapter.Attempt("b"));
+    CHECK(queue.Cancel("b"));
+    CHECK(!queue.Cancel("b"));
+    // already connecting
+    CHECK(!queue.Cancel("a"));
+    adapter.FinishFirst();
+    CHECK((adapter.started == std::vector<std::string>{ "a" }));
+    CHECK(queue.Stats().pending == 0);
+    CHECK(queue.Enqueue("b", 0, adapter.Attempt("b")));
+}
+
+static void throwingAttemptReleasesItsSlot()
+{
+    ConnectQueue queue(1);
+    int started = 0;
+    queue.Enqueue("a", 0, [&](ConnectQueue::Done) {
+        started++;
+        throw std::runtime_error("adapter gone");
+    });
+    queue.Enqueue("b", 0, [&](ConnectQueue::Done done) {
+        started++;
+        done(true);
+        // later calls are ignored
+        done(false);
+        throw 1;
+    });
+    queue.Enqueue("c", 0, [&](ConnectQueue::Done done) {
+        started++;
+        done(true);
+    });
+    CHECK(started == 3);
+    auto stats = queue.Stats();
+    CHECK(stats.inFlight == 0);
+    CHECK(stats.failed == 1 && stats.connected == 2);
+}
+
+static void raisingTheLimitStartsQueuedAttempts()
+{
+    ConnectQueue queue(1);
+    Adapter adapter;
+    for (auto device : { "a", "b", "c" })
+    {
+        queue.Enqueue(device, 0, adapter.Attempt(device));
+    }
+    CHECK(adapter.started.size() == 1);
+    queue.SetLimit(3);
+    CHECK(adapter.started.size() == 3);
+}
+
+int main()
+{
+    limitsConcurrentAttempts();
+    startsLowerPrioritiesFirst();
+    rejectsDevicesThatAreQueuedOrConnecting();
+    cancelsAttemptsThatHaveNotStarted();
+    throwingAttemptReleasesItsSlot();
+    raisingTheLimitStartsQueuedAttempts();
+    return checkResult();
+}
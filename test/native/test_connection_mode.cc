@@ -0,0 +1,119 @@
+#include "connection_mode.h"
+
+#include <cstring>
+#include <map>
+
+#include "check.h"
+
+// stands in for the WinRT connection parameter API
+struct FakeBackend
+{
+    bool supported = true;
+    std::map<ConnectionPreset, PresetStatus> statuses;
+    std::vector<ConnectionPreset> requested;
+    std::optional<ConnectionParameters> current;
+
+    bool IsSupported()
+    {
+        return supported;
+    }
+
+    PresetStatus Request(ConnectionPreset preset)
+    {
+        requested.push_back(preset);
+        auto it = statuses.find(preset);
+        return it == statuses.end() ? PresetStatus::Success : it->second;
+    }
+
+    std::optional<ConnectionParameters> Current()
+    {
+        return current;
+    }
+};
+
+static void appliesTheRequestedPreset()
+{
+    FakeBackend backend;
+    backend.current = ConnectionParameters{ 6, 0, 200 };
+    auto result = applyPreset(backend, ConnectionPreset::ThroughputOptimized);
+    CHECK(result.status == PresetStatus::Success);
+    CHECK(result.requested == ConnectionPreset::ThroughputOptimized);
+    CHECK(result.applied == ConnectionPreset::ThroughputOptimized);
+    CHECK(backend.requested.size() == 1);
+    CHECK(result.parameters && result.parameters->IntervalMs() == 7.5);
+    CHECK(result.parameters->TimeoutMs() == 2000);
+}
+
+static void fallsBackToBalanced()
+{
+    FakeBackend backend;
+    backend.statuses[ConnectionPreset::PowerOptimized] = PresetStatus::AccessDenied;
+    auto result = applyPreset(backend, ConnectionPreset::PowerOptimized);
+    CHECK(result.status == PresetStatus::Success);
+    CHECK(result.requested == ConnectionPreset::PowerOptimized);
+    CHECK(result.applied == ConnectionPreset::Balanced);
+    CHECK((backend.requested ==
+           std::vector<ConnectionPreset>{ ConnectionPreset::PowerOptimized,
+                                          ConnectionPreset::Balanced }));
+    CHECK(!result.parameters);
+}
+
+static void reportsTheLastFailure()
+{
+    FakeBackend backend;
+    backend.statuses[ConnectionPreset::ThroughputOptimized] = PresetStatus::Failed;
+    backend.statuses[ConnectionPreset::Balanced] = PresetStatus::AccessDenied;
+    auto result = applyPreset(backend, ConnectionPreset::ThroughputOptimized);
+    CHECK(result.status == PresetStatus::AccessDenied);
+    CHECK(!result.applied);
+    CHECK(backend.requested.size() == 2);
+
+    // balanced has nothing to fall back to
+    backend.requested.clear();
+    result = applyPreset(backend, ConnectionPreset::Balanced);
+    CHECK(result.status == PresetStatus::AccessDenied);
+    CHECK(backend.requested.size() == 1);
+}
+
+static void doesNotFallBackForMissingDevices()
+{
+    FakeBackend backend;
+    backend.statuses[ConnectionPreset::ThroughputOptimized] = PresetStatus::DeviceNotAvailable;
+    auto result = applyPreset(backend, ConnectionPreset::ThroughputOptimized);
+    CHECK(result.status == PresetStatus::DeviceNotAvailable);
+    CHECK(!result.applied);
+    CHECK(backend.requested.size() == 1);
+}
+
+static void unsupportedWithoutTheApi()
+{
+    FakeBackend backend;
+    backend.supported = false;
+    auto result = applyPreset(backend, ConnectionPreset::PowerOptimized);
+    CHECK(result.status == PresetStatus::Unsupported);
+    CHECK(!result.applied);
+    CHECK(backend.requested.empty());
+}
+
+static void namesMatchThePresets()
+{
+    CHECK(sizeof(CONNECTION_PRESET_NAMES) / sizeof(CONNECTION_PRESET_NAMES[0]) ==
+          CONNECTION_PRESETS);
+    CHECK(strcmp(CONNECTION_PRESET_NAMES[static_cast<int>(ConnectionPreset::Balanced)],
+                 "balanced") == 0);
+    CHECK(strcmp(CONNECTION_PRESET_NAMES[static_cast<int>(ConnectionPreset::ThroughputOptimized)],
+                 "throughput") == 0);
+    CHECK(strcmp(CONNECTION_PRESET_NAMES[static_cast<int>(ConnectionPreset::PowerOptimized)],
+                 "power") == 0);
+}
+
+int main()
+{
+    appliesTheRequestedPreset();
+    fallsBackToBalanced();
+    reportsTheLastFailure();
+    doesNotFallBackForMissingDevices();
+    unsupportedWithoutTheApi();
+    namesMatchThePresets();
+    return checkResult();
+}
@@ -0,0 +1,134 @@
+#include "deadline_timer.h"
+
+#include <atomic>
+#include <future>
+#include <vector>
+
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+static void failsOperationsPastTheirDeadline()
+{
+    DeadlineTimer timer;
+    std::promise<OperationError> failed;
+    std::atomic<bool> cancelled{ false };
+    auto operation = timer.Start("a", 20ms, [&](const OperationError& error) {
+        failed.set_value(error);
+    });
+    operation->SetCancel([&]() { cancelled = true; });
+    auto future = failed.get_future();
+    CHECK(future.wait_for(5s) == std::future_status::ready);
+    CHECK(future.get().status == OperationStatus::Timeout);
+    CHECK(cancelled);
+    // the async operation completing late doesn't settle it again
+    CHECK(!operation->Settle());
+}
+
+static void completedOperationsDoNotTimeOut()
+{
+    DeadlineTimer timer;
+    std::atomic<int> failures{ 0 };
+    auto operation = timer.Start("a", 20ms, [&](const OperationError&) { failures++; });
+    CHECK(operation->Settle());
+    std::promise<void> passed;
+    timer.After(60ms, [&]() { passed.set_value(); });
+    passed.get_future().wait();
+    CHECK(failures == 0);
+}
+
+static void cancelAllFailsOnlyTheDevice()
+{
+    DeadlineTimer timer;
+    std::vector<OperationError> failures;
+    auto a = timer.Start("a", 0ms, [&](const OperationError& error) { failures.push_back(error); });
+    auto b = timer.Start("b", 0ms, [&](const OperationError& error) { failures.push_back(error); });
+    timer.CancelAll("a", "device disconnected");
+    CHECK(failures.size() == 1);
+    CHECK(failures[0].status == OperationStatus::Cancelled);
+    CHECK(failures[0].message == "device disconnected");
+    CHECK(a->IsSettled());
+    CHECK(!b->IsSettled());
+    // a second cancellation finds nothing to fail
+    timer.CancelAll("a", "device disconnected");
+    CHECK(failures.size() == 1);
+}
+
+static void cancelRunsRightAwayOnceSettled()
+{
+    DeadlineTimer timer;
+    auto operation = timer.Start("a", 0ms, [](const OperationError&) {});
+    operation->Fail({ OperationStatus::Failed, "failed" });
+    bool cancelled = false;
+    operation->SetCancel([&]() { cancelled = true; });
+    CHECK(cancelled);
+}
+
+static void onCompletedObservesTheResult()
+{
+    DeadlineTimer timer;
+    auto operation = timer.Start("a", 0ms, [](const OperationError&) {});
+    int completed = 0;
+    operation->SetOnCompleted([&](const OperationError& error) {
+        completed++;
+        CHECK(error.status == OperationStatus::NotFound);
+    });
+    CHECK(operation->Settle());
+    operation->Completed({ OperationStatus::NotFound, "" });
+    // the observer runs once
+    operation->Completed({ OperationStatus::NotFound, "" });
+    CHECK(completed == 1);
+}
+
+static void runsTimersInOrderOnItsThread()
+{
+    std::thread::id timerThread;
+    DeadlineTimer timer([&]() { timerThread = std::this_thread::get_id(); });
+    std::mutex mutex;
+    std::vector<int> order;
+    std::vector<std::thread::id> threads;
+    std::promise<void> done;
+    timer.After(40ms, [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(2);
+        threads.push_back(std::this_thread::get_id());
+        done.set_value();
+    });
+    timer.After(10ms, [&]() {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(1);
+        threads.push_back(std::this_thread::get_id());
+    });
+    CHECK(done.get_future().wait_for(5s) == std::future_status::ready);
+    std::lock_guard<std::mutex> lock(mutex);
+    CHECK((order == std::vector<int>{ 1, 2 }));
+    CHECK(threads.size() == 2 && threads[0] == timerThread && threads[1] == timerThread);
+}
+
+static void sweepsCompletedOperations()
+{
+    DeadlineTimer timer;
+    std::atomic<int> failures{ 0 };
+    // far deadlines of operations that completed, and were released, must not pile up
+    for (int i = 0; i < 10000; i++)
+    {
+        auto operation = timer.Start("a", 1h, [&](const OperationError&) { failures++; });
+        operation->Settle();
+    }
+    auto last = timer.Start("a", 1h, [&](const OperationError&) { failures++; });
+    timer.CancelAll("a", "closed");
+    CHECK(failures == 1);
+    CHECK(last->IsSettled());
+}
+
+int main()
+{
+    failsOperationsPastTheirDeadline();
+    completedOperationsDoNotTimeOut();
+    cancelAllFailsOnlyTheDevice();
+    cancelRunsRightAwayOnceSettled();
+    onCompletedObservesTheResult();
+    runsTimersInOrderOnItsThread();
+    sweepsCompletedOperations();
+    return checkResult();
+}
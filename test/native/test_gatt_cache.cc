@@ -0,0 +1,116 @@
+#include "gatt_cache.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+using Cache = GattCache<std::string>;
+using Clock = Cache::Clock;
+
+static CachePolicy ttl(std::chrono::milliseconds ttl)
+{
+    return { CacheMode::Ttl, ttl };
+}
+
+static void discoveriesAreFreshPerAttribute()
+{
+    Cache cache;
+    auto start = Clock::now();
+    CHECK(!cache.DiscoveryFresh("a", ttl(10s), start));
+    cache.Discovered("a", start);
+    CHECK(cache.DiscoveryFresh("a", ttl(10s), start + 9s));
+    CHECK(!cache.DiscoveryFresh("a", ttl(10s), start + 10s));
+    // the discovery of another attribute revalidates only that attribute
+    CHECK(!cache.DiscoveryFresh("b", ttl(10s), start + 1s));
+    CHECK(cache.DiscoveryFresh("a", { CacheMode::Cached }, start + 1h));
+    CHECK(!cache.DiscoveryFresh("a", { CacheMode::Uncached }, start));
+}
+
+static void failedRevalidationsDoNotCount()
+{
+    Cache cache;
+    auto start = Clock::now();
+    // a discovery that isn't recorded failed, the next one still goes to the device
+    CHECK(!cache.DiscoveryFresh("a", ttl(10s), start));
+    CHECK(!cache.DiscoveryFresh("a", ttl(10s), start + 1s));
+    cache.Discovered("a", start + 5s);
+    // a slower discovery that started earlier doesn't make the attribute older
+    cache.Discovered("a", start + 1s);
+    CHECK(cache.DiscoveryFresh("a", ttl(10s), start + 14s));
+}
+
+static void lookupsRevalidateOnceThePolicyExpires()
+{
+    Cache cache;
+    auto start = Clock::now();
+    // attribute lookups use the Windows cache by default
+    CHECK(cache.LookupFresh(start));
+    CHECK(!cache.LookupsExpired(start + 1h));
+
+    cache.SetLookupPolicy(ttl(10s));
+    CHECK(!cache.LookupFresh(start));
+    CHECK(cache.LookupFresh(start + 9s));
+    CHECK(cache.LookupsExpired(start + 10s));
+    CHECK(!cache.LookupFresh(start + 10s));
+    CHECK(!cache.LookupsExpired(start + 11s));
+}
+
+static void valuesExpireWithTheReadPolicy()
+{
+    Cache cache;
+    auto start = Clock::now();
+    CHECK(!cache.Value("a", { CacheMode::Cached }, start));
+    cache.SetValue("a", Payload(std::vector<uint8_t>{ 1, 2 }), start);
+    auto value = cache.Value("a", ttl(1s), start + 500ms);
+    CHECK(value && value->size == 2 && value->data[1] == 2);
+    CHECK(!cache.Value("a", ttl(1s), start + 1s));
+    CHECK(!cache.Value("a", { CacheMode::Uncached }, start));
+
+    cache.Discovered("a", start);
+    cache.Clear();
+    CHECK(!cache.Value("a", { CacheMode::Cached }, start));
+    CHECK(!cache.DiscoveryFresh("a", ttl(10s), start));
+}
+
+static void concurrentAccess()
+{
+    Cache cache;
+    cache.SetLookupPolicy(ttl(1ms));
+    auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&cache, start, t] {
+            auto key = std::to_string(t % 2);
+            for (int i = 0; i < 1000; i++)
+            {
+                auto now = start + std::chrono::milliseconds(i);
+                cache.Discovered(key, now);
+                cache.DiscoveryFresh(key, ttl(10ms), now);
+                cache.SetValue(key, Payload(std::vector<uint8_t>{ uint8_t(i) }), now);
+                cache.Value(key, ttl(10ms), now);
+                cache.LookupFresh(now);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    CHECK(cache.DiscoveryFresh("0", ttl(10ms), start + 1000ms));
+    CHECK(cache.Value("1", ttl(10ms), start + 1000ms));
+}
+
+int main()
+{
+    discoveriesAreFreshPerAttribute();
+    failedRevalidationsDoNotCount();
+    lookupsRevalidateOnceThePolicyExpires();
+    valuesExpireWithTheReadPolicy();
+    concurrentAccess();
+    return checkResult();
+}
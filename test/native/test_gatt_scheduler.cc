@@ -0,0 +1,168 @@
+#include "gatt_scheduler.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "check.h"
+
+// records the order in which operations start and keeps them in flight until finished
+struct Recorder
+{
+    std::vector<std::string> started;
+    std::vector<GattScheduler::Done> running;
+
+    GattScheduler::Operation Operation(const std::string& name)
+    {
+        return [this, name](GattScheduler::Done done) {
+            started.push_back(name);
+            running.push_back(done);
+        };
+    }
+
+    void FinishFirst()
+    {
+        auto done = running.front();
+        running.erase(running.begin());
+        done();
+    }
+};
+
+static void limitsOperationsPerDevice()
+{
+    GattScheduler scheduler(2, 16);
+    Recorder recorder;
+    for (int i = 0; i < 5; i++)
+    {
+        scheduler.Enqueue("a", OperationPriority::Read, recorder.Operation(std::to_string(i)));
+    }
+    CHECK(recorder.started.size() == 2);
+    auto stats = scheduler.Stats()["a"];
+    CHECK(stats.inFlight == 2);
+    CHECK(stats.queued == 3);
+    CHECK(stats.maxQueued == 3);
+
+    recorder.FinishFirst();
+    CHECK(recorder.started.size() == 3);
+    while (!recorder.running.empty())
+    {
+        recorder.FinishFirst();
+    }
+    CHECK((recorder.started == std::vector<std::string>{ "0", "1", "2", "3", "4" }));
+    stats = scheduler.Stats()["a"];
+    CHECK(stats.enqueued == 5);
+    CHECK(stats.completed == 5);
+    CHECK(stats.inFlight == 0);
+}
+
+static void startsHigherPrioritiesFirst()
+{
+    GattScheduler scheduler(1, 16);
+    Recorder recorder;
+    scheduler.Enqueue("a", OperationPriority::Read, recorder.Operation("blocker"));
+    scheduler.Enqueue("a", OperationPriority::Read, recorder.Operation("read"));
+    scheduler.Enqueue("a", OperationPriority::Write, recorder.Operation("write"));
+    scheduler.Enqueue("a", OperationPriority::Notify, recorder.Operation("notify"));
+    while (!recorder.running.empty())
+    {
+        recorder.FinishFirst();
+    }
+    CHECK((recorder.started ==
+           std::vector<std::string>{ "blocker", "notify", "write", "read" }));
+}
+
+static void sharesTheAdapterRoundRobin()
+{
+    GattScheduler scheduler(4, 2);
+    Recorder recorder;
+    for (int i = 0; i < 3; i++)
+    {
+        scheduler.Enqueue("a", OperationPriority::Read, recorder.Operation("a"));
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        scheduler.Enqueue("b", OperationPriority::Read, recorder.Operation("b"));
+    }
+    // device a took both adapter slots before b was queued, after that the slots alternate
+    CHECK((recorder.started == std::vector<std::string>{ "a", "a" }));
+    recorder.FinishFirst();
+    recorder.FinishFirst();
+    CHECK(recorder.started.size() == 4);
+    CHECK(recorder.started[2] != recorder.started[3]);
+}
+
+static void synchronousCompletionDoesNotRecurse()
+{
+    GattScheduler scheduler(1, 1);
+    int depth = 0;
+    int maxDepth = 0;
+    int completed = 0;
+    for (int i = 0; i < 100; i++)
+    {
+        scheduler.Enqueue("a", OperationPriority::Read, [&](GattScheduler::Done done) {
+            depth++;
+            maxDepth = std::max(maxDepth, depth);
+            completed++;
+            done();
+            depth--;
+        });
+    }
+    CHECK(completed == 100);
+    CHECK(maxDepth == 1);
+}
+
+static void throwingOperationReleasesItsSlot()
+{
+    GattScheduler scheduler(1, 1);
+    int started = 0;
+    scheduler.Enqueue("a", OperationPriority::Read, [&](GattScheduler::Done) {
+        started++;
+        throw std::runtime_error("device closed");
+    });
+    scheduler.Enqueue("a", OperationPriority::Read, [&](GattScheduler::Done done) {
+        started++;
+        done();
+        // a later call, e.g. by a deadline, is ignored
+        done();
+        throw 1;
+    });
+    scheduler.Enqueue("a", OperationPriority::Read, [&](GattScheduler::Done done) {
+        started++;
+        done();
+    });
+    CHECK(started == 3);
+    auto stats = scheduler.Stats()["a"];
+    CHECK(stats.inFlight == 0);
+    CHECK(stats.completed == 3);
+
+    // the scheduler keeps pumping
+    scheduler.Enqueue("a", OperationPriority::Read, [&](GattScheduler::Done done) {
+        started++;
+        done();
+    });
+    CHECK(started == 4);
+}
+
+static void raisingLimitsStartsQueuedOperations()
+{
+    GattScheduler scheduler(1, 1);
+    Recorder recorder;
+    scheduler.Enqueue("a", OperationPriority::Read, recorder.Operation("0"));
+    scheduler.Enqueue("a", OperationPriority::Read, recorder.Operation("1"));
+    scheduler.Enqueue("a", OperationPriority::Read, recorder.Operation("2"));
+    CHECK(recorder.started.size() == 1);
+    scheduler.SetLimits(3, 3);
+    CHECK(recorder.started.size() == 3);
+}
+
+int main()
+{
+    limitsOperationsPerDevice();
+    startsHigherPrioritiesFirst();
+    sharesTheAdapterRoundRobin();
+    synchronousCompletionDoesNotRecurse();
+    throwingOperationReleasesItsSlot();
+    raisingLimitsStartsQueuedOperations();
+    return checkResult();
+}
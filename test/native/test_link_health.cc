@@ -0,0 +1,152 @@
+#include "link_health.h"
+
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+using Clock = LinkHealth::Clock;
+
+static HealthOptions options()
+{
+    HealthOptions options;
+    options.degradedAfter = 5s;
+    options.staleAfter = 15s;
+    options.failuresDegraded = 3;
+    return options;
+}
+
+static void degradesAndGoesStaleWhileSilent()
+{
+    LinkHealth health;
+    auto start = Clock::now();
+    CHECK(health.Watch("a", options(), start));
+    bool keepChecking = false;
+    CHECK(health.Check(start + 4s, keepChecking).empty());
+    CHECK(keepChecking);
+
+    auto changes = health.Check(start + 5s, keepChecking);
+    CHECK(changes.size() == 1);
+    CHECK(changes[0].device == "a" && changes[0].state == LinkState::Degraded);
+    CHECK(changes[0].silent == 5s);
+    // only changes are reported
+    CHECK(health.Check(start + 6s, keepChecking).empty());
+
+    changes = health.Check(start + 15s, keepChecking);
+    CHECK(changes.size() == 1 && changes[0].state == LinkState::Stale);
+
+    health.Activity("a", start + 16s);
+    changes = health.Check(start + 16s, keepChecking);
+    CHECK(changes.size() == 1 && changes[0].state == LinkState::Healthy);
+    CHECK(changes[0].silent == 0s);
+}
+
+static void ignoresActivityFromThePast()
+{
+    LinkHealth health;
+    auto start = Clock::now();
+    health.Watch("a", options(), start);
+    health.Activity("a", start + 3s);
+    // a notification that was queued before the last one
+    health.Activity("a", start + 1s);
+    bool keepChecking;
+    CHECK(health.Check(start + 7s, keepChecking).empty());
+    CHECK(health.Check(start + 8s, keepChecking).size() == 1);
+}
+
+static void consecutiveFailuresDegrade()
+{
+    LinkHealth health;
+    auto start = Clock::now();
+    health.Watch("a", options(), start);
+    bool keepChecking;
+    health.Completed("a", 1ms, false, start);
+    health.Completed("a", 1ms, false, start);
+    CHECK(health.Check(start, keepChecking).empty());
+    health.Completed("a", 1ms, false, start);
+    auto changes = health.Check(start, keepChecking);
+    CHECK(changes.size() == 1 && changes[0].state == LinkState::Degraded);
+    // a success resets the count
+    health.Completed("a", 1ms, true, start + 1s);
+    changes = health.Check(start + 1s, keepChecking);
+    CHECK(changes.size() == 1 && changes[0].state == LinkState::Healthy);
+
+    auto snapshot = health.Snapshot("a", start + 2s);
+    CHECK(snapshot && snapshot->failed == 3 && snapshot->succeeded == 1);
+    CHECK(snapshot->silent == 1s);
+}
+
+static void reportsLatencyPercentiles()
+{
+    LinkHealth health;
+    auto start = Clock::now();
+    health.Watch("a", options(), start);
+    for (int i = 1; i <= 100; i++)
+    {
+        health.Completed("a", std::chrono::microseconds(i), true, start);
+    }
+    auto snapshot = health.Snapshot("a", start);
+    CHECK(snapshot->samples == 100);
+    CHECK(snapshot->p50 == std::chrono::microseconds(50));
+    CHECK(snapshot->p90 == std::chrono::microseconds(90));
+    CHECK(snapshot->p99 == std::chrono::microseconds(99));
+
+    // only the recent operations count
+    for (int i = 0; i < 200; i++)
+    {
+        health.Completed("a", std::chrono::microseconds(1000), true, start);
+    }
+    snapshot = health.Snapshot("a", start);
+    CHECK(snapshot->samples == 128);
+    CHECK(snapshot->p50 == std::chrono::microseconds(1000));
+}
+
+static void probesSilentLinks()
+{
+    LinkHealth health;
+    auto start = Clock::now();
+    auto probing = options();
+    probing.probeInterval = 2s;
+    health.Watch("a", probing, start);
+    health.Watch("b", options(), start);
+    CHECK(health.DueProbes(start + 1s).empty());
+    auto due = health.DueProbes(start + 2s);
+    CHECK(due.size() == 1 && due[0] == "a");
+    // not again before the interval has passed
+    CHECK(health.DueProbes(start + 3s).empty());
+    // a busy link isn't probed
+    health.Activity("a", start + 3500ms);
+    CHECK(health.DueProbes(start + 4s).empty());
+    CHECK(health.DueProbes(start + 6s).size() == 1);
+}
+
+static void stopsCheckingWithoutDevices()
+{
+    LinkHealth health;
+    auto start = Clock::now();
+    CHECK(health.Watch("a", options(), start));
+    // already checking
+    CHECK(!health.Watch("b", options(), start));
+    CHECK(health.Devices().size() == 2);
+    health.Unwatch("a");
+    health.Unwatch("b");
+    CHECK(!health.Snapshot("a", start));
+    bool keepChecking = true;
+    CHECK(health.Check(start, keepChecking).empty());
+    CHECK(!keepChecking);
+    CHECK(health.Watch("a", options(), start));
+    // unknown devices are ignored
+    health.Activity("c", start);
+    health.Completed("c", 1ms, false, start);
+    CHECK(health.Devices().size() == 1);
+}
+
+int main()
+{
+    degradesAndGoesStaleWhileSilent();
+    ignoresActivityFromThePast();
+    consecutiveFailuresDegrade();
+    reportsLatencyPercentiles();
+    probesSilentLinks();
+    stopsCheckingWithoutDevices();
+    return checkResult();
+}
@@ -0,0 +1,169 @@
+#include "notify_ring.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+
+// 8 byte aligned memory for a ring
+struct Memory
+{
+    std::vector<uint64_t> words;
+
+    explicit Memory(size_t size) : words(size / 8)
+    {
+    }
+
+    uint8_t* data()
+    {
+        return reinterpret_cast<uint8_t*>(words.data());
+    }
+
+    uint32_t At(size_t offset)
+    {
+        uint32_t value;
+        memcpy(&value, data() + offset, sizeof(value));
+        return value;
+    }
+};
+
+static std::vector<uint8_t> bytes(size_t size, uint8_t first)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++)
+    {
+        data[i] = static_cast<uint8_t>(first + i);
+    }
+    return data;
+}
+
+static void createsRingsThatFitTheMemory()
+{
+    Memory memory(NotifyRing::HEADER_SIZE + 1000);
+    auto ring = NotifyRing::Create(memory.data(), NotifyRing::HEADER_SIZE + 1000);
+    CHECK(ring && ring->Capacity() == 512);
+    CHECK(memory.At(4) == 512);
+    // too small or misaligned
+    CHECK(!NotifyRing::Create(memory.data(), NotifyRing::HEADER_SIZE + 32));
+    CHECK(!NotifyRing::Create(memory.data() + 4, NotifyRing::HEADER_SIZE + 512));
+}
+
+static void popsRecordsInOrder()
+{
+    Memory memory(NotifyRing::HEADER_SIZE + 256);
+    auto ring = NotifyRing::Create(memory.data(), NotifyRing::HEADER_SIZE + 256);
+    auto first = bytes(5, 1);
+    auto second = bytes(0, 0);
+    CHECK(ring->Push(10, first.data(), first.size()));
+    CHECK(ring->Push(20, second.data(), second.size()));
+    // the write position counts padded records
+    CHECK(memory.At(0) == 16 + 8 + 16);
+
+    uint64_t timestamp;
+    std::vector<uint8_t> data;
+    CHECK(ring->Pop(timestamp, data));
+    CHECK(timestamp == 10 && data == first);
+    CHECK(ring->Pop(timestamp, data));
+    CHECK(timestamp == 20 && data.empty());
+    CHECK(!ring->Pop(timestamp, data));
+    CHECK(memory.At(64) == memory.At(0));
+}
+
+static void wrapsAroundTheEnd()
+{
+    Memory memory(NotifyRing::HEADER_SIZE + 128);
+    auto ring = NotifyRing::Create(memory.data(), NotifyRing::HEADER_SIZE + 128);
+    CHECK(ring->Capacity() == 128);
+    uint64_t timestamp;
+    std::vector<uint8_t> data;
+    // records of 40 bytes don't divide the capacity, every few records wrap
+    for (uint8_t i = 0; i < 50; i++)
+    {
+        auto payload = bytes(20, i);
+        CHECK(ring->Push(i, payload.data(), payload.size()));
+        CHECK(ring->Pop(timestamp, data));
+        CHECK(timestamp == i && data == payload);
+    }
+    CHECK(ring->Dropped() == 0);
+}
+
+static void dropsRecordsThatDoNotFit()
+{
+    Memory memory(NotifyRing::HEADER_SIZE + 128);
+    auto ring = NotifyRing::Create(memory.data(), NotifyRing::HEADER_SIZE + 128);
+    auto payload = bytes(48, 0);
+    CHECK(ring->Push(1, payload.data(), payload.size()));
+    CHECK(ring->Push(2, payload.data(), payload.size()));
+    CHECK(!ring->Push(3, payload.data(), payload.size()));
+    auto huge = bytes(200, 0);
+    CHECK(!ring->Push(4, huge.data(), huge.size()));
+    CHECK(ring->Dropped() == 2);
+    CHECK(memory.At(8) == 2);
+
+    // reading frees the room again
+    uint64_t timestamp;
+    std::vector<uint8_t> data;
+    CHECK(ring->Pop(timestamp, data) && timestamp == 1);
+    CHECK(ring->Push(5, payload.data(), payload.size()));
+}
+
+static void stopsWritingOnceClosed()
+{
+    Memory memory(NotifyRing::HEADER_SIZE + 128);
+    auto ring = NotifyRing::Create(memory.data(), NotifyRing::HEADER_SIZE + 128);
+    ring->Close();
+    auto payload = bytes(8, 0);
+    CHECK(!ring->Push(1, payload.data(), payload.size()));
+    CHECK(memory.At(0) == 0);
+    CHECK(ring->Dropped() == 0);
+}
+
+static void handsRecordsToAnotherThread()
+{
+    Memory memory(NotifyRing::HEADER_SIZE + 1024);
+    auto ring = NotifyRing::Create(memory.data(), NotifyRing::HEADER_SIZE + 1024);
+    const uint64_t count = 100000;
+    std::thread producer([&]() {
+        for (uint64_t i = 0; i < count;)
+        {
+            auto payload = bytes(i % 40, static_cast<uint8_t>(i));
+            if (ring->Push(i, payload.data(), payload.size()))
+            {
+                i++;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint64_t expected = 0;
+    bool intact = true;
+    uint64_t timestamp;
+    std::vector<uint8_t> data;
+    while (expected < count)
+    {
+        if (!ring->Pop(timestamp, data))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        intact = intact && timestamp == expected &&
+                 data == bytes(expected % 40, static_cast<uint8_t>(expected));
+        expected++;
+    }
+    producer.join();
+    CHECK(intact);
+}
+
+int main()
+{
+    createsRingsThatFitTheMemory();
+    popsRecordsInOrder();
+    wrapsAroundTheEnd();
+    dropsRecordsThatDoNotFit();
+    stopsWritingOnceClosed();
+    handsRecordsToAnotherThread();
+    return checkResult();
+}
@@ -0,0 +1,107 @@
+#include "notify_stats.h"
+
+#include <thread>
+#include <vector>
+
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+using Clock = NotifyStats::Clock;
+
+static void bucketsArePowersOfTwo()
+{
+    DurationHistogram histogram;
+    for (uint64_t micros : { 0, 1, 2, 3, 4, 7, 8, 1023, 1024 })
+    {
+        histogram.Add(micros);
+    }
+    auto snapshot = histogram.Snapshot();
+    CHECK(snapshot.buckets[0] == 1);
+    CHECK(snapshot.buckets[1] == 1);
+    // bucket i counts durations from 2^(i - 1) up to 2^i
+    CHECK(snapshot.buckets[2] == 2);
+    CHECK(snapshot.buckets[3] == 2);
+    CHECK(snapshot.buckets[4] == 1);
+    CHECK(snapshot.buckets[10] == 1);
+    CHECK(snapshot.buckets[11] == 1);
+    CHECK(snapshot.count == 9);
+    CHECK(snapshot.max == 1024);
+    CHECK(snapshot.sum == 0 + 1 + 2 + 3 + 4 + 7 + 8 + 1023 + 1024);
+}
+
+static void longDurationsGoToTheLastBucket()
+{
+    DurationHistogram histogram;
+    histogram.Add(uint64_t(1) << 40);
+    histogram.Add(UINT64_MAX);
+    auto snapshot = histogram.Snapshot();
+    CHECK(snapshot.buckets[DURATION_BUCKETS - 1] == 2);
+    CHECK(snapshot.max == UINT64_MAX);
+}
+
+static void concurrentUpdatesKeepTheMax()
+{
+    DurationHistogram histogram;
+    std::vector<std::thread> threads;
+    for (uint64_t t = 0; t < 4; t++)
+    {
+        threads.emplace_back([&histogram, t] {
+            for (uint64_t i = 1; i <= 1000; i++)
+            {
+                histogram.Add(i * 4 + t);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    auto snapshot = histogram.Snapshot();
+    CHECK(snapshot.count == 4000);
+    CHECK(snapshot.max == 4003);
+    uint64_t counted = 0;
+    for (auto count : snapshot.buckets)
+    {
+        counted += count;
+    }
+    CHECK(counted == 4000);
+}
+
+static void measuresGapsAndQueueDelay()
+{
+    NotifyStats stats;
+    CHECK(!stats.LastArrival());
+    auto start = Clock::now();
+    stats.Arrived(start, 20);
+    stats.Arrived(start + 10ms, 20);
+    stats.Arrived(start + 15ms, 4);
+    stats.Dispatched(start, start + 3ms);
+    // a clock that went backwards doesn't count as a long delay
+    stats.Dispatched(start + 5ms, start);
+    stats.Throttled();
+    stats.DecodeError();
+
+    auto snapshot = stats.Snapshot();
+    CHECK(snapshot.notifications == 3);
+    CHECK(snapshot.bytes == 44);
+    CHECK(snapshot.throttled == 1 && snapshot.decodeErrors == 1);
+    // the first notification has no gap
+    CHECK(snapshot.gaps.count == 2);
+    CHECK(snapshot.gaps.sum == 15000);
+    CHECK(snapshot.gaps.max == 10000);
+    CHECK(snapshot.queueDelay.count == 2);
+    CHECK(snapshot.queueDelay.max == 3000 && snapshot.queueDelay.buckets[0] == 1);
+    // kept in microseconds
+    auto last = stats.LastArrival();
+    CHECK(last && *last <= start + 15ms && *last > start + 15ms - 1us);
+}
+
+int main()
+{
+    bucketsArePowersOfTwo();
+    longDurationsGoToTheLastBucket();
+    concurrentUpdatesKeepTheMax();
+    measuresGapsAndQueueDelay();
+    return checkResult();
+}
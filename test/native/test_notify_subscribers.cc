@@ -0,0 +1,94 @@
+#include "notify_subscribers.h"
+
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+using Clock = std::chrono::steady_clock;
+
+static SubscriberOptions limited(std::chrono::milliseconds minInterval)
+{
+    SubscriberOptions options;
+    options.minInterval = minInterval;
+    return options;
+}
+
+static void deliversToEverySubscriber()
+{
+    NotifySubscribers subscribers;
+    CHECK(subscribers.Empty());
+    CHECK(!subscribers.Deliver(Clock::now()));
+    CHECK(subscribers.Add("a", {}));
+    CHECK(subscribers.Add("b", {}));
+    // joining again only updates the options
+    CHECK(!subscribers.Add("a", {}));
+
+    auto ids = subscribers.Deliver(Clock::now());
+    CHECK(ids && (*ids == std::vector<std::string>{ "a", "b" }));
+    // without rate limits the list is shared by all notifications
+    CHECK(subscribers.Deliver(Clock::now()) == ids);
+}
+
+static void throttlesToTheMinInterval()
+{
+    NotifySubscribers subscribers;
+    subscribers.Add("slow", limited(100ms));
+    subscribers.Add("fast", {});
+    auto start = Clock::now();
+
+    auto ids = subscribers.Deliver(start);
+    CHECK(ids && ids->size() == 2);
+    ids = subscribers.Deliver(start + 50ms);
+    CHECK(ids && (*ids == std::vector<std::string>{ "fast" }));
+    ids = subscribers.Deliver(start + 99ms);
+    CHECK(ids && ids->size() == 1);
+    // the interval counts from the last delivered notification
+    ids = subscribers.Deliver(start + 100ms);
+    CHECK(ids && ids->size() == 2);
+    ids = subscribers.Deliver(start + 150ms);
+    CHECK(ids && ids->size() == 1);
+}
+
+static void dropsNotificationsThatAreThrottledForAll()
+{
+    NotifySubscribers subscribers;
+    subscribers.Add("a", limited(100ms));
+    subscribers.Add("b", limited(200ms));
+    auto start = Clock::now();
+    CHECK(subscribers.Deliver(start));
+    CHECK(!subscribers.Deliver(start + 10ms));
+    CHECK(!subscribers.Deliver(start + 99ms));
+    auto ids = subscribers.Deliver(start + 100ms);
+    CHECK(ids && (*ids == std::vector<std::string>{ "a" }));
+    CHECK(!subscribers.Deliver(start + 150ms));
+}
+
+static void removingTheLimitedSubscriberLiftsTheLimit()
+{
+    NotifySubscribers subscribers;
+    subscribers.Add("a", limited(100ms));
+    subscribers.Add("b", {});
+    auto start = Clock::now();
+    subscribers.Deliver(start);
+    CHECK(subscribers.Remove("a"));
+    CHECK(!subscribers.Remove("a"));
+    auto first = subscribers.Deliver(start + 1ms);
+    CHECK(first && first->size() == 1);
+    CHECK(subscribers.Deliver(start + 2ms) == first);
+
+    // joining again with a rate limit limits the subscriber again
+    CHECK(!subscribers.Add("b", limited(100ms)));
+    CHECK(!subscribers.Deliver(start + 3ms));
+    CHECK(subscribers.Deliver(start + 100ms));
+    CHECK(subscribers.Remove("b"));
+    CHECK(subscribers.Empty());
+}
+
+int main()
+{
+    deliversToEverySubscriber();
+    throttlesToTheMinInterval();
+    dropsNotificationsThatAreThrottledForAll();
+    removingTheLimitedSubscriberLiftsTheLimit();
+    return checkResult();
+}
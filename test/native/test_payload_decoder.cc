@@ -0,0 +1,162 @@
+#include "payload_decoder.h"
+
+#include <cstring>
+#include <limits>
+
+#include "check.h"
+
+static FieldSpec field(FieldType type, bool bigEndian = false, double scale = 1, double offset = 0)
+{
+    FieldSpec spec;
+    spec.type = type;
+    spec.bigEndian = bigEndian;
+    spec.scale = scale;
+    spec.offset = offset;
+    return spec;
+}
+
+static FieldSpec skip(size_t size)
+{
+    FieldSpec spec;
+    spec.type = FieldType::Skip;
+    spec.size = size;
+    return spec;
+}
+
+static DecodedValues decode(const DecoderSchema& schema, const std::vector<uint8_t>& payload)
+{
+    DecodedValues values;
+    auto decoder = PayloadDecoder::Compile(schema);
+    CHECK(decoder);
+    if (decoder)
+    {
+        CHECK(decoder->Decode(payload.data(), payload.size(), values));
+    }
+    return values;
+}
+
+static void decodesEveryType()
+{
+    DecoderSchema schema;
+    schema.fields = { field(FieldType::UInt8),  field(FieldType::Int8),
+                      field(FieldType::UInt16), field(FieldType::Int16, true),
+                      field(FieldType::UInt24), field(FieldType::Int24),
+                      field(FieldType::UInt32), field(FieldType::Int32),
+                      field(FieldType::Float32) };
+    std::vector<uint8_t> payload = { 0xff, 0xff, 0x34, 0x12, 0xff, 0xfe, 0x01, 0x02, 0x03,
+                                     0xfe, 0xff, 0xff, 0x78, 0x56, 0x34, 0x12, 0xff, 0xff,
+                                     0xff, 0xff };
+    float half = 0.5f;
+    uint8_t bytes[4];
+    memcpy(bytes, &half, sizeof(bytes));
+    payload.insert(payload.end(), bytes, bytes + 4);
+
+    auto values = decode(schema, payload);
+    CHECK(values.output == DecoderOutput::Float32);
+    CHECK(values.floats.size() == 9);
+    CHECK(values.floats[0] == 255);
+    CHECK(values.floats[1] == -1);
+    CHECK(values.floats[2] == 0x1234);
+    CHECK(values.floats[3] == -2);
+    CHECK(values.floats[4] == 0x030201);
+    CHECK(values.floats[5] == -2);
+    CHECK(values.floats[6] == static_cast<float>(0x12345678));
+    CHECK(values.floats[7] == -1);
+    CHECK(values.floats[8] == 0.5f);
+    CHECK(values.rows == 0);
+}
+
+static void scalesAndSkips()
+{
+    // a heart rate style payload: flags, then a value in tenths with an offset
+    DecoderSchema schema;
+    schema.fields = { skip(1), field(FieldType::Int16, false, 0.1, -40) };
+    auto values = decode(schema, { 0x80, 0x2c, 0x01 });
+    CHECK(values.floats.size() == 1);
+    CHECK(values.floats[0] == -10);
+}
+
+static void decodesRepeatedGroups()
+{
+    DecoderSchema schema;
+    schema.fields = { field(FieldType::UInt8) };
+    schema.repeat = { field(FieldType::Int16), skip(1) };
+    schema.output = DecoderOutput::Int32;
+    auto values = decode(schema, { 2, 0x01, 0x00, 0xaa, 0xff, 0xff, 0xbb });
+    CHECK(values.output == DecoderOutput::Int32);
+    CHECK(values.rows == 2);
+    CHECK((values.ints == std::vector<int32_t>{ 2, 1, -1 }));
+
+    // only the fields, no rows
+    values = decode(schema, { 7 });
+    CHECK(values.rows == 0);
+    CHECK((values.ints == std::vector<int32_t>{ 7 }));
+}
+
+static void appendsToTheValues()
+{
+    DecoderSchema schema;
+    schema.repeat = { field(FieldType::UInt8) };
+    auto decoder = PayloadDecoder::Compile(schema);
+    DecodedValues values;
+    std::vector<uint8_t> first = { 1, 2 };
+    std::vector<uint8_t> second = { 3 };
+    CHECK(decoder->Decode(first.data(), first.size(), values));
+    CHECK(decoder->Decode(second.data(), second.size(), values));
+    CHECK(values.rows == 3);
+    CHECK((values.floats == std::vector<float>{ 1, 2, 3 }));
+}
+
+static void roundsAndClampsInts()
+{
+    DecoderSchema schema;
+    schema.fields = { field(FieldType::UInt8, false, 0.5),
+                      field(FieldType::UInt32, false, 4),
+                      field(FieldType::Int32, false, 4) };
+    schema.output = DecoderOutput::Int32;
+    auto values = decode(schema, { 3, 0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x80 });
+    CHECK(values.ints.size() == 3);
+    CHECK(values.ints[0] == 2);
+    CHECK(values.ints[1] == std::numeric_limits<int32_t>::max());
+    CHECK(values.ints[2] == std::numeric_limits<int32_t>::min());
+}
+
+static void rejectsPayloadsThatDoNotFit()
+{
+    DecoderSchema schema;
+    schema.fields = { field(FieldType::UInt16) };
+    schema.repeat = { field(FieldType::UInt8), field(FieldType::UInt8) };
+    auto decoder = PayloadDecoder::Compile(schema);
+    DecodedValues values;
+    std::vector<uint8_t> payload = { 1, 2, 3 };
+    // too short for the fields
+    CHECK(!decoder->Decode(payload.data(), 1, values));
+    // ends within a repeated group
+    CHECK(!decoder->Decode(payload.data(), 3, values));
+    CHECK(values.floats.empty());
+}
+
+static void rejectsSchemasWithoutValues()
+{
+    DecoderSchema empty;
+    CHECK(!PayloadDecoder::Compile(empty));
+    DecoderSchema skipping;
+    skipping.fields = { skip(4) };
+    CHECK(!PayloadDecoder::Compile(skipping));
+    DecoderSchema emptyGroup;
+    emptyGroup.fields = { field(FieldType::UInt8) };
+    emptyGroup.repeat = { skip(0) };
+    CHECK(!PayloadDecoder::Compile(emptyGroup));
+}
+
+int main()
+{
+    decodesEveryType();
+    scalesAndSkips();
+    decodesRepeatedGroups();
+    appendsToTheValues();
+    roundsAndClampsInts();
+    rejectsPayloadsThatDoNotFit();
+    rejectsSchemasWithoutValues();
+    return checkResult();
+}
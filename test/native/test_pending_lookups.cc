@@ -0,0 +1,106 @@
+#include "pending_lookups.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "check.h"
+
+static void concurrentRequestsShareOneLookup()
+{
+    PendingLookups<int, std::string> lookups;
+    int started = 0;
+    int completed = 0;
+    for (int i = 0; i < 5; i++)
+    {
+        bool first = lookups.Add(1, [&](std::optional<std::string> value) {
+            CHECK(value && *value == "service");
+            completed++;
+        });
+        started += first ? 1 : 0;
+    }
+    CHECK(started == 1);
+    CHECK(completed == 0);
+    lookups.Complete(1, std::string("service"));
+    CHECK(completed == 5);
+
+    // the key can be looked up again once the lookup has completed
+    CHECK(lookups.Add(1, [](std::optional<std::string>) {}));
+}
+
+static void keysAreIndependent()
+{
+    PendingLookups<int, int> lookups;
+    std::optional<int> first;
+    std::optional<int> second;
+    CHECK(lookups.Add(1, [&](std::optional<int> value) { first = value; }));
+    CHECK(lookups.Add(2, [&](std::optional<int> value) { second = value; }));
+    lookups.Complete(2, 20);
+    CHECK(!first);
+    CHECK(second == 20);
+    lookups.Complete(1, std::nullopt);
+    CHECK(!first);
+    // completing a key nobody waits for does nothing
+    lookups.Complete(3, 30);
+}
+
+static void clearFailsEveryWaiter()
+{
+    PendingLookups<int, int> lookups;
+    int failed = 0;
+    lookups.Add(1, [&](std::optional<int> value) { failed += value ? 0 : 1; });
+    lookups.Add(1, [&](std::optional<int> value) { failed += value ? 0 : 1; });
+    lookups.Add(2, [&](std::optional<int> value) { failed += value ? 0 : 1; });
+    lookups.Clear();
+    CHECK(failed == 3);
+}
+
+static void waiterCanLookUpAgainFromItsCallback()
+{
+    PendingLookups<int, int> lookups;
+    bool restarted = false;
+    lookups.Add(1, [&](std::optional<int>) {
+        // the entry is gone before the callbacks run
+        restarted = lookups.Add(1, [](std::optional<int>) {});
+    });
+    lookups.Complete(1, 1);
+    CHECK(restarted);
+}
+
+static void completesFromOtherThreads()
+{
+    PendingLookups<int, int> lookups;
+    std::atomic<int> completed{ 0 };
+    std::vector<int> started;
+    for (int key = 0; key < 8; key++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            if (lookups.Add(key, [&](std::optional<int> value) { completed += *value; }))
+            {
+                started.push_back(key);
+            }
+        }
+    }
+    CHECK(started.size() == 8);
+    std::vector<std::thread> threads;
+    for (int key : started)
+    {
+        threads.emplace_back([&lookups, key]() { lookups.Complete(key, 1); });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    CHECK(completed == 32);
+}
+
+int main()
+{
+    concurrentRequestsShareOneLookup();
+    keysAreIndependent();
+    clearFailsEveryWaiter();
+    waiterCanLookUpAgainFromItsCallback();
+    completesFromOtherThreads();
+    return checkResult();
+}
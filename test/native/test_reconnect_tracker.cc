@@ -0,0 +1,108 @@
+#include "reconnect_tracker.h"
+
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+static ReconnectPolicy policy(int maxAttempts)
+{
+    ReconnectPolicy policy;
+    policy.enabled = true;
+    policy.backoff.maxAttempts = maxAttempts;
+    policy.backoff.initialDelay = 100ms;
+    policy.backoff.maxDelay = 1000ms;
+    policy.backoff.multiplier = 2;
+    policy.backoff.jitter = 0;
+    return policy;
+}
+
+static void disabledByDefault()
+{
+    ReconnectTracker tracker;
+    CHECK(!tracker.GetPolicy().enabled);
+    CHECK(!tracker.Dropped("a", ReconnectTracker::Clock::now()));
+    CHECK(!tracker.IsReconnecting("a"));
+    CHECK(tracker.Stats().drops == 0);
+}
+
+static void retriesWithBackoffUntilGivingUp()
+{
+    ReconnectTracker tracker;
+    tracker.SetPolicy(policy(3));
+    auto delay = tracker.Dropped("a", ReconnectTracker::Clock::now());
+    CHECK(delay == 100ms);
+    CHECK(tracker.IsReconnecting("a"));
+    // a second drop while reconnecting doesn't start over
+    CHECK(!tracker.Dropped("a", ReconnectTracker::Clock::now()));
+
+    std::chrono::milliseconds next(0);
+    CHECK(tracker.Attempt("a"));
+    CHECK(tracker.Failed("a", next) == ReconnectStep::Retry);
+    CHECK(next == 200ms);
+    CHECK(tracker.Attempt("a"));
+    CHECK(tracker.Failed("a", next) == ReconnectStep::Retry);
+    CHECK(next == 400ms);
+    CHECK(tracker.Attempt("a"));
+    CHECK(tracker.Failed("a", next) == ReconnectStep::GiveUp);
+    CHECK(!tracker.IsReconnecting("a"));
+
+    auto stats = tracker.Stats();
+    CHECK(stats.drops == 1);
+    CHECK(stats.attempts == 3);
+    CHECK(stats.exhausted == 1);
+    CHECK(stats.restored == 0);
+}
+
+static void measuresTheLatencyOfRestoredDevices()
+{
+    ReconnectTracker tracker;
+    tracker.SetPolicy(policy(3));
+    auto droppedAt = ReconnectTracker::Clock::now();
+    tracker.Dropped("a", droppedAt);
+    tracker.Dropped("b", droppedAt);
+    CHECK(tracker.Attempt("a"));
+    CHECK(tracker.Restored("a", droppedAt + 1500ms) == 1500ms);
+    CHECK(tracker.Restored("b", droppedAt + 500ms) == 500ms);
+    CHECK(!tracker.Restored("a", droppedAt + 2s));
+
+    auto stats = tracker.Stats();
+    CHECK(stats.restored == 2);
+    CHECK(stats.totalLatency == 2000ms);
+    CHECK(stats.maxLatency == 1500ms);
+}
+
+static void cancelledDevicesStopReconnecting()
+{
+    ReconnectTracker tracker;
+    tracker.SetPolicy(policy(5));
+    tracker.Dropped("a", ReconnectTracker::Clock::now());
+    CHECK(tracker.Cancel("a"));
+    CHECK(!tracker.Cancel("a"));
+    // an attempt that was scheduled before finds the device gone
+    CHECK(!tracker.Attempt("a"));
+    std::chrono::milliseconds next(0);
+    CHECK(tracker.Failed("a", next) == ReconnectStep::Stopped);
+    CHECK(!tracker.Restored("a", ReconnectTracker::Clock::now()));
+    // the device can drop and reconnect again
+    CHECK(tracker.Dropped("a", ReconnectTracker::Clock::now()));
+}
+
+static void defaultBackoffIsJittered()
+{
+    ReconnectTracker tracker;
+    auto enabled = tracker.GetPolicy();
+    enabled.enabled = true;
+    tracker.SetPolicy(enabled);
+    auto delay = tracker.Dropped("a", ReconnectTracker::Clock::now());
+    CHECK(delay && *delay <= 500ms && *delay >= 400ms);
+}
+
+int main()
+{
+    disabledByDefault();
+    retriesWithBackoffUntilGivingUp();
+    measuresTheLatencyOfRestoredDevices();
+    cancelledDevicesStopReconnecting();
+    defaultBackoffIsJittered();
+    return checkResult();
+}
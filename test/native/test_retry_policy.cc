@@ -0,0 +1,101 @@
+#include "retry_policy.h"
+
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+static void delayGrowsExponentiallyUpToTheMaximum()
+{
+    RetryPolicy policy;
+    policy.initialDelay = 50ms;
+    policy.maxDelay = 300ms;
+    policy.multiplier = 2;
+    CHECK(policy.Delay(1, 0) == 50ms);
+    CHECK(policy.Delay(2, 0) == 100ms);
+    CHECK(policy.Delay(3, 0) == 200ms);
+    CHECK(policy.Delay(4, 0) == 300ms);
+    CHECK(policy.Delay(20, 0) == 300ms);
+    CHECK(policy.Delay(0, 0) == 50ms);
+}
+
+static void jitterShortensTheDelay()
+{
+    RetryPolicy policy;
+    policy.initialDelay = 100ms;
+    policy.jitter = 0.5;
+    CHECK(policy.Delay(1, 0.5) == 75ms);
+    CHECK(policy.Delay(1, 0.999) >= 50ms);
+    policy.jitter = 2;
+    // a jitter above 1 is clamped, the delay never becomes negative
+    CHECK(policy.Delay(1, 0.999) >= 0ms);
+    policy.jitter = 0;
+    CHECK(policy.Delay(1, 0.999) == 100ms);
+}
+
+static void retriesRetryableStatusesUntilExhausted()
+{
+    RetryPolicies policies;
+    CHECK(policies.Next(OperationClass::Read, 1, OperationStatus::Unreachable).has_value());
+    CHECK(policies.Next(OperationClass::Read, 2, OperationStatus::ProtocolError).has_value());
+    CHECK(!policies.Next(OperationClass::Read, 3, OperationStatus::Unreachable));
+    // not retryable
+    CHECK(!policies.Next(OperationClass::Read, 1, OperationStatus::AccessDenied));
+    CHECK(!policies.Next(OperationClass::Read, 1, OperationStatus::Timeout));
+
+    auto stats = policies.Stats()[static_cast<int>(OperationClass::Read)];
+    CHECK(stats.retries == 2);
+    CHECK(stats.operations == 3);
+    CHECK(stats.exhausted == 1);
+    CHECK(stats.recovered == 0);
+}
+
+static void countsRecoveredOperations()
+{
+    RetryPolicies policies;
+    CHECK(policies.Next(OperationClass::Discovery, 1, OperationStatus::Unreachable));
+    CHECK(!policies.Next(OperationClass::Discovery, 2, OperationStatus::Success));
+    CHECK(!policies.Next(OperationClass::Discovery, 1, OperationStatus::Success));
+    auto stats = policies.Stats()[static_cast<int>(OperationClass::Discovery)];
+    CHECK(stats.operations == 2);
+    CHECK(stats.retries == 1);
+    CHECK(stats.recovered == 1);
+    // the other classes are counted separately
+    CHECK(policies.Stats()[static_cast<int>(OperationClass::Read)].operations == 0);
+}
+
+static void writesOnlyRetryWhenTheyNeverReachedTheDevice()
+{
+    RetryPolicies policies;
+    CHECK(policies.Next(OperationClass::Write, 1, OperationStatus::Unreachable));
+    CHECK(!policies.Next(OperationClass::Write, 1, OperationStatus::ProtocolError));
+}
+
+static void policiesCanBeReplaced()
+{
+    RetryPolicies policies;
+    RetryPolicy policy;
+    policy.maxAttempts = 1;
+    policies.Set(OperationClass::Notify, policy);
+    CHECK(policies.Get(OperationClass::Notify).maxAttempts == 1);
+    CHECK(!policies.Next(OperationClass::Notify, 1, OperationStatus::Unreachable));
+
+    policy.maxAttempts = 5;
+    policy.initialDelay = 10ms;
+    policy.maxDelay = 10ms;
+    policy.retryable = { OperationStatus::Timeout };
+    policies.Set(OperationClass::Notify, policy);
+    auto delay = policies.Next(OperationClass::Notify, 4, OperationStatus::Timeout);
+    CHECK(delay && *delay >= 5ms && *delay <= 10ms);
+    CHECK(!policies.Next(OperationClass::Notify, 1, OperationStatus::Unreachable));
+}
+
+int main()
+{
+    delayGrowsExponentiallyUpToTheMaximum();
+    jitterShortensTheDelay();
+    retriesRetryableStatusesUntilExhausted();
+    countsRecoveredOperations();
+    writesOnlyRetryWhenTheyNeverReachedTheDevice();
+    policiesCanBeReplaced();
+    return checkResult();
+}
@@ -0,0 +1,172 @@
+#include "stream_writer.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+
+#include "check.h"
+
+static Payload bytes(size_t size)
+{
+    std::vector<uint8_t> data(size);
+    std::iota(data.begin(), data.end(), 0);
+    return Payload(std::move(data));
+}
+
+// keeps the written chunks in flight until they are finished
+struct Link
+{
+    std::vector<uint8_t> received;
+    std::vector<StreamWriter::ChunkDone> inFlight;
+    size_t maxInFlight = 0;
+
+    StreamWriter::WriteChunk Writer()
+    {
+        return [this](const uint8_t* data, size_t size, StreamWriter::ChunkDone done) {
+            received.insert(received.end(), data, data + size);
+            inFlight.push_back(done);
+            maxInFlight = std::max(maxInFlight, inFlight.size());
+        };
+    }
+
+    void Finish(bool success = true)
+    {
+        auto done = inFlight.front();
+        inFlight.erase(inFlight.begin());
+        done(success);
+    }
+};
+
+static void keepsTheWindowFull()
+{
+    Link link;
+    int finished = 0;
+    bool succeeded = false;
+    std::vector<size_t> reported;
+    auto writer = StreamWriter::Create(
+        bytes(1000), 20, 4, link.Writer(),
+        [&](const StreamProgress& progress) { reported.push_back(progress.sent); },
+        [&](bool success, const StreamProgress& progress) {
+            finished++;
+            succeeded = success && progress.sent == 1000 && progress.total == 1000;
+        });
+    writer->Start();
+    CHECK(link.inFlight.size() == 4);
+    while (!link.inFlight.empty())
+    {
+        link.Finish();
+    }
+    CHECK(finished == 1);
+    CHECK(succeeded);
+    CHECK(link.maxInFlight == 4);
+    CHECK(link.received.size() == 1000);
+    CHECK(link.received[999] == static_cast<uint8_t>(999));
+    // about every 5%, the last chunk reports through done instead
+    CHECK(reported.size() == 19);
+    CHECK(std::is_sorted(reported.begin(), reported.end()));
+}
+
+static void synchronousWritesDoNotRecurse()
+{
+    size_t chunks = 0;
+    bool succeeded = false;
+    auto writer = StreamWriter::Create(
+        bytes(10000), 1, 2,
+        [&](const uint8_t*, size_t, StreamWriter::ChunkDone done) {
+            chunks++;
+            done(true);
+        },
+        [](const StreamProgress&) {},
+        [&](bool success, const StreamProgress&) { succeeded = success; });
+    writer->Start();
+    CHECK(chunks == 10000);
+    CHECK(succeeded);
+}
+
+static void failedChunkFailsTheStream()
+{
+    Link link;
+    int finished = 0;
+    bool succeeded = true;
+    auto writer = StreamWriter::Create(
+        bytes(100), 10, 3, link.Writer(), [](const StreamProgress&) {},
+        [&](bool success, const StreamProgress&) {
+            finished++;
+            succeeded = success;
+        });
+    writer->Start();
+    link.Finish(false);
+    // no further chunk is written, done waits for the chunks in flight
+    CHECK(link.inFlight.size() == 2);
+    CHECK(finished == 0);
+    link.Finish();
+    link.Finish();
+    CHECK(finished == 1);
+    CHECK(!succeeded);
+    CHECK(link.received.size() == 30);
+}
+
+static void throwingWriteFailsTheStream()
+{
+    int written = 0;
+    int finished = 0;
+    bool succeeded = true;
+    auto writer = StreamWriter::Create(
+        bytes(100), 10, 1,
+        [&](const uint8_t*, size_t, StreamWriter::ChunkDone done) {
+            if (++written == 3)
+            {
+                throw std::runtime_error("device closed");
+            }
+            done(true);
+        },
+        [](const StreamProgress&) {},
+        [&](bool success, const StreamProgress& progress) {
+            finished++;
+            succeeded = success || progress.sent != 20;
+        });
+    writer->Start();
+    CHECK(written == 3);
+    CHECK(finished == 1);
+    CHECK(!succeeded);
+}
+
+static void cancelStopsWriting()
+{
+    Link link;
+    bool succeeded = true;
+    auto writer = StreamWriter::Create(
+        bytes(100), 10, 2, link.Writer(), [](const StreamProgress&) {},
+        [&](bool success, const StreamProgress&) { succeeded = success; });
+    writer->Start();
+    writer->Cancel();
+    link.Finish();
+    link.Finish();
+    CHECK(link.inFlight.empty());
+    CHECK(link.received.size() == 20);
+    CHECK(!succeeded);
+}
+
+static void emptyPayloadSucceedsRightAway()
+{
+    bool succeeded = false;
+    auto writer = StreamWriter::Create(
+        Payload(), 10, 2,
+        [](const uint8_t*, size_t, StreamWriter::ChunkDone) { CHECK(false); },
+        [](const StreamProgress&) {},
+        [&](bool success, const StreamProgress&) { succeeded = success; });
+    writer->Start();
+    CHECK(succeeded);
+}
+
+int main()
+{
+    keepsTheWindowFull();
+    synchronousWritesDoNotRecurse();
+    failedChunkFailsTheStream();
+    throwingWriteFailsTheStream();
+    cancelStopsWriting();
+    emptyPayloadSucceedsRightAway();
+    return checkResult();
+}
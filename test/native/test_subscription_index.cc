@@ -0,0 +1,112 @@
+#include "subscription_index.h"
+
+#include <memory>
+
+#include "check.h"
+
+using Index = SubscriptionIndex<int, std::string>;
+
+static void addsAndFindsPerDevice()
+{
+    Index index;
+    CHECK(index.Add("a", 3, "a3"));
+    CHECK(index.Add("a", 1, "a1"));
+    CHECK(index.Add("b", 1, "b1"));
+    CHECK(index.Size() == 3);
+    CHECK(index.Find("a", 1) && *index.Find("a", 1) == "a1");
+    CHECK(index.Find("b", 1) && *index.Find("b", 1) == "b1");
+    CHECK(!index.Find("a", 2));
+    CHECK(!index.Find("c", 1));
+}
+
+static void keepsTheFirstRecordOfAKey()
+{
+    Index index;
+    CHECK(index.Add("a", 1, "first"));
+    CHECK(!index.Add("a", 1, "second"));
+    CHECK(index.Size() == 1);
+    CHECK(*index.Find("a", 1) == "first");
+}
+
+static void removesSingleSubscriptions()
+{
+    Index index;
+    index.Add("a", 1, "a1");
+    index.Add("a", 2, "a2");
+    CHECK(index.Remove("a", 1) == std::string("a1"));
+    CHECK(!index.Remove("a", 1));
+    CHECK(!index.Remove("b", 1));
+    CHECK(index.Size() == 1);
+    CHECK(index.Remove("a", 2) == std::string("a2"));
+    CHECK(index.Size() == 0);
+    // the device is gone with its last subscription
+    int devices = 0;
+    index.ForEach([&](const std::string&, int, std::string&) { devices++; });
+    CHECK(devices == 0);
+}
+
+static void removesADevice()
+{
+    Index index;
+    index.Add("a", 2, "a2");
+    index.Add("a", 1, "a1");
+    index.Add("b", 1, "b1");
+    auto removed = index.Remove("a");
+    CHECK(removed.size() == 2);
+    // sorted by key
+    CHECK(removed[0].first == 1 && removed[1].first == 2);
+    CHECK(index.Size() == 1);
+    CHECK(!index.Find("a", 1));
+    CHECK(index.Remove("a").empty());
+}
+
+static void visitsInKeyOrder()
+{
+    Index index;
+    for (int key : { 5, 3, 9, 1, 7 })
+    {
+        index.Add("a", key, std::to_string(key));
+    }
+    index.Add("b", 4, "4");
+    std::vector<int> keys;
+    index.ForEach("a", [&](int key, std::string& record) {
+        keys.push_back(key);
+        record += "!";
+    });
+    CHECK((keys == std::vector<int>{ 1, 3, 5, 7, 9 }));
+    CHECK(*index.Find("a", 5) == "5!");
+    int all = 0;
+    index.ForEach([&](const std::string&, int, std::string&) { all++; });
+    CHECK(all == 6);
+    index.ForEach("c", [&](int, std::string&) { CHECK(false); });
+}
+
+struct ByName
+{
+    bool operator()(const std::pair<std::string, int>& a,
+                    const std::pair<std::string, int>& b) const
+    {
+        return a.first < b.first;
+    }
+};
+
+static void usesTheGivenOrder()
+{
+    // only the name is part of the key for this order
+    SubscriptionIndex<std::pair<std::string, int>, std::unique_ptr<int>, ByName> index;
+    CHECK(index.Add("a", { "x", 1 }, std::make_unique<int>(1)));
+    CHECK(!index.Add("a", { "x", 2 }, std::make_unique<int>(2)));
+    auto record = index.Remove("a", { "x", 3 });
+    CHECK(record && **record == 1);
+}
+
+int main()
+{
+    addsAndFindsPerDevice();
+    keepsTheFirstRecordOfAKey();
+    removesSingleSubscriptions();
+    removesADevice();
+    visitsInKeyOrder();
+    usesTheGivenOrder();
+    return checkResult();
+}
@@ -0,0 +1,138 @@
+#include "task.h"
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "check.h"
+
+using Callback = std::function<void(int)>;
+
+// stands in for an async WinRT operation that is completed later
+struct Pending
+{
+    std::function<void(int)> complete;
+
+    auto Value()
+    {
+        return awaitCallback<int>([this](Callback callback) { complete = callback; });
+    }
+};
+
+static Task<int> immediate(int value)
+{
+    co_return value;
+}
+
+static Task<int> sum(int a, int b)
+{
+    int first = co_await immediate(a);
+    int second = co_await immediate(b);
+    co_return first + second;
+}
+
+static Task<std::string> failing()
+{
+    co_await immediate(0);
+    throw std::runtime_error("failed");
+}
+
+static Task<std::string> recovering()
+{
+    try
+    {
+        co_return co_await failing();
+    }
+    catch (const std::runtime_error& error)
+    {
+        co_return std::string("recovered from ") + error.what();
+    }
+}
+
+static Task<int> waitFor(Pending& pending)
+{
+    int value = co_await pending.Value();
+    co_return value * 2;
+}
+
+static Task<std::unique_ptr<int>> moveOnly()
+{
+    co_return std::make_unique<int>(7);
+}
+
+static void tasksProduceTheirValue()
+{
+    int result = 0;
+    startTask(sum(1, 2), [&](int value) { result = value; });
+    CHECK(result == 3);
+
+    int moved = 0;
+    startTask(moveOnly(), [&](std::unique_ptr<int> value) { moved = *value; });
+    CHECK(moved == 7);
+}
+
+static void exceptionsReachTheAwaiter()
+{
+    std::string result;
+    startTask(recovering(), [&](std::string value) { result = value; });
+    CHECK(result == "recovered from failed");
+}
+
+static void tasksAreStartedWhenAwaited()
+{
+    Pending pending;
+    {
+        auto task = waitFor(pending);
+        // a task that is never awaited never runs and is destroyed with its handle
+        CHECK(!pending.complete);
+    }
+    int result = 0;
+    startTask(waitFor(pending), [&](int value) { result = value; });
+    CHECK(pending.complete);
+    CHECK(result == 0);
+    pending.complete(21);
+    CHECK(result == 42);
+}
+
+static void callbacksMayCompleteBeforeStartReturns()
+{
+    int result = 0;
+    auto synchronous = []() -> Task<int> {
+        co_return co_await awaitCallback<int>([](Callback callback) { callback(5); });
+    };
+    startTask(synchronous(), [&](int value) { result = value; });
+    CHECK(result == 5);
+}
+
+static void resumesOnTheCompletingThread()
+{
+    Pending pending;
+    std::thread::id resumedOn;
+    auto task = [&]() -> Task<int> {
+        int value = co_await pending.Value();
+        resumedOn = std::this_thread::get_id();
+        co_return value;
+    };
+    int result = 0;
+    startTask(task(), [&](int value) { result = value; });
+    std::thread::id completedOn;
+    std::thread thread([&]() {
+        completedOn = std::this_thread::get_id();
+        pending.complete(1);
+    });
+    thread.join();
+    CHECK(result == 1);
+    CHECK(resumedOn == completedOn);
+}
+
+int main()
+{
+    tasksProduceTheirValue();
+    exceptionsReachTheAwaiter();
+    tasksAreStartedWhenAwaited();
+    callbacksMayCompleteBeforeStartReturns();
+    resumesOnTheCompletingThread();
+    return checkResult();
+}
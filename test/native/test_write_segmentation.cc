@@ -0,0 +1,60 @@
+#include "write_segmentation.h"
+
+#include "check.h"
+
+static void payloadSizes()
+{
+    CHECK(maxWritePayload(23) == 20);
+    CHECK(maxPreparePayload(23) == 18);
+    CHECK(maxWritePayload(247) == 244);
+    CHECK(maxPreparePayload(247) == 242);
+    // an MTU below the minimum, e.g. one that hasn't been negotiated yet, counts as the default
+    CHECK(maxWritePayload(0) == 20);
+    CHECK(maxPreparePayload(0) == 18);
+}
+
+static void shortValuesAreWrittenAtOnce()
+{
+    auto plan = planWrite(20, 23, false, true);
+    CHECK(plan.mode == WriteMode::Single);
+    CHECK(plan.segmentSize == 20);
+
+    plan = planWrite(0, 23, true, false);
+    CHECK(plan.mode == WriteMode::Single);
+    CHECK(plan.segmentSize == 0);
+}
+
+static void longValuesAreQueuedWhenPossible()
+{
+    auto plan = planWrite(100, 23, false, true);
+    CHECK(plan.mode == WriteMode::Queued);
+    // prepare write requests carry an offset as well
+    CHECK(plan.segmentSize == 18);
+    plan = planWrite(1000, 247, false, true);
+    CHECK(plan.mode == WriteMode::Queued && plan.segmentSize == 242);
+}
+
+static void longValuesAreSegmentedOtherwise()
+{
+    // without response
+    auto plan = planWrite(100, 23, true, true);
+    CHECK(plan.mode == WriteMode::Segmented);
+    CHECK(plan.segmentSize == 20);
+
+    // the characteristic can't be written with response
+    plan = planWrite(1000, 247, false, false);
+    CHECK(plan.mode == WriteMode::Segmented);
+    CHECK(plan.segmentSize == 244);
+    // one byte more than a single write carries
+    plan = planWrite(245, 247, true, false);
+    CHECK(plan.mode == WriteMode::Segmented);
+}
+
+int main()
+{
+    payloadSizes();
+    shortValuesAreWrittenAtOnce();
+    longValuesAreQueuedWhenPossible();
+    longValuesAreSegmentedOtherwise();
+    return checkResult();
+}